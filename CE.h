@@ -8,6 +8,17 @@ extern "C" {
 #include "ce-instance.h"
 #include "ce-command.h"
 #include "ce-pipeline.h"
+#include "ce-buffer.h"
+#include "ce-graph.h"
+#include "ce-trace.h"
+#include "ce-transfer.h"
+#include "ce-shard.h"
+#include "ce-autotune.h"
+#include "ce-stream.h"
+#include "ce-primitives.h"
+#include "ce-sort.h"
+#include "ce-cpu.h"
+#include "ce-executable.h"
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,129 @@
+#include "../CE.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+//stages of the workflow, each a tiny dispatch so that the host's cost dominates
+#define STAGE_COUNT 64
+#define LAUNCHES 2000
+#define LOCAL_SIZE 64
+
+static CeBool32 firstResult = CE_TRUE;
+
+static double __now() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec * 1e-9;
+}
+
+static void __printResult(const char* benchmark, const char* variant, const char* unit, double value) {
+    printf("%s  {\"benchmark\": \"%s\", \"variant\": \"%s\", \"unit\": \"%s\", \"value\": %.3f}",
+        firstResult ? "" : ",\n", benchmark, variant, unit, value);
+    firstResult = CE_FALSE;
+}
+
+static CeResult __recordStages(CeCommand command, CePipeline pipeline) {
+    CeCommandRecordingArgs recordArgs = {
+        .pSuppliedPipeline = pipeline,
+    };
+    CeResult result = ceBeginCommand(command);
+    for(uint32_t i = 0; i < STAGE_COUNT && result == CE_SUCCESS; ++i)
+        result = ceRecordToCommand(&recordArgs, command);
+    return result == CE_SUCCESS ? ceEndCommand(command) : result;
+}
+
+//the host time of a run of the workflow recorded again every time, as it has to be without executables
+static CeBool32 __benchRerecord(CeInstance instance, CePipeline pipeline) {
+    CeCommandCreationArgs commandArgs = {0};
+    CeCommand command;
+    if(ceCreateCommand(instance, &commandArgs, &command) != CE_SUCCESS)
+        return CE_FALSE;
+    double hostTime = 0.0;
+    const double begin = __now();
+    for(uint32_t i = 0; i < LAUNCHES; ++i) {
+        const double hostBegin = __now();
+        if(ceResetCommand(command) != CE_SUCCESS || __recordStages(command, pipeline) != CE_SUCCESS ||
+            ceRunCommand(instance, command) != CE_SUCCESS)
+            return CE_FALSE;
+        hostTime += __now() - hostBegin;
+        if(ceWaitCommand(instance, command) != CE_SUCCESS)
+            return CE_FALSE;
+    }
+    const double seconds = __now() - begin;
+    __printResult("workflow_host_time", "rerecord", "us", hostTime / LAUNCHES * 1e6);
+    __printResult("workflow_rate", "rerecord", "runs/s", LAUNCHES / seconds);
+    ceDestroyCommand(instance, command);
+    return CE_TRUE;
+}
+
+static CeBool32 __benchExecutable(CeInstance instance, CePipeline pipeline) {
+    CeCommandCreationArgs commandArgs = {0};
+    CeCommand command;
+    if(ceCreateCommand(instance, &commandArgs, &command) != CE_SUCCESS || __recordStages(command, pipeline) != CE_SUCCESS)
+        return CE_FALSE;
+    CeExecutableCreationArgs executableArgs = {
+        .pCommand = command,
+    };
+    CeExecutable executable;
+    if(ceCreateExecutable(instance, &executableArgs, &executable) != CE_SUCCESS)
+        return CE_FALSE;
+    ceDestroyCommand(instance, command);
+
+    double hostTime = 0.0;
+    double begin = __now();
+    for(uint32_t i = 0; i < LAUNCHES; ++i) {
+        const double hostBegin = __now();
+        if(ceLaunchExecutable(instance, executable) != CE_SUCCESS)
+            return CE_FALSE;
+        hostTime += __now() - hostBegin;
+        if(ceWaitExecutable(instance, executable) != CE_SUCCESS)
+            return CE_FALSE;
+    }
+    double seconds = __now() - begin;
+    __printResult("workflow_host_time", "executable", "us", hostTime / LAUNCHES * 1e6);
+    __printResult("workflow_rate", "executable", "runs/s", LAUNCHES / seconds);
+
+    //launched back to back, the host only waits when every slot is busy
+    begin = __now();
+    for(uint32_t i = 0; i < LAUNCHES; ++i) {
+        if(ceLaunchExecutable(instance, executable) != CE_SUCCESS)
+            return CE_FALSE;
+    }
+    if(ceWaitExecutable(instance, executable) != CE_SUCCESS)
+        return CE_FALSE;
+    seconds = __now() - begin;
+    __printResult("workflow_rate", "executable_pipelined", "runs/s", LAUNCHES / seconds);
+    ceDestroyExecutable(instance, executable);
+    return CE_TRUE;
+}
+
+int main(int argc, char** argv) {
+    const char* shaderFilename = argc > 1 ? argv[1] : "build/bench/increment.spv";
+    CeInstanceCreationArgs instanceArgs = {
+        .pApplicationName = "ce-bench-executable",
+    };
+    CeInstance instance;
+    if(ceCreateInstance(&instanceArgs, &instance) != CE_SUCCESS)
+        return 1;
+    CePipelineBindingInfo binding = {
+        .uElementSize = sizeof(uint32_t),
+        .uElementCount = LOCAL_SIZE,
+        .eAccess = CE_BINDING_ACCESS_READ_WRITE,
+    };
+    CePipelineCreationArgs pipelineArgs = {
+        .pShaderFilename = shaderFilename,
+        .pBindings = &binding,
+        .uBindingCount = 1,
+        .uDispatchGroupCount = 1,
+    };
+    CePipeline pipeline;
+    if(ceCreatePipeline(instance, &pipelineArgs, &pipeline) != CE_SUCCESS)
+        return 1;
+    printf("[\n");
+    const CeBool32 passed = __benchRerecord(instance, pipeline) && __benchExecutable(instance, pipeline);
+    printf("\n]\n");
+    ceDestroyPipeline(instance, pipeline);
+    ceDestroyInstance(instance);
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,257 @@
+#include "../CE.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+//not a multiple of the primitives' tile size, so the partial last tile is checked too
+#define ELEMENT_COUNT ((1u << 22) + 123)
+#define RUNS 5
+
+static CeBool32 firstResult = CE_TRUE;
+
+static double __now() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec * 1e-9;
+}
+
+static void __printResult(const char* benchmark, const char* variant, const char* unit, double value) {
+    printf("%s  {\"benchmark\": \"%s\", \"variant\": \"%s\", \"unit\": \"%s\", \"value\": %.3f}",
+        firstResult ? "" : ",\n", benchmark, variant, unit, value);
+    firstResult = CE_FALSE;
+}
+
+//throughput of the fastest of RUNS runs, in millions of elements per second
+static void __printThroughput(const char* benchmark, const char* variant, double fastest) {
+    __printResult(benchmark, variant, "Melements/s", ELEMENT_COUNT / fastest * 1e-6);
+}
+
+static CeResult __createBuffer(CeInstance instance, void* data, CeBuffer* buffer) {
+    CeBufferCreationArgs bufferArgs = {
+        .uElementSize = sizeof(uint32_t),
+        .uElementCount = ELEMENT_COUNT,
+        .pInitialData = data,
+        .ePlacement = CE_BINDING_PLACEMENT_DEVICE_LOCAL,
+    };
+    return ceCreateBuffer(instance, &bufferArgs, buffer);
+}
+
+static CeResult __download(CeInstance instance, CeBuffer buffer, void* data, uint64_t size) {
+    CeTransfer transfer;
+    CeResult result = ceDownloadBufferAsync(instance, buffer, 0, data, size, NULL, &transfer);
+    if(result != CE_SUCCESS)
+        return result;
+    result = ceWaitTransfer(instance, transfer);
+    ceDestroyTransfer(instance, transfer);
+    return result;
+}
+
+//a command the primitive is recorded to between this and __timeCommand
+static CeResult __beginCommand(CeInstance instance, CeCommand* command) {
+    CeCommandCreationArgs commandArgs = {
+        .bIsSecondaryCommand = CE_FALSE,
+    };
+    CeResult result = ceCreateCommand(instance, &commandArgs, command);
+    return result == CE_SUCCESS ? ceBeginCommand(*command) : result;
+}
+
+//the fastest of RUNS runs of the recorded command, in seconds, or a negative value on failure.
+//the primitive's pipelines and scratch buffers were created beforehand, so only the dispatches are timed
+static double __timeCommand(CeInstance instance, CeCommand command) {
+    if(ceEndCommand(command) != CE_SUCCESS)
+        return -1.0;
+    double fastest = 1e30;
+    for(uint32_t run = 0; run < RUNS; ++run) {
+        const double begin = __now();
+        if(ceRunCommand(instance, command) != CE_SUCCESS || ceWaitCommand(instance, command) != CE_SUCCESS)
+            return -1.0;
+        const double time = __now() - begin;
+        fastest = time < fastest ? time : fastest;
+    }
+    return fastest;
+}
+
+static CeBool32 __reportMismatch(const char* benchmark, uint64_t index) {
+    fprintf(stderr, "%s: the GPU and CPU results differ at element %llu\n", benchmark, (unsigned long long)index);
+    return CE_FALSE;
+}
+
+static CeBool32 __benchReduce(CeInstance instance, CeBuffer uints, CeBuffer floats, const uint32_t* uintData, const float* floatData) {
+    uint32_t gpuSum, gpuMin;
+    float gpuMax;
+    CeReduceCreationArgs reduceArgs = {
+        .pInput = uints,
+        .eType = CE_PRIMITIVE_TYPE_UINT32,
+        .eOperation = CE_PRIMITIVE_OPERATION_SUM,
+    };
+    CeReduce reduce;
+    CeCommand command;
+    if(ceCreateReduce(instance, &reduceArgs, &reduce) != CE_SUCCESS || __beginCommand(instance, &command) != CE_SUCCESS ||
+        ceRecordReduceToCommand(reduce, command) != CE_SUCCESS)
+        return CE_FALSE;
+    double fastest = __timeCommand(instance, command);
+    if(fastest < 0.0 || __download(instance, ceGetReduceResultBuffer(reduce), &gpuSum, sizeof(gpuSum)) != CE_SUCCESS)
+        return CE_FALSE;
+    ceDestroyCommand(instance, command);
+    ceDestroyReduce(instance, reduce);
+    __printThroughput("reduce_sum_uint32", "gpu", fastest);
+    //the one-shot functions are checked too
+    if(ceReduceBuffer(instance, uints, CE_PRIMITIVE_TYPE_INT32, CE_PRIMITIVE_OPERATION_MIN, &gpuMin) != CE_SUCCESS ||
+        ceReduceBuffer(instance, floats, CE_PRIMITIVE_TYPE_FLOAT32, CE_PRIMITIVE_OPERATION_MAX, &gpuMax) != CE_SUCCESS)
+        return CE_FALSE;
+
+    uint32_t cpuSum = 0;
+    int32_t cpuMin = INT32_MAX;
+    float cpuMax = -INFINITY;
+    fastest = 1e30;
+    for(uint32_t run = 0; run < RUNS; ++run) {
+        const double begin = __now();
+        cpuSum = 0;
+        for(uint32_t i = 0; i < ELEMENT_COUNT; ++i)
+            cpuSum += uintData[i];
+        const double time = __now() - begin;
+        fastest = time < fastest ? time : fastest;
+    }
+    __printThroughput("reduce_sum_uint32", "cpu", fastest);
+    for(uint32_t i = 0; i < ELEMENT_COUNT; ++i) {
+        cpuMin = (int32_t)uintData[i] < cpuMin ? (int32_t)uintData[i] : cpuMin;
+        cpuMax = floatData[i] > cpuMax ? floatData[i] : cpuMax;
+    }
+    if(gpuSum != cpuSum || (int32_t)gpuMin != cpuMin || gpuMax != cpuMax)
+        return __reportMismatch("reduce", 0);
+    return CE_TRUE;
+}
+
+static CeBool32 __benchScan(CeInstance instance, CeBuffer input, CeBuffer output, const uint32_t* data, uint32_t* expected) {
+    const CeBool32 inclusiveModes[2] = {CE_FALSE, CE_TRUE};
+    const char* names[2] = {"scan_exclusive_sum_uint32", "scan_inclusive_sum_uint32"};
+    for(uint32_t mode = 0; mode < 2; ++mode) {
+        CeScanCreationArgs scanArgs = {
+            .pInput = input,
+            .pOutput = output,
+            .eType = CE_PRIMITIVE_TYPE_UINT32,
+            .eOperation = CE_PRIMITIVE_OPERATION_SUM,
+            .bInclusive = inclusiveModes[mode],
+        };
+        CeScan scan;
+        CeCommand command;
+        if(ceCreateScan(instance, &scanArgs, &scan) != CE_SUCCESS || __beginCommand(instance, &command) != CE_SUCCESS ||
+            ceRecordScanToCommand(scan, command) != CE_SUCCESS)
+            return CE_FALSE;
+        double fastest = __timeCommand(instance, command);
+        ceDestroyCommand(instance, command);
+        ceDestroyScan(instance, scan);
+        if(fastest < 0.0)
+            return CE_FALSE;
+        __printThroughput(names[mode], "gpu", fastest);
+        fastest = 1e30;
+        for(uint32_t run = 0; run < RUNS; ++run) {
+            const double begin = __now();
+            uint32_t sum = 0;
+            for(uint32_t i = 0; i < ELEMENT_COUNT; ++i) {
+                if(inclusiveModes[mode])
+                    sum += data[i];
+                expected[i] = sum;
+                if(!inclusiveModes[mode])
+                    sum += data[i];
+            }
+            const double time = __now() - begin;
+            fastest = time < fastest ? time : fastest;
+        }
+        __printThroughput(names[mode], "cpu", fastest);
+        uint32_t* result;
+        if(ceMapBufferMemory(instance, output, (void**)&result) != CE_SUCCESS)
+            return CE_FALSE;
+        for(uint32_t i = 0; i < ELEMENT_COUNT; ++i) {
+            if(result[i] != expected[i]) {
+                ceUnmapBufferMemory(instance, output);
+                return __reportMismatch(names[mode], i);
+            }
+        }
+        ceUnmapBufferMemory(instance, output);
+    }
+    return CE_TRUE;
+}
+
+static CeBool32 __benchCompact(CeInstance instance, CeBuffer input, CeBuffer flags, CeBuffer output,
+    const uint32_t* data, const uint32_t* flagData, uint32_t* expected) {
+    uint32_t keptCount = 0;
+    CeCompactCreationArgs compactArgs = {
+        .pInput = input,
+        .pFlags = flags,
+        .pOutput = output,
+    };
+    CeCompact compact;
+    CeCommand command;
+    if(ceCreateCompact(instance, &compactArgs, &compact) != CE_SUCCESS || __beginCommand(instance, &command) != CE_SUCCESS ||
+        ceRecordCompactToCommand(compact, command) != CE_SUCCESS)
+        return CE_FALSE;
+    double fastest = __timeCommand(instance, command);
+    if(fastest < 0.0 || ceGetCompactKeptCount(instance, compact, &keptCount) != CE_SUCCESS)
+        return CE_FALSE;
+    ceDestroyCommand(instance, command);
+    ceDestroyCompact(instance, compact);
+    __printThroughput("compact_uint32", "gpu", fastest);
+    uint32_t expectedCount = 0;
+    fastest = 1e30;
+    for(uint32_t run = 0; run < RUNS; ++run) {
+        const double begin = __now();
+        expectedCount = 0;
+        for(uint32_t i = 0; i < ELEMENT_COUNT; ++i) {
+            if(flagData[i])
+                expected[expectedCount++] = data[i];
+        }
+        const double time = __now() - begin;
+        fastest = time < fastest ? time : fastest;
+    }
+    __printThroughput("compact_uint32", "cpu", fastest);
+    if(keptCount != expectedCount)
+        return __reportMismatch("compact_uint32 count", keptCount);
+    uint32_t* result;
+    if(ceMapBufferMemory(instance, output, (void**)&result) != CE_SUCCESS)
+        return CE_FALSE;
+    CeBool32 matches = memcmp(result, expected, keptCount * sizeof(uint32_t)) == 0;
+    ceUnmapBufferMemory(instance, output);
+    return matches ? CE_TRUE : __reportMismatch("compact_uint32", 0);
+}
+
+int main(int argc, char** argv) {
+    CeInstanceCreationArgs instanceArgs = {
+        .pApplicationName = "ce-bench-primitives",
+    };
+    CeInstance instance;
+    if(ceCreateInstance(&instanceArgs, &instance) != CE_SUCCESS)
+        return 1;
+    uint32_t* data = malloc(ELEMENT_COUNT * sizeof(uint32_t));
+    uint32_t* flagData = malloc(ELEMENT_COUNT * sizeof(uint32_t));
+    float* floatData = malloc(ELEMENT_COUNT * sizeof(float));
+    uint32_t* expected = malloc(ELEMENT_COUNT * sizeof(uint32_t));
+    srand(1);
+    for(uint32_t i = 0; i < ELEMENT_COUNT; ++i) {
+        data[i] = (uint32_t)rand();
+        flagData[i] = data[i] % 3 == 0 ? data[i] : 0;
+        floatData[i] = (float)rand() / RAND_MAX * 2.f - 1.f;
+    }
+    CeBuffer input, floats, flags, output;
+    if(__createBuffer(instance, data, &input) != CE_SUCCESS || __createBuffer(instance, floatData, &floats) != CE_SUCCESS ||
+        __createBuffer(instance, flagData, &flags) != CE_SUCCESS || __createBuffer(instance, NULL, &output) != CE_SUCCESS)
+        return 1;
+    printf("[\n");
+    const CeBool32 passed = __benchReduce(instance, input, floats, data, floatData) &&
+        __benchScan(instance, input, output, data, expected) &&
+        __benchCompact(instance, input, flags, output, data, flagData, expected);
+    printf("\n]\n");
+    ceDestroyBuffer(instance, input);
+    ceDestroyBuffer(instance, floats);
+    ceDestroyBuffer(instance, flags);
+    ceDestroyBuffer(instance, output);
+    ceDestroyInstance(instance);
+    free(data);
+    free(flagData);
+    free(floatData);
+    free(expected);
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,110 @@
+#include "../CE.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <time.h>
+
+//how many times each thread begins, fills and ends its command
+#define RECORDINGS_PER_THREAD 2000
+//pipelines recorded between each begin and end
+#define PIPELINES_PER_RECORDING 16
+#define MAX_THREADS 16
+
+struct RecordThread {
+    pthread_t thread;
+    CeInstance instance;
+    CePipeline pipeline;
+    CeResult result;
+};
+
+static CeBool32 firstResult = CE_TRUE;
+
+static double __now() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec * 1e-9;
+}
+
+static void __printResult(const char* benchmark, const char* variant, const char* unit, double value) {
+    printf("%s  {\"benchmark\": \"%s\", \"variant\": \"%s\", \"unit\": \"%s\", \"value\": %.3f}",
+        firstResult ? "" : ",\n", benchmark, variant, unit, value);
+    firstResult = CE_FALSE;
+}
+
+static void* __recordThread(void* pThread) {
+    struct RecordThread* thread = pThread;
+    CeCommandCreationArgs commandArgs = {0};
+    CeCommand command;
+    thread->result = ceCreateCommand(thread->instance, &commandArgs, &command);
+    if(thread->result != CE_SUCCESS)
+        return NULL;
+    CeCommandRecordingArgs recordArgs = {
+        .pSuppliedPipeline = thread->pipeline,
+    };
+    for(uint32_t i = 0; i < RECORDINGS_PER_THREAD && thread->result == CE_SUCCESS; ++i) {
+        thread->result = ceBeginCommand(command);
+        for(uint32_t j = 0; j < PIPELINES_PER_RECORDING && thread->result == CE_SUCCESS; ++j)
+            thread->result = ceRecordToCommand(&recordArgs, command);
+        if(thread->result == CE_SUCCESS)
+            thread->result = ceEndCommand(command);
+    }
+    ceDestroyCommand(thread->instance, command);
+    return NULL;
+}
+
+int main(int argc, char** argv) {
+    const char* shaderFilename = argc > 1 ? argv[1] : "build/bench/increment.spv";
+    CeInstanceCreationArgs instanceArgs = {
+        .pApplicationName = "ce-bench-record",
+    };
+    CeInstance instance;
+    if(ceCreateInstance(&instanceArgs, &instance) != CE_SUCCESS)
+        return 1;
+    CePipelineBindingInfo binding = {
+        .uElementSize = sizeof(uint32_t),
+        .uElementCount = 64,
+        .eAccess = CE_BINDING_ACCESS_READ_WRITE,
+    };
+    CePipelineCreationArgs pipelineArgs = {
+        .pShaderFilename = shaderFilename,
+        .pBindings = &binding,
+        .uBindingCount = 1,
+        .uDispatchGroupCount = 1,
+    };
+    CePipeline pipeline;
+    if(ceCreatePipeline(instance, &pipelineArgs, &pipeline) != CE_SUCCESS)
+        return 1;
+
+    struct RecordThread threads[MAX_THREADS];
+    double singleThreadRate = 0.0;
+    printf("[\n");
+    for(uint32_t threadCount = 1; threadCount <= MAX_THREADS; threadCount *= 2) {
+        const double begin = __now();
+        for(uint32_t i = 0; i < threadCount; ++i) {
+            threads[i] = (struct RecordThread){
+                .instance = instance,
+                .pipeline = pipeline,
+            };
+            pthread_create(&threads[i].thread, NULL, __recordThread, &threads[i]);
+        }
+        for(uint32_t i = 0; i < threadCount; ++i) {
+            pthread_join(threads[i].thread, NULL);
+            if(threads[i].result != CE_SUCCESS)
+                return 1;
+        }
+        const double seconds = __now() - begin;
+        const double rate = threadCount * (double)RECORDINGS_PER_THREAD / seconds;
+        if(threadCount == 1)
+            singleThreadRate = rate;
+        char variant[32];
+        snprintf(variant, sizeof(variant), "%u_threads", threadCount);
+        __printResult("record_scaling", variant, "recordings_per_second", rate);
+        snprintf(variant, sizeof(variant), "%u_threads_speedup", threadCount);
+        __printResult("record_scaling", variant, "times_1_thread", rate / singleThreadRate);
+    }
+    printf("\n]\n");
+    ceDestroyPipeline(instance, pipeline);
+    ceDestroyInstance(instance);
+    return 0;
+}
@@ -0,0 +1,267 @@
+#include "../CE.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#define RUNS 3
+//the elements of each segment in the segmented variant
+#define SEGMENT_SIZE 4096
+
+static const uint32_t elementCounts[] = {1000000, 10000000, 100000000};
+static CeBool32 firstResult = CE_TRUE;
+
+static double __now() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec * 1e-9;
+}
+
+static void __printResult(const char* benchmark, const char* variant, const char* unit, double value) {
+    printf("%s  {\"benchmark\": \"%s\", \"variant\": \"%s\", \"unit\": \"%s\", \"value\": %.3f}",
+        firstResult ? "" : ",\n", benchmark, variant, unit, value);
+    firstResult = CE_FALSE;
+}
+
+static int __compareUint32(const void* a, const void* b) {
+    const uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+static int __compareUint64(const void* a, const void* b) {
+    const uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+static CeResult __upload(CeInstance instance, CeBuffer buffer, const void* data, uint64_t size) {
+    CeTransfer transfer;
+    CeResult result = ceUploadBufferAsync(instance, buffer, 0, data, size, NULL, &transfer);
+    if(result != CE_SUCCESS)
+        return result;
+    result = ceWaitTransfer(instance, transfer);
+    ceDestroyTransfer(instance, transfer);
+    return result;
+}
+
+static CeResult __download(CeInstance instance, CeBuffer buffer, void* data, uint64_t size) {
+    CeTransfer transfer;
+    CeResult result = ceDownloadBufferAsync(instance, buffer, 0, data, size, NULL, &transfer);
+    if(result != CE_SUCCESS)
+        return result;
+    result = ceWaitTransfer(instance, transfer);
+    ceDestroyTransfer(instance, transfer);
+    return result;
+}
+
+static CeResult __createBuffer(CeInstance instance, uint32_t elementSize, uint32_t elementCount, const void* data, CeBuffer* buffer) {
+    CeBufferCreationArgs bufferArgs = {
+        .uElementSize = elementSize,
+        .uElementCount = elementCount,
+        .pInitialData = (void*)data,
+        .ePlacement = CE_BINDING_PLACEMENT_DEVICE_LOCAL,
+    };
+    return ceCreateBuffer(instance, &bufferArgs, buffer);
+}
+
+//sorts the keys RUNS times from the same input, and returns the fastest run in seconds or a negative value on failure
+static double __timeSort(CeInstance instance, const CeSortCreationArgs* sortArgs, const void* keys, uint64_t keysSize,
+    const uint32_t* payload, uint32_t elementCount) {
+    CeSort sort;
+    if(ceCreateSort(instance, sortArgs, &sort) != CE_SUCCESS)
+        return -1.0;
+    CeCommandCreationArgs commandArgs = {
+        .bIsSecondaryCommand = CE_FALSE,
+    };
+    CeCommand command;
+    double fastest = -1.0;
+    if(ceCreateCommand(instance, &commandArgs, &command) != CE_SUCCESS) {
+        ceDestroySort(instance, sort);
+        return -1.0;
+    }
+    if(ceBeginCommand(command) == CE_SUCCESS && ceRecordSortToCommand(sort, command) == CE_SUCCESS && ceEndCommand(command) == CE_SUCCESS) {
+        fastest = 1e30;
+        for(uint32_t run = 0; run < RUNS && fastest > 0.0; ++run) {
+            if(__upload(instance, sortArgs->pKeys, keys, keysSize) != CE_SUCCESS ||
+                (payload && __upload(instance, sortArgs->pPayload, payload, (uint64_t)elementCount * sizeof(uint32_t)) != CE_SUCCESS)) {
+                fastest = -1.0;
+                break;
+            }
+            const double begin = __now();
+            if(ceRunCommand(instance, command) != CE_SUCCESS || ceWaitCommand(instance, command) != CE_SUCCESS) {
+                fastest = -1.0;
+                break;
+            }
+            const double time = __now() - begin;
+            fastest = time < fastest ? time : fastest;
+        }
+    }
+    ceDestroyCommand(instance, command);
+    ceDestroySort(instance, sort);
+    return fastest;
+}
+
+static CeBool32 __reportMismatch(const char* benchmark, uint32_t elementCount, uint64_t index) {
+    fprintf(stderr, "%s: wrong result for %u elements at element %llu\n", benchmark, elementCount, (unsigned long long)index);
+    return CE_FALSE;
+}
+
+static CeBool32 __printKeysPerSecond(const char* benchmark, const char* variant, uint32_t elementCount, double time) {
+    if(time < 0.0) {
+        fprintf(stderr, "%s: the sort of %u elements failed\n", benchmark, elementCount);
+        return CE_FALSE;
+    }
+    char name[64];
+    snprintf(name, sizeof(name), "%s_%u", benchmark, elementCount);
+    __printResult(name, variant, "Mkeys/s", elementCount / time * 1e-6);
+    return CE_TRUE;
+}
+
+static CeBool32 __benchUint32(CeInstance instance, uint32_t elementCount, const uint32_t* keys, const uint32_t* indices,
+    uint32_t* result, uint32_t* resultPayload, uint32_t* expected) {
+    CeBuffer keyBuffer, payloadBuffer;
+    if(__createBuffer(instance, sizeof(uint32_t), elementCount, NULL, &keyBuffer) != CE_SUCCESS)
+        return CE_FALSE;
+    if(__createBuffer(instance, sizeof(uint32_t), elementCount, NULL, &payloadBuffer) != CE_SUCCESS) {
+        ceDestroyBuffer(instance, keyBuffer);
+        return CE_FALSE;
+    }
+    CeSortCreationArgs sortArgs = {
+        .pKeys = keyBuffer,
+        .eKeyType = CE_SORT_KEY_TYPE_UINT32,
+    };
+    CeBool32 passed = __printKeysPerSecond("sort_uint32", "gpu", elementCount,
+        __timeSort(instance, &sortArgs, keys, (uint64_t)elementCount * sizeof(uint32_t), NULL, elementCount));
+    sortArgs.pPayload = payloadBuffer;
+    passed = passed && __printKeysPerSecond("sort_uint32_payload", "gpu", elementCount,
+        __timeSort(instance, &sortArgs, keys, (uint64_t)elementCount * sizeof(uint32_t), indices, elementCount));
+    passed = passed && __download(instance, keyBuffer, result, (uint64_t)elementCount * sizeof(uint32_t)) == CE_SUCCESS &&
+        __download(instance, payloadBuffer, resultPayload, (uint64_t)elementCount * sizeof(uint32_t)) == CE_SUCCESS;
+    ceDestroyBuffer(instance, keyBuffer);
+    ceDestroyBuffer(instance, payloadBuffer);
+    if(!passed)
+        return CE_FALSE;
+
+    //what the sort replaces: qsort on the host
+    const double begin = __now();
+    memcpy(expected, keys, (uint64_t)elementCount * sizeof(uint32_t));
+    qsort(expected, elementCount, sizeof(uint32_t), __compareUint32);
+    __printKeysPerSecond("sort_uint32", "cpu_qsort", elementCount, __now() - begin);
+    for(uint32_t i = 0; i < elementCount; ++i) {
+        if(result[i] != expected[i])
+            return __reportMismatch("sort_uint32", elementCount, i);
+        //the payload follows its key, and equal keys keep their order
+        if(resultPayload[i] >= elementCount || keys[resultPayload[i]] != result[i] ||
+            (i && result[i - 1] == result[i] && resultPayload[i - 1] >= resultPayload[i]))
+            return __reportMismatch("sort_uint32_payload", elementCount, i);
+    }
+    return CE_TRUE;
+}
+
+static CeBool32 __benchSegmented(CeInstance instance, uint32_t elementCount, const uint32_t* keys, uint32_t* result) {
+    const uint32_t segmentCount = (elementCount + SEGMENT_SIZE - 1) / SEGMENT_SIZE;
+    uint32_t* segmentOffsets = malloc(segmentCount * sizeof(uint32_t));
+    for(uint32_t i = 0; i < segmentCount; ++i)
+        segmentOffsets[i] = i * SEGMENT_SIZE;
+    CeBuffer keyBuffer, offsetBuffer;
+    CeBool32 passed = CE_FALSE;
+    if(__createBuffer(instance, sizeof(uint32_t), elementCount, NULL, &keyBuffer) == CE_SUCCESS) {
+        if(__createBuffer(instance, sizeof(uint32_t), segmentCount, segmentOffsets, &offsetBuffer) == CE_SUCCESS) {
+            CeSortCreationArgs sortArgs = {
+                .pKeys = keyBuffer,
+                .eKeyType = CE_SORT_KEY_TYPE_UINT32,
+                .pSegmentOffsets = offsetBuffer,
+            };
+            passed = __printKeysPerSecond("sort_uint32_segmented", "gpu", elementCount,
+                __timeSort(instance, &sortArgs, keys, (uint64_t)elementCount * sizeof(uint32_t), NULL, elementCount)) &&
+                __download(instance, keyBuffer, result, (uint64_t)elementCount * sizeof(uint32_t)) == CE_SUCCESS;
+            ceDestroyBuffer(instance, offsetBuffer);
+        }
+        ceDestroyBuffer(instance, keyBuffer);
+    }
+    free(segmentOffsets);
+    for(uint64_t i = 0; passed && i < elementCount; ++i) {
+        //each segment is sorted, and holds the keys it started with
+        if(i % SEGMENT_SIZE == 0) {
+            const uint32_t segmentEnd = i + SEGMENT_SIZE < elementCount ? i + SEGMENT_SIZE : elementCount;
+            uint64_t inputSum = 0, outputSum = 0;
+            for(uint64_t j = i; j < segmentEnd; ++j) {
+                inputSum += keys[j];
+                outputSum += result[j];
+            }
+            if(inputSum != outputSum)
+                passed = __reportMismatch("sort_uint32_segmented", elementCount, i);
+        } else if(result[i - 1] > result[i]) {
+            passed = __reportMismatch("sort_uint32_segmented", elementCount, i);
+        }
+    }
+    return passed;
+}
+
+static CeBool32 __benchUint64(CeInstance instance, uint32_t elementCount, const uint64_t* keys, uint64_t* result, uint64_t* expected) {
+    CeBuffer keyBuffer;
+    if(__createBuffer(instance, sizeof(uint64_t), elementCount, NULL, &keyBuffer) != CE_SUCCESS)
+        return CE_FALSE;
+    CeSortCreationArgs sortArgs = {
+        .pKeys = keyBuffer,
+        .eKeyType = CE_SORT_KEY_TYPE_UINT64,
+    };
+    CeBool32 passed = __printKeysPerSecond("sort_uint64", "gpu", elementCount,
+        __timeSort(instance, &sortArgs, keys, (uint64_t)elementCount * sizeof(uint64_t), NULL, elementCount)) &&
+        __download(instance, keyBuffer, result, (uint64_t)elementCount * sizeof(uint64_t)) == CE_SUCCESS;
+    ceDestroyBuffer(instance, keyBuffer);
+    if(!passed)
+        return CE_FALSE;
+    const double begin = __now();
+    memcpy(expected, keys, (uint64_t)elementCount * sizeof(uint64_t));
+    qsort(expected, elementCount, sizeof(uint64_t), __compareUint64);
+    __printKeysPerSecond("sort_uint64", "cpu_qsort", elementCount, __now() - begin);
+    for(uint32_t i = 0; i < elementCount; ++i) {
+        if(result[i] != expected[i])
+            return __reportMismatch("sort_uint64", elementCount, i);
+    }
+    return CE_TRUE;
+}
+
+//argv[1] optionally changes the cap of 10M elements, the 100M sorts need a few GiB of device and host memory
+//so they only run when it is raised
+int main(int argc, char** argv) {
+    const uint32_t maxElementCount = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 10000000;
+    CeInstanceCreationArgs instanceArgs = {
+        .pApplicationName = "ce-bench-sort",
+    };
+    CeInstance instance;
+    if(ceCreateInstance(&instanceArgs, &instance) != CE_SUCCESS)
+        return 1;
+    printf("[\n");
+    CeBool32 passed = CE_TRUE;
+    for(uint32_t size = 0; passed && size < sizeof(elementCounts) / sizeof(elementCounts[0]); ++size) {
+        const uint32_t elementCount = elementCounts[size];
+        if(elementCount > maxElementCount)
+            break;
+        uint64_t* keys = malloc((uint64_t)elementCount * sizeof(uint64_t));
+        uint64_t* result = malloc((uint64_t)elementCount * sizeof(uint64_t));
+        uint64_t* expected = malloc((uint64_t)elementCount * sizeof(uint64_t));
+        uint32_t* indices = malloc((uint64_t)elementCount * sizeof(uint32_t));
+        //the 32 bit variants use the front of the 64 bit buffers
+        uint32_t* keys32 = (uint32_t*)keys;
+        srand(size + 1);
+        for(uint32_t i = 0; i < elementCount; ++i) {
+            indices[i] = i;
+            keys32[i] = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+        }
+        //the payload result and the expected keys share the 64 bit expected buffer
+        passed = __benchUint32(instance, elementCount, keys32, indices, (uint32_t*)result, (uint32_t*)expected, (uint32_t*)expected + elementCount) &&
+            __benchSegmented(instance, elementCount, keys32, (uint32_t*)result);
+        for(uint32_t i = 0; passed && i < elementCount; ++i)
+            keys[i] = ((uint64_t)rand() << 40) ^ ((uint64_t)rand() << 20) ^ (uint64_t)rand();
+        passed = passed && __benchUint64(instance, elementCount, keys, result, expected);
+        free(keys);
+        free(result);
+        free(expected);
+        free(indices);
+    }
+    printf("\n]\n");
+    ceDestroyInstance(instance);
+    return passed ? 0 : 1;
+}
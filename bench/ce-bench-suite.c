@@ -0,0 +1,278 @@
+#include "../CE.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#define INSTANCE_CREATIONS 10
+#define PIPELINE_CREATIONS 10
+#define RECORDINGS 2000
+//commands run back to back before waiting on all of them
+#define SUBMITTED_COMMANDS 64
+#define SUBMIT_ROUNDS 20
+#define ROUND_TRIPS 200
+#define TINY_DISPATCHES_PER_COMMAND 256
+#define TINY_DISPATCH_RUNS 20
+//kept small enough for lavapipe to get through the suite quickly
+#define LARGE_ELEMENT_COUNT (1u << 22)
+#define LARGE_DISPATCH_RUNS 10
+#define BANDWIDTH_BYTES (16u << 20)
+#define BANDWIDTH_RUNS 8
+#define LOCAL_SIZE 64
+
+static const char* shaderFilename;
+static const char* cacheFilename;
+static CeBool32 firstResult = CE_TRUE;
+
+static double __now() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec * 1e-9;
+}
+
+static void __printResult(const char* benchmark, const char* variant, const char* unit, double value) {
+    printf("%s  {\"benchmark\": \"%s\", \"variant\": \"%s\", \"unit\": \"%s\", \"value\": %.3f}",
+        firstResult ? "" : ",\n", benchmark, variant, unit, value);
+    firstResult = CE_FALSE;
+}
+
+static CeResult __createIncrementPipeline(CeInstance instance, uint32_t elementCount, CeBindingPlacement placement, CePipeline* pipeline) {
+    CePipelineBindingInfo binding = {
+        .uElementSize = sizeof(uint32_t),
+        .uElementCount = elementCount,
+        .ePlacement = placement,
+        .eAccess = CE_BINDING_ACCESS_READ_WRITE,
+    };
+    CePipelineCreationArgs pipelineArgs = {
+        .pShaderFilename = shaderFilename,
+        .pBindings = &binding,
+        .uBindingCount = 1,
+        .uDispatchGroupCount = (elementCount + LOCAL_SIZE - 1) / LOCAL_SIZE,
+    };
+    return ceCreatePipeline(instance, &pipelineArgs, pipeline);
+}
+
+static CeResult __recordPipeline(CeCommand command, CePipeline pipeline, uint32_t count) {
+    CeCommandRecordingArgs recordArgs = {
+        .pSuppliedPipeline = pipeline,
+    };
+    CeResult result = ceBeginCommand(command);
+    for(uint32_t i = 0; i < count && result == CE_SUCCESS; ++i)
+        result = ceRecordToCommand(&recordArgs, command);
+    if(result == CE_SUCCESS)
+        result = ceEndCommand(command);
+    return result;
+}
+
+static CeResult __benchInstanceCreation() {
+    CeInstanceCreationArgs instanceArgs = {
+        .pApplicationName = "ce-bench-suite",
+    };
+    double total = 0.0;
+    for(uint32_t i = 0; i < INSTANCE_CREATIONS; ++i) {
+        CeInstance instance;
+        const double begin = __now();
+        if(ceCreateInstance(&instanceArgs, &instance) != CE_SUCCESS)
+            return CE_ERROR_INTERNAL;
+        total += __now() - begin;
+        ceDestroyInstance(instance);
+    }
+    __printResult("instance_create", "default", "ms", total / INSTANCE_CREATIONS * 1e3);
+    return CE_SUCCESS;
+}
+
+//cold pipelines are compiled by a fresh instance, warm ones come out of the cache file the previous instance saved
+static CeResult __benchPipelineCreation(CeBool32 warm) {
+    CeInstanceCreationArgs instanceArgs = {
+        .pApplicationName = "ce-bench-suite",
+        .pPipelineCacheFilename = warm ? cacheFilename : NULL,
+    };
+    double total = 0.0;
+    for(uint32_t i = 0; i < PIPELINE_CREATIONS; ++i) {
+        CeInstance instance;
+        if(ceCreateInstance(&instanceArgs, &instance) != CE_SUCCESS)
+            return CE_ERROR_INTERNAL;
+        CePipeline pipeline;
+        const double begin = __now();
+        if(__createIncrementPipeline(instance, LOCAL_SIZE, CE_BINDING_PLACEMENT_AUTO, &pipeline) != CE_SUCCESS)
+            return CE_ERROR_INTERNAL;
+        total += __now() - begin;
+        ceDestroyPipeline(instance, pipeline);
+        ceDestroyInstance(instance);
+    }
+    __printResult("pipeline_create", warm ? "warm" : "cold", "ms", total / PIPELINE_CREATIONS * 1e3);
+    return CE_SUCCESS;
+}
+
+static CeResult __benchRecording(CeInstance instance, CePipeline pipeline) {
+    CeCommandCreationArgs commandArgs = {0};
+    CeCommand command;
+    if(ceCreateCommand(instance, &commandArgs, &command) != CE_SUCCESS)
+        return CE_ERROR_INTERNAL;
+    const double begin = __now();
+    CeResult result = CE_SUCCESS;
+    for(uint32_t i = 0; i < RECORDINGS && result == CE_SUCCESS; ++i)
+        result = __recordPipeline(command, pipeline, 1);
+    const double seconds = __now() - begin;
+    ceDestroyCommand(instance, command);
+    if(result != CE_SUCCESS)
+        return result;
+    __printResult("record", "one_pipeline", "us_per_command", seconds / RECORDINGS * 1e6);
+    return CE_SUCCESS;
+}
+
+static CeResult __benchSubmission(CeInstance instance, CePipeline pipeline) {
+    CeCommand commands[SUBMITTED_COMMANDS];
+    CeCommandCreationArgs commandArgs = {0};
+    for(uint32_t i = 0; i < SUBMITTED_COMMANDS; ++i) {
+        if(ceCreateCommand(instance, &commandArgs, &commands[i]) != CE_SUCCESS || __recordPipeline(commands[i], pipeline, 1) != CE_SUCCESS)
+            return CE_ERROR_INTERNAL;
+    }
+    //the submissions alone, then with every command going out in a single batch
+    double single = 0.0, batched = 0.0;
+    for(uint32_t round = 0; round < SUBMIT_ROUNDS; ++round) {
+        double begin = __now();
+        for(uint32_t i = 0; i < SUBMITTED_COMMANDS; ++i) {
+            if(ceRunCommand(instance, commands[i]) != CE_SUCCESS)
+                return CE_ERROR_INTERNAL;
+        }
+        single += __now() - begin;
+        if(ceWaitCommands(instance, commands, SUBMITTED_COMMANDS, CE_TRUE, ~((uint64_t)0), NULL) != CE_SUCCESS)
+            return CE_ERROR_INTERNAL;
+        begin = __now();
+        if(ceRunCommands(instance, commands, SUBMITTED_COMMANDS) != CE_SUCCESS)
+            return CE_ERROR_INTERNAL;
+        batched += __now() - begin;
+        if(ceWaitCommands(instance, commands, SUBMITTED_COMMANDS, CE_TRUE, ~((uint64_t)0), NULL) != CE_SUCCESS)
+            return CE_ERROR_INTERNAL;
+    }
+    __printResult("submit", "single", "us_per_command", single / (SUBMIT_ROUNDS * SUBMITTED_COMMANDS) * 1e6);
+    __printResult("submit", "batched", "us_per_command", batched / (SUBMIT_ROUNDS * SUBMITTED_COMMANDS) * 1e6);
+
+    //a run and a wait on a single command, which is the latency of the smallest possible piece of work
+    const double begin = __now();
+    for(uint32_t i = 0; i < ROUND_TRIPS; ++i) {
+        if(ceRunCommand(instance, commands[0]) != CE_SUCCESS || ceWaitCommand(instance, commands[0]) != CE_SUCCESS)
+            return CE_ERROR_INTERNAL;
+    }
+    __printResult("submit", "round_trip", "us", (__now() - begin) / ROUND_TRIPS * 1e6);
+    for(uint32_t i = 0; i < SUBMITTED_COMMANDS; ++i)
+        ceDestroyCommand(instance, commands[i]);
+    return CE_SUCCESS;
+}
+
+static CeResult __benchDispatch(CeInstance instance, CePipeline tinyPipeline) {
+    CeCommandCreationArgs commandArgs = {0};
+    CeCommand command;
+    if(ceCreateCommand(instance, &commandArgs, &command) != CE_SUCCESS)
+        return CE_ERROR_INTERNAL;
+    //tiny kernels are bound by the cost of each dispatch
+    if(__recordPipeline(command, tinyPipeline, TINY_DISPATCHES_PER_COMMAND) != CE_SUCCESS)
+        return CE_ERROR_INTERNAL;
+    double begin = __now();
+    for(uint32_t i = 0; i < TINY_DISPATCH_RUNS; ++i) {
+        if(ceRunCommand(instance, command) != CE_SUCCESS || ceWaitCommand(instance, command) != CE_SUCCESS)
+            return CE_ERROR_INTERNAL;
+    }
+    __printResult("dispatch", "tiny", "dispatches_per_second",
+        (double)TINY_DISPATCHES_PER_COMMAND * TINY_DISPATCH_RUNS / (__now() - begin));
+
+    //large kernels by how fast elements go through
+    CePipeline largePipeline;
+    if(__createIncrementPipeline(instance, LARGE_ELEMENT_COUNT, CE_BINDING_PLACEMENT_DEVICE_LOCAL, &largePipeline) != CE_SUCCESS)
+        return CE_ERROR_INTERNAL;
+    if(__recordPipeline(command, largePipeline, 1) != CE_SUCCESS)
+        return CE_ERROR_INTERNAL;
+    begin = __now();
+    for(uint32_t i = 0; i < LARGE_DISPATCH_RUNS; ++i) {
+        if(ceRunCommand(instance, command) != CE_SUCCESS || ceWaitCommand(instance, command) != CE_SUCCESS)
+            return CE_ERROR_INTERNAL;
+    }
+    __printResult("dispatch", "large", "elements_per_second", (double)LARGE_ELEMENT_COUNT * LARGE_DISPATCH_RUNS / (__now() - begin));
+    ceDestroyCommand(instance, command);
+    ceDestroyPipeline(instance, largePipeline);
+    return CE_SUCCESS;
+}
+
+//copies through the transfer queues, and through mapping which goes through the staging buffer for device-local memory
+static CeResult __benchBandwidth(CeInstance instance, CeBindingPlacement placement, const char* placementName) {
+    CeBufferCreationArgs bufferArgs = {
+        .uElementSize = sizeof(uint32_t),
+        .uElementCount = BANDWIDTH_BYTES / sizeof(uint32_t),
+        .ePlacement = placement,
+    };
+    CeBuffer buffer;
+    if(ceCreateBuffer(instance, &bufferArgs, &buffer) != CE_SUCCESS)
+        return CE_ERROR_INTERNAL;
+    char* hostData = calloc(BANDWIDTH_BYTES, 1);
+    char variant[64];
+    for(uint32_t download = 0; download < 2; ++download) {
+        const double begin = __now();
+        for(uint32_t i = 0; i < BANDWIDTH_RUNS; ++i) {
+            CeTransfer transfer;
+            CeResult result = download ?
+                ceDownloadBufferAsync(instance, buffer, 0, hostData, BANDWIDTH_BYTES, NULL, &transfer) :
+                ceUploadBufferAsync(instance, buffer, 0, hostData, BANDWIDTH_BYTES, NULL, &transfer);
+            if(result != CE_SUCCESS || ceWaitTransfer(instance, transfer) != CE_SUCCESS)
+                return CE_ERROR_INTERNAL;
+            ceDestroyTransfer(instance, transfer);
+        }
+        snprintf(variant, sizeof(variant), "%s_%s_transfer", placementName, download ? "download" : "upload");
+        __printResult("bandwidth", variant, "GB_per_second", (double)BANDWIDTH_BYTES * BANDWIDTH_RUNS / (__now() - begin) / 1e9);
+    }
+    //mapping reads the buffer and unmapping writes it back, both are counted
+    const double begin = __now();
+    for(uint32_t i = 0; i < BANDWIDTH_RUNS; ++i) {
+        void* mapped;
+        if(ceMapBufferMemory(instance, buffer, &mapped) != CE_SUCCESS)
+            return CE_ERROR_INTERNAL;
+        memcpy(hostData, mapped, BANDWIDTH_BYTES);
+        memcpy(mapped, hostData, BANDWIDTH_BYTES);
+        ceUnmapBufferMemory(instance, buffer);
+    }
+    snprintf(variant, sizeof(variant), "%s_map_roundtrip", placementName);
+    __printResult("bandwidth", variant, "GB_per_second", 2.0 * BANDWIDTH_BYTES * BANDWIDTH_RUNS / (__now() - begin) / 1e9);
+    free(hostData);
+    ceDestroyBuffer(instance, buffer);
+    return CE_SUCCESS;
+}
+
+int main(int argc, char** argv) {
+    shaderFilename = argc > 1 ? argv[1] : "build/bench/increment.spv";
+    cacheFilename = argc > 2 ? argv[2] : "build/bench/pipeline-cache.bin";
+    //the warm runs must not see a cache left over from an earlier run of the suite before the cold ones
+    remove(cacheFilename);
+    printf("[\n");
+    if(__benchInstanceCreation() != CE_SUCCESS || __benchPipelineCreation(CE_FALSE) != CE_SUCCESS)
+        return 1;
+    //fills the cache file for the warm runs
+    CeInstanceCreationArgs instanceArgs = {
+        .pApplicationName = "ce-bench-suite",
+        .pPipelineCacheFilename = cacheFilename,
+    };
+    CeInstance instance;
+    CePipeline pipeline;
+    if(ceCreateInstance(&instanceArgs, &instance) != CE_SUCCESS ||
+        __createIncrementPipeline(instance, LOCAL_SIZE, CE_BINDING_PLACEMENT_AUTO, &pipeline) != CE_SUCCESS)
+        return 1;
+    ceDestroyPipeline(instance, pipeline);
+    ceDestroyInstance(instance);
+    if(__benchPipelineCreation(CE_TRUE) != CE_SUCCESS)
+        return 1;
+
+    instanceArgs.pPipelineCacheFilename = NULL;
+    if(ceCreateInstance(&instanceArgs, &instance) != CE_SUCCESS ||
+        __createIncrementPipeline(instance, LOCAL_SIZE, CE_BINDING_PLACEMENT_AUTO, &pipeline) != CE_SUCCESS)
+        return 1;
+    if(__benchRecording(instance, pipeline) != CE_SUCCESS || __benchSubmission(instance, pipeline) != CE_SUCCESS ||
+        __benchDispatch(instance, pipeline) != CE_SUCCESS)
+        return 1;
+    if(__benchBandwidth(instance, CE_BINDING_PLACEMENT_DEVICE_LOCAL, "device_local") != CE_SUCCESS ||
+        __benchBandwidth(instance, CE_BINDING_PLACEMENT_HOST_VISIBLE, "host_visible") != CE_SUCCESS)
+        return 1;
+    printf("\n]\n");
+    ceDestroyPipeline(instance, pipeline);
+    ceDestroyInstance(instance);
+    return 0;
+}
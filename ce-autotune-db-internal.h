@@ -0,0 +1,46 @@
+#pragma once
+#include "ce-def.h"
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan_core.h>
+
+/*
+* The autotune database maps a device, a driver version and a shader to the parameter values
+* ceAutotunePipeline found fastest for it. It is shared by every device of an instance and can be used
+* from several threads. When it has a file it is loaded from it on creation and written back after every change.
+*/
+typedef struct CeAutotuneDatabase_t *CeAutotuneDatabase;
+
+#define CE_MAX_AUTOTUNE_PARAMETERS 8
+
+struct CeAutotuneParameterValue {
+    //a CeTunableKind
+    uint32_t kind;
+    uint32_t index;
+    uint32_t value;
+    //when set the x work group count is divided by value
+    uint32_t dividesDispatch;
+};
+
+struct CeAutotuneEntry {
+    uint8_t deviceUUID[VK_UUID_SIZE];
+    uint32_t driverVersion;
+    uint32_t parameterCount;
+    uint64_t shaderHash;
+    uint64_t gpuTimeNs;
+    struct CeAutotuneParameterValue parameters[CE_MAX_AUTOTUNE_PARAMETERS];
+};
+
+//an empty database if filename is NULL, missing or unreadable
+VkResult
+ceCreateAutotuneDatabase(const char* filename, CeAutotuneDatabase*);
+
+//copies the entry of the device, driver and shader to target, returns CE_FALSE if none was stored
+CeBool32
+ceFindAutotuneEntry(CeAutotuneDatabase, const uint8_t* deviceUUID, uint32_t driverVersion, uint64_t shaderHash, struct CeAutotuneEntry*);
+
+//replaces the entry with the same key, and atomically rewrites the file if there is one
+VkResult
+ceStoreAutotuneEntry(CeAutotuneDatabase, const struct CeAutotuneEntry*);
+
+void
+ceDestroyAutotuneDatabase(CeAutotuneDatabase);
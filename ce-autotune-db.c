@@ -0,0 +1,124 @@
+#include "ce-autotune-db-internal.h"
+#include "ce-def.h"
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan_core.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include "ce-file-internal.h"
+
+#define CE_AUTOTUNE_DATABASE_MAGIC 0x54414543u
+#define CE_AUTOTUNE_DATABASE_VERSION 1u
+
+struct CeAutotuneDatabaseFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t entrySize;
+};
+
+struct CeAutotuneDatabase_t {
+    char* filename;
+    pthread_mutex_t mutex;
+    struct CeAutotuneEntry* entries;
+    uint32_t entryCount;
+    uint32_t entryCapacity;
+};
+
+static void __appendEntry(CeAutotuneDatabase database, const struct CeAutotuneEntry* entry) {
+    if(database->entryCount == database->entryCapacity) {
+        database->entryCapacity = database->entryCapacity ? database->entryCapacity * 2 : 16;
+        database->entries = realloc(database->entries, database->entryCapacity * sizeof(struct CeAutotuneEntry));
+    }
+    database->entries[database->entryCount++] = *entry;
+}
+
+//a file written by another version of CE is ignored rather than misread
+static void __readDatabaseFile(CeAutotuneDatabase database) {
+    FILE* file = fopen(database->filename, "rb");
+    if(!file)
+        return;
+    struct CeAutotuneDatabaseFileHeader header;
+    if(fread(&header, sizeof(header), 1, file) == 1 && header.magic == CE_AUTOTUNE_DATABASE_MAGIC &&
+        header.version == CE_AUTOTUNE_DATABASE_VERSION && header.entrySize == sizeof(struct CeAutotuneEntry)) {
+        struct CeAutotuneEntry entry;
+        for(uint32_t i = 0; i < header.entryCount && fread(&entry, sizeof(entry), 1, file) == 1; ++i) {
+            if(entry.parameterCount <= CE_MAX_AUTOTUNE_PARAMETERS)
+                __appendEntry(database, &entry);
+        }
+    }
+    fclose(file);
+}
+
+//the lock must be held, the file is replaced atomically so readers never see half of it
+static VkResult __writeDatabaseFile(CeAutotuneDatabase database) {
+    struct CeAutotuneDatabaseFileHeader header = {
+        .magic = CE_AUTOTUNE_DATABASE_MAGIC,
+        .version = CE_AUTOTUNE_DATABASE_VERSION,
+        .entryCount = database->entryCount,
+        .entrySize = sizeof(struct CeAutotuneEntry),
+    };
+    const void* chunks[] = { &header, database->entries };
+    const size_t chunkSizes[] = { sizeof(header), database->entryCount * sizeof(struct CeAutotuneEntry) };
+    return ceWriteFileAtomically(database->filename, chunks, chunkSizes, 2);
+}
+
+VkResult
+ceCreateAutotuneDatabase(const char* filename, CeAutotuneDatabase* target) {
+    CeAutotuneDatabase database = calloc(1, sizeof(struct CeAutotuneDatabase_t));
+    if(!database)
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    pthread_mutex_init(&database->mutex, NULL);
+    if(filename) {
+        database->filename = strdup(filename);
+        __readDatabaseFile(database);
+    }
+    *target = database;
+    return VK_SUCCESS;
+}
+
+//the lock must be held
+static struct CeAutotuneEntry* __findEntry(CeAutotuneDatabase database, const uint8_t* deviceUUID, uint32_t driverVersion, uint64_t shaderHash) {
+    for(uint32_t i = 0; i < database->entryCount; ++i) {
+        struct CeAutotuneEntry* entry = &database->entries[i];
+        if(entry->shaderHash == shaderHash && entry->driverVersion == driverVersion &&
+            !memcmp(entry->deviceUUID, deviceUUID, VK_UUID_SIZE))
+            return entry;
+    }
+    return NULL;
+}
+
+CeBool32
+ceFindAutotuneEntry(CeAutotuneDatabase database, const uint8_t* deviceUUID, uint32_t driverVersion, uint64_t shaderHash,
+    struct CeAutotuneEntry* target) {
+    pthread_mutex_lock(&database->mutex);
+    struct CeAutotuneEntry* entry = __findEntry(database, deviceUUID, driverVersion, shaderHash);
+    if(entry)
+        *target = *entry;
+    pthread_mutex_unlock(&database->mutex);
+    return entry ? CE_TRUE : CE_FALSE;
+}
+
+VkResult
+ceStoreAutotuneEntry(CeAutotuneDatabase database, const struct CeAutotuneEntry* entry) {
+    pthread_mutex_lock(&database->mutex);
+    struct CeAutotuneEntry* existing = __findEntry(database, entry->deviceUUID, entry->driverVersion, entry->shaderHash);
+    if(existing)
+        *existing = *entry;
+    else
+        __appendEntry(database, entry);
+    VkResult result = database->filename ? __writeDatabaseFile(database) : VK_SUCCESS;
+    pthread_mutex_unlock(&database->mutex);
+    return result;
+}
+
+void
+ceDestroyAutotuneDatabase(CeAutotuneDatabase database) {
+    if(!database)
+        return;
+    pthread_mutex_destroy(&database->mutex);
+    free(database->entries);
+    free(database->filename);
+    free(database);
+}
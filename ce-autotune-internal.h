@@ -0,0 +1,18 @@
+#pragma once
+#include "ce-def.h"
+#include "ce-autotune.h"
+#include "ce-autotune-db-internal.h"
+
+//creation args with tuned values applied, args points into the structure which **must not** be moved
+struct CeTunedPipelineArgs {
+    CePipelineCreationArgs args;
+    CePipelineSpecializationInfo* specializationConstants;
+    CePipelineConstantInfo* constants;
+    uint32_t values[CE_MAX_AUTOTUNE_PARAMETERS];
+};
+
+void
+ceApplyAutotuneParameters(const CePipelineCreationArgs*, const struct CeAutotuneParameterValue*, uint32_t parameterCount, struct CeTunedPipelineArgs*);
+
+void
+ceFreeTunedPipelineArgs(struct CeTunedPipelineArgs*);
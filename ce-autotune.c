@@ -0,0 +1,206 @@
+#include "ce-autotune.h"
+#include "ce-def.h"
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan_core.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ce-command.h"
+#include "ce-autotune-internal.h"
+#include "ce-instance-internal.h"
+#include "ce-pipeline-internal.h"
+#include "ce-buffer-internal.h"
+#include "ce-shader-internal.h"
+#include "ce-error-internal.h"
+#include "ce-trace-internal.h"
+
+#define CE_DEFAULT_AUTOTUNE_RUN_COUNT 5
+
+_Static_assert(CE_MAX_TUNABLE_PARAMETERS == CE_MAX_AUTOTUNE_PARAMETERS, "every tunable parameter must fit in a database entry");
+
+static uint32_t __getLongestBindingElementCount(const CePipelineCreationArgs* args) {
+    uint32_t longest = 0;
+    for(uint32_t i = 0; i < args->uBindingCount; ++i) {
+        const uint32_t count = args->pBindings[i].pSuppliedBuffer ?
+            ceGetBufferElementCount(args->pBindings[i].pSuppliedBuffer) : args->pBindings[i].uElementCount;
+        longest = count > longest ? count : longest;
+    }
+    return longest;
+}
+
+void
+ceApplyAutotuneParameters(const CePipelineCreationArgs* args, const struct CeAutotuneParameterValue* parameters, uint32_t parameterCount,
+    struct CeTunedPipelineArgs* tuned) {
+    tuned->args = *args;
+    //room for every specialization constant of the pipeline plus the tuned ones it does not set
+    tuned->specializationConstants = malloc((args->uSpecializationConstantCount + parameterCount) * sizeof(CePipelineSpecializationInfo));
+    memcpy(tuned->specializationConstants, args->pSpecializationConstants, args->uSpecializationConstantCount * sizeof(CePipelineSpecializationInfo));
+    tuned->constants = malloc((args->uConstantCount ? args->uConstantCount : 1) * sizeof(CePipelineConstantInfo));
+    memcpy(tuned->constants, args->pConstants, args->uConstantCount * sizeof(CePipelineConstantInfo));
+    tuned->args.pSpecializationConstants = tuned->specializationConstants;
+    tuned->args.pConstants = tuned->constants;
+
+    uint64_t dispatchDivisor = 1;
+    for(uint32_t i = 0; i < parameterCount; ++i) {
+        const struct CeAutotuneParameterValue* parameter = &parameters[i];
+        tuned->values[i] = parameter->value;
+        if(parameter->dividesDispatch && parameter->value)
+            dispatchDivisor *= parameter->value;
+        if(parameter->kind == CE_TUNABLE_PUSH_CONSTANT) {
+            //a stored value only applies while the constant still has the shape it was tuned with
+            if(parameter->index < args->uConstantCount && tuned->constants[parameter->index].uDataSize == sizeof(uint32_t) &&
+                !tuned->constants[parameter->index].bIsLiveConstant)
+                tuned->constants[parameter->index].pData = &tuned->values[i];
+            continue;
+        }
+        CePipelineSpecializationInfo* specialization = NULL;
+        for(uint32_t j = 0; j < tuned->args.uSpecializationConstantCount; ++j) {
+            if(tuned->specializationConstants[j].uConstantId == parameter->index)
+                specialization = &tuned->specializationConstants[j];
+        }
+        if(!specialization) {
+            specialization = &tuned->specializationConstants[tuned->args.uSpecializationConstantCount++];
+            specialization->uConstantId = parameter->index;
+        }
+        specialization->pData = &tuned->values[i];
+        specialization->uDataSize = sizeof(uint32_t);
+    }
+    if(dispatchDivisor > 1) {
+        const uint64_t groupCount = args->uDispatchGroupCount ? args->uDispatchGroupCount : __getLongestBindingElementCount(args);
+        tuned->args.uDispatchGroupCount = (uint32_t)((groupCount + dispatchDivisor - 1) / dispatchDivisor);
+        if(!tuned->args.uDispatchGroupCount)
+            tuned->args.uDispatchGroupCount = 1;
+    }
+}
+
+void
+ceFreeTunedPipelineArgs(struct CeTunedPipelineArgs* tuned) {
+    free(tuned->specializationConstants);
+    free(tuned->constants);
+}
+
+static CeResult __recordVariant(CePipeline pipeline, CeCommand command) {
+    CeCommandRecordingArgs recordingArgs = {
+        .bRecordCommand = CE_FALSE,
+        .pSuppliedPipeline = pipeline,
+    };
+    CeResult result = ceBeginCommand(command);
+    if(result == CE_SUCCESS)
+        result = ceRecordToCommand(&recordingArgs, command);
+    if(result == CE_SUCCESS)
+        result = ceEndCommand(command);
+    return result;
+}
+
+//writes the fastest of runCount runs, after a first run which warms up caches and clocks
+static CeResult __timeVariant(CeInstance instance, const CePipelineCreationArgs* pipelineArgs, const struct CeAutotuneParameterValue* parameters,
+    uint32_t parameterCount, uint32_t runCount, uint64_t* pTime) {
+    struct CeTunedPipelineArgs tuned;
+    ceApplyAutotuneParameters(pipelineArgs, parameters, parameterCount, &tuned);
+    CePipeline pipeline;
+    CeResult result = ceCreatePipelineUntuned(instance, &tuned.args, &pipeline);
+    ceFreeTunedPipelineArgs(&tuned);
+    if(result != CE_SUCCESS)
+        return result;
+    const CeBool32 useTimestamps = ceGetInstanceTimestampValidBits(instance) ? CE_TRUE : CE_FALSE;
+    CeCommandCreationArgs commandArgs = {
+        .bEnableProfiling = useTimestamps,
+    };
+    CeCommand command;
+    result = ceCreateCommand(instance, &commandArgs, &command);
+    if(result != CE_SUCCESS) {
+        ceDestroyPipeline(instance, pipeline);
+        return result;
+    }
+    result = __recordVariant(pipeline, command);
+    uint64_t fastest = ~((uint64_t)0);
+    for(uint32_t i = 0; i <= runCount && result == CE_SUCCESS; ++i) {
+        const uint64_t hostBegin = ceTraceNow();
+        result = ceRunCommand(instance, command);
+        if(result == CE_SUCCESS)
+            result = ceWaitCommand(instance, command);
+        uint64_t time = ceTraceNow() - hostBegin;
+        if(result == CE_SUCCESS && useTimestamps) {
+            CeCommandProfile profile = {0};
+            result = ceGetCommandProfile(instance, command, &profile);
+            time = profile.uGpuTimeNs;
+        }
+        if(result == CE_SUCCESS && i && time < fastest)
+            fastest = time;
+    }
+    ceDestroyPipeline(instance, pipeline);
+    ceDestroyCommand(instance, command);
+    *pTime = fastest;
+    return result;
+}
+
+CeResult
+ceAutotunePipeline(CeInstance instance, const CeAutotuneArgs* args, CeAutotuneResult* result) {
+    if(!instance || !args || !args->pPipelineArgs || !args->pParameters)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot autotune pipeline: some parameters were NULL");
+    //variants are timed with GPU timestamps and stored under the hash of their SPIR-V
+    if(ceGetInstanceCpuBackend(instance))
+        return ceResult(CE_ERROR_INVALID_ARG, "cannot autotune pipeline: CPU instances run native kernels, which cannot be tuned");
+    const CePipelineCreationArgs* pipelineArgs = args->pPipelineArgs;
+    if(!args->uParameterCount || args->uParameterCount > CE_MAX_TUNABLE_PARAMETERS)
+        return ceResult(CE_ERROR_INVALID_ARG, "cannot autotune pipeline: between 1 and CE_MAX_TUNABLE_PARAMETERS parameters can be tuned");
+    uint64_t variantCount = 1;
+    for(uint32_t i = 0; i < args->uParameterCount; ++i) {
+        const CeTunableParameter* parameter = &args->pParameters[i];
+        if(!parameter->pValues || !parameter->uValueCount)
+            return ceResult(CE_ERROR_INVALID_ARG, "cannot autotune pipeline: a parameter has no candidate values");
+        if(parameter->eKind == CE_TUNABLE_PUSH_CONSTANT && (parameter->uIndex >= pipelineArgs->uConstantCount ||
+            pipelineArgs->pConstants[parameter->uIndex].uDataSize != sizeof(uint32_t) || pipelineArgs->pConstants[parameter->uIndex].bIsLiveConstant))
+            return ceResult(CE_ERROR_INVALID_ARG, "cannot autotune pipeline: tuned push constants must be 4 byte constants which are not live");
+        variantCount *= parameter->uValueCount;
+    }
+
+    //the module stays loaded for the whole search, so variants do not each load it again
+    CeShaderCache shaderCache = ceGetInstanceShaderCache(instance);
+    VkShaderModule shader;
+    if(ceAcquirePipelineShaderModule(instance, pipelineArgs, &shader) != VK_SUCCESS)
+        return ceResult(CE_ERROR_INTERNAL, "failed to create Vk shader module");
+    const uint64_t traceBegin = ceTraceBegin();
+    const uint32_t runCount = args->uRunCount ? args->uRunCount : CE_DEFAULT_AUTOTUNE_RUN_COUNT;
+    struct CeAutotuneEntry best = {
+        .driverVersion = ceGetInstanceVulkanDeviceProperties(instance)->driverVersion,
+        .parameterCount = args->uParameterCount,
+        .shaderHash = ceGetShaderModuleHash(shaderCache, shader),
+        .gpuTimeNs = ~((uint64_t)0),
+    };
+    memcpy(best.deviceUUID, ceGetInstanceDeviceUUID(instance), VK_UUID_SIZE);
+    uint32_t timedCount = 0;
+    struct CeAutotuneParameterValue parameters[CE_MAX_AUTOTUNE_PARAMETERS];
+    for(uint64_t variant = 0; variant < variantCount; ++variant) {
+        //the variant index counts through every combination, the first parameter changing fastest
+        uint64_t remainder = variant;
+        for(uint32_t i = 0; i < args->uParameterCount; ++i) {
+            const CeTunableParameter* parameter = &args->pParameters[i];
+            parameters[i].kind = parameter->eKind;
+            parameters[i].index = parameter->uIndex;
+            parameters[i].value = parameter->pValues[remainder % parameter->uValueCount];
+            parameters[i].dividesDispatch = parameter->bDividesDispatch ? 1 : 0;
+            remainder /= parameter->uValueCount;
+        }
+        uint64_t time;
+        if(__timeVariant(instance, pipelineArgs, parameters, args->uParameterCount, runCount, &time) != CE_SUCCESS)
+            continue;
+        ++timedCount;
+        if(time < best.gpuTimeNs) {
+            best.gpuTimeNs = time;
+            memcpy(best.parameters, parameters, args->uParameterCount * sizeof(struct CeAutotuneParameterValue));
+        }
+    }
+    ceReleaseShaderModule(instance, shaderCache, shader);
+    ceTraceEnd("ceAutotunePipeline", traceBegin);
+    if(!timedCount)
+        return ceResult(CE_ERROR_INVALID_ARG, "cannot autotune pipeline: no variant could be created and run");
+    if(result) {
+        for(uint32_t i = 0; i < args->uParameterCount; ++i)
+            result->pValues[i] = best.parameters[i].value;
+        result->uGpuTimeNs = best.gpuTimeNs;
+        result->uVariantCount = timedCount;
+    }
+    if(ceStoreAutotuneEntry(ceGetInstanceAutotuneDatabase(instance), &best) != VK_SUCCESS)
+        return ceResult(CE_ERROR_INTERNAL, "failed to save the autotune database");
+    return CE_SUCCESS;
+}
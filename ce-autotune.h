@@ -0,0 +1,62 @@
+#pragma once
+#include "ce-def.h"
+#include "ce-pipeline.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//at most this many parameters are tuned together
+#define CE_MAX_TUNABLE_PARAMETERS 8
+
+typedef enum {
+    //uIndex is the constant_id of a specialization constant, which is added to the pipeline if it does not set it
+    CE_TUNABLE_SPECIALIZATION_CONSTANT = 0,
+    //uIndex is the index of a 4 byte push constant in pConstants, live constants cannot be tuned
+    CE_TUNABLE_PUSH_CONSTANT
+} CeTunableKind;
+
+typedef struct {
+    CeTunableKind eKind;
+    uint32_t uIndex;
+    //the candidate values, every one of them is tried with every value of the other parameters
+    const uint32_t* pValues;
+    uint32_t uValueCount;
+    //if set, the x work group count (or the longest binding's element count when it is 0) is divided by the value, rounding up.
+    //meant for local sizes and elements per invocation, so that every variant covers the same elements
+    CeBool32 bDividesDispatch;
+} CeTunableParameter;
+
+typedef struct {
+    //the pipeline to tune, every variant is created from it with the tuned values applied
+    const CePipelineCreationArgs* pPipelineArgs;
+    const CeTunableParameter* pParameters;
+    uint32_t uParameterCount;
+    //timed runs of each variant after a warm-up run, the fastest counts. 0 means 5
+    uint32_t uRunCount;
+} CeAutotuneArgs;
+
+typedef struct {
+    //the fastest value of each parameter, in the order of pParameters
+    uint32_t pValues[CE_MAX_TUNABLE_PARAMETERS];
+    //GPU time of the fastest variant's fastest run, in nanoseconds
+    uint64_t uGpuTimeNs;
+    //number of variants which could be created and timed
+    uint32_t uVariantCount;
+} CeAutotuneResult;
+
+/**
+* Time every combination of the candidate parameter values of a pipeline and keep the fastest.
+* Runs are timed with GPU timestamps, or on the host if the device's queues have none.
+* The winner is stored in the instance's autotune database under the device, its driver version and the shader's SPIR-V,
+* and every later ceCreatePipeline of the same shader on such a device applies it over its own values.
+* Variants which cannot be created, for instance because their local size is above the device's limit, are skipped.
+* \param instance the instance (or device, see ceGetInstanceDevice) the variants run on
+* \param args pointer to a CeAutotuneArgs structure
+* \param result if not NULL, the fastest values and their time are written to it
+*/
+CeResult
+ceAutotunePipeline(CeInstance instance, const CeAutotuneArgs* args, CeAutotuneResult* result);
+
+#ifdef __cplusplus
+}
+#endif
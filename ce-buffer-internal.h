@@ -0,0 +1,26 @@
+#pragma once
+#include "ce-def.h"
+#include "ce-buffer.h"
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan_core.h>
+
+//creates a buffer but leaves its initial upload queued on the instance staging ring
+CeResult
+ceCreateBufferUnflushed(CeInstance, const CeBufferCreationArgs*, CeBuffer*);
+
+VkBuffer
+ceGetBufferVulkanBuffer(CeBuffer);
+
+VkDeviceSize
+ceGetBufferSize(CeBuffer);
+
+uint32_t
+ceGetBufferElementCount(CeBuffer);
+
+//returns the kept mapping or the current host copy of the buffer, NULL if it is not mapped
+void*
+ceGetBufferMappedData(CeBuffer);
+
+//the memory of a buffer of a CPU instance, NULL for Vulkan buffers
+void*
+ceGetBufferCpuMemory(CeBuffer);
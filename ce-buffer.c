@@ -0,0 +1,335 @@
+#include "ce-buffer.h"
+#include "ce-def.h"
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan_core.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ce-buffer-internal.h"
+#include "ce-instance-internal.h"
+#include "ce-memory-internal.h"
+#include "ce-staging-internal.h"
+#include "ce-error-internal.h"
+
+struct CeBuffer_t {
+    VkBuffer vulkanBuffer;
+    CeMemoryAllocation allocation;
+    VkDeviceSize size;
+    uint32_t elementCount;
+    //the memory is not host-visible, it is filled and read back through the staging ring
+    CeBool32 isStaged;
+    //either the kept mapping of a host-visible buffer or the host copy of a mapped staged buffer
+    void* mappedData;
+    //the pHostMemory the buffer was created with, NULL for other buffers
+    void* hostMemory;
+    //set when hostMemory is imported, the buffer then owns this memory instead of an arena allocation
+    VkDeviceMemory importedMemory;
+    //the memory of buffers of CPU instances, hostMemory itself when the buffer was created with it
+    void* cpuMemory;
+    CeBool32 ownsCpuMemory;
+};
+
+static uint32_t __chooseBufferMemoryType(CeInstance instance, const CeBufferCreationArgs* args, uint32_t memoryTypeBits) {
+    uint32_t memoryType = CE_INVALID_MEMORY_TYPE;
+    CeBindingPlacement placement = args->ePlacement;
+    if(placement == CE_BINDING_PLACEMENT_AUTO)
+        placement = args->bKeepMapped ? CE_BINDING_PLACEMENT_HOST_VISIBLE : CE_BINDING_PLACEMENT_DEVICE_LOCAL;
+    if(placement == CE_BINDING_PLACEMENT_DEVICE_LOCAL)
+        memoryType = ceGetInstanceMemoryTypeIndex(instance, memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    //host-visible buffers, and device-local ones on devices without any device-local memory
+    if(memoryType == CE_INVALID_MEMORY_TYPE)
+        memoryType = ceGetInstanceMemoryTypeIndex(instance, memoryTypeBits,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    return memoryType;
+}
+
+static VkResult __createVkBuffer(CeInstance instance, const CeBufferCreationArgs* args, CeBuffer buffer) {
+    VkDevice device = ceGetInstanceVulkanDevice(instance);
+    uint32_t familyIndex = ceGetInstanceVulkanQueueFamilyIndex(instance);
+    VkResult result;
+    //buffers can be bound as storage or uniform buffers depending on the pipeline using them, or hold indirect dispatch sizes
+    VkBufferCreateInfo bufferInfo = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size = buffer->size,
+        .pQueueFamilyIndices = &familyIndex,
+        .queueFamilyIndexCount = 1,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+    };
+    result = vkCreateBuffer(device, &bufferInfo, NULL, &buffer->vulkanBuffer);
+    if(result != VK_SUCCESS)
+        return result;
+    VkMemoryRequirements memoryRequirements;
+    vkGetBufferMemoryRequirements(device, buffer->vulkanBuffer, &memoryRequirements);
+    uint32_t memoryType = __chooseBufferMemoryType(instance, args, memoryRequirements.memoryTypeBits);
+    if(memoryType == CE_INVALID_MEMORY_TYPE)
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    //device-local memory which is also host-visible (integrated GPUs, resizable BAR) is mapped directly
+    const VkMemoryPropertyFlags hostFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    buffer->isStaged = (ceGetInstanceMemoryTypeFlags(instance, memoryType) & hostFlags) != hostFlags;
+    result = ceArenaAllocate(instance, ceGetInstanceMemoryArena(instance), &memoryRequirements, memoryType, &buffer->allocation);
+    if(result != VK_SUCCESS)
+        return result;
+    result = vkBindBufferMemory(device, buffer->vulkanBuffer, buffer->allocation.vulkanMemory, buffer->allocation.offset);
+    if(result != VK_SUCCESS)
+        return result;
+    if(buffer->isStaged) {
+        if(args->pInitialData)
+            return ceStagingUpload(instance, ceGetInstanceStagingRing(instance), buffer->vulkanBuffer, 0, args->pInitialData, buffer->size);
+        return VK_SUCCESS;
+    }
+    //host-visible arena memory is always mapped, kept mapped buffers simply expose it
+    if(args->pInitialData)
+        memcpy(buffer->allocation.mappedData, args->pInitialData, buffer->size);
+    if(args->bKeepMapped)
+        buffer->mappedData = buffer->allocation.mappedData;
+    return VK_SUCCESS;
+}
+
+//only the caller's range is imported, so its start and its size must both be multiples of the import alignment
+static VkResult __importHostMemory(CeInstance instance, const CeBufferCreationArgs* args, CeBuffer buffer) {
+    VkDeviceSize alignment;
+    PFN_vkGetMemoryHostPointerPropertiesEXT getHostPointerProperties = ceGetInstanceHostPointerImport(instance, &alignment);
+    if(!getHostPointerProperties || !buffer->size || (alignment && ((uintptr_t)args->pHostMemory % alignment || buffer->size % alignment)))
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    VkDevice device = ceGetInstanceVulkanDevice(instance);
+    uint32_t familyIndex = ceGetInstanceVulkanQueueFamilyIndex(instance);
+    VkExternalMemoryBufferCreateInfo externalInfo = {
+        .sType = VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_BUFFER_CREATE_INFO,
+        .handleTypes = VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT,
+    };
+    VkBufferCreateInfo bufferInfo = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .pNext = &externalInfo,
+        .size = buffer->size,
+        .pQueueFamilyIndices = &familyIndex,
+        .queueFamilyIndexCount = 1,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+    };
+    VkResult result = vkCreateBuffer(device, &bufferInfo, NULL, &buffer->vulkanBuffer);
+    if(result != VK_SUCCESS)
+        return result;
+    VkMemoryRequirements memoryRequirements;
+    vkGetBufferMemoryRequirements(device, buffer->vulkanBuffer, &memoryRequirements);
+    VkMemoryHostPointerPropertiesEXT hostPointerProperties = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_HOST_POINTER_PROPERTIES_EXT,
+    };
+    //drivers refuse pointers they cannot pin, file mappings on some of them
+    result = getHostPointerProperties(device, VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT, args->pHostMemory, &hostPointerProperties);
+    if(result != VK_SUCCESS)
+        return result;
+    //only coherent memory lets the host see the device's writes without flushes
+    uint32_t memoryType = ceGetInstanceMemoryTypeIndex(instance, memoryRequirements.memoryTypeBits & hostPointerProperties.memoryTypeBits,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    //a driver asking for more memory than the buffer's size would need pages past the caller's allocation
+    if(memoryType == CE_INVALID_MEMORY_TYPE || memoryRequirements.size > buffer->size)
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    VkImportMemoryHostPointerInfoEXT importInfo = {
+        .sType = VK_STRUCTURE_TYPE_IMPORT_MEMORY_HOST_POINTER_INFO_EXT,
+        .handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT,
+        .pHostPointer = args->pHostMemory,
+    };
+    VkMemoryAllocateInfo allocInfo = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .pNext = &importInfo,
+        .allocationSize = buffer->size,
+        .memoryTypeIndex = memoryType,
+    };
+    result = vkAllocateMemory(device, &allocInfo, NULL, &buffer->importedMemory);
+    if(result != VK_SUCCESS)
+        return result;
+    return vkBindBufferMemory(device, buffer->vulkanBuffer, buffer->importedMemory, 0);
+}
+
+//64 bytes keeps every element of a cache line in the same buffer and lets kernels use aligned vector loads
+static VkResult __createCpuBuffer(CeCpuBackend cpuBackend, const CeBufferCreationArgs* args, CeBuffer buffer) {
+    if(args->pHostMemory) {
+        buffer->cpuMemory = args->pHostMemory;
+        return VK_SUCCESS;
+    }
+    buffer->cpuMemory = aligned_alloc(64, (buffer->size + 63) & ~(VkDeviceSize)63);
+    if(!buffer->cpuMemory)
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    buffer->ownsCpuMemory = CE_TRUE;
+    ceFillCpuMemory(cpuBackend, buffer->cpuMemory, args->pInitialData, buffer->size);
+    return VK_SUCCESS;
+}
+
+//whatever part of the buffer was created goes, ceDestroyBuffer handles partly created buffers
+static CeResult __failBufferCreation(CeInstance instance, CeBuffer* buffer, const char* message) {
+    ceDestroyBuffer(instance, *buffer);
+    *buffer = NULL;
+    return ceResult(CE_ERROR_INTERNAL, message);
+}
+
+CeResult
+ceCreateBufferUnflushed(CeInstance instance, const CeBufferCreationArgs* args, CeBuffer* buffer) {
+    if(!instance || !args || !buffer)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot create buffer: some parameters were NULL");
+    if(args->bKeepMapped && args->ePlacement == CE_BINDING_PLACEMENT_DEVICE_LOCAL)
+        return ceResult(CE_ERROR_INVALID_ARG, "cannot create buffer: device-local buffers cannot be kept mapped");
+    *buffer = calloc(1, sizeof(struct CeBuffer_t));
+    if(!*buffer)
+        return ceResult(CE_ERROR_INTERNAL, "stdlib failed to allocate a buffer");
+    (*buffer)->elementCount = args->uElementCount;
+    (*buffer)->size = (VkDeviceSize)args->uElementCount * args->uElementSize;
+    (*buffer)->hostMemory = args->pHostMemory;
+    CeCpuBackend cpuBackend = ceGetInstanceCpuBackend(instance);
+    if(cpuBackend) {
+        if(__createCpuBuffer(cpuBackend, args, *buffer) != VK_SUCCESS)
+            return __failBufferCreation(instance, buffer, "stdlib failed to allocate a buffer's memory");
+        return CE_SUCCESS;
+    }
+    if(!args->pHostMemory) {
+        if(__createVkBuffer(instance, args, *buffer) != VK_SUCCESS)
+            return __failBufferCreation(instance, buffer, "failed to create Vk buffer");
+        return CE_SUCCESS;
+    }
+    if(__importHostMemory(instance, args, *buffer) == VK_SUCCESS)
+        return CE_SUCCESS;
+    //the host memory could not be imported, the buffer gets memory of its own which starts as a copy of it
+    VkDevice device = ceGetInstanceVulkanDevice(instance);
+    vkDestroyBuffer(device, (*buffer)->vulkanBuffer, NULL);
+    vkFreeMemory(device, (*buffer)->importedMemory, NULL);
+    (*buffer)->vulkanBuffer = VK_NULL_HANDLE;
+    (*buffer)->importedMemory = VK_NULL_HANDLE;
+    CeBufferCreationArgs copyArgs = *args;
+    copyArgs.pInitialData = args->pHostMemory;
+    copyArgs.bKeepMapped = CE_FALSE;
+    if(__createVkBuffer(instance, &copyArgs, *buffer) != VK_SUCCESS)
+        return __failBufferCreation(instance, buffer, "failed to create Vk buffer");
+    return CE_SUCCESS;
+}
+
+CeResult
+ceCreateBuffer(CeInstance instance, const CeBufferCreationArgs* args, CeBuffer* buffer) {
+    CeResult result = ceCreateBufferUnflushed(instance, args, buffer);
+    if(result != CE_SUCCESS || ceGetInstanceCpuBackend(instance))
+        return result;
+    if(ceFlushStagingRing(instance, ceGetInstanceStagingRing(instance)) != VK_SUCCESS)
+        return ceResult(CE_ERROR_INTERNAL, "Vk failed to upload a buffer's initial data");
+    return CE_SUCCESS;
+}
+
+CeResult
+ceMapBufferMemory(CeInstance instance, CeBuffer buffer, void** target) {
+    if(!instance || !buffer || !target)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot map buffer memory: some parameters were NULL");
+    if(buffer->cpuMemory) {
+        *target = buffer->cpuMemory;
+        return CE_SUCCESS;
+    }
+    if(buffer->importedMemory) {
+        *target = buffer->hostMemory;
+        return CE_SUCCESS;
+    }
+    //kept mapped buffers and buffers that are already mapped hand out the existing mapping
+    if(buffer->mappedData) {
+        *target = buffer->mappedData;
+        return CE_SUCCESS;
+    }
+    if(!buffer->isStaged) {
+        *target = buffer->allocation.mappedData;
+        return CE_SUCCESS;
+    }
+    //the buffer is not host-visible: read it back into a host copy which is written back on unmap
+    void* hostCopy = malloc(buffer->size);
+    if(!hostCopy)
+        return ceResult(CE_ERROR_INTERNAL, "stdlib failed to allocate a host copy of a buffer");
+    CeStagingRing stagingRing = ceGetInstanceStagingRing(instance);
+    if(ceStagingDownload(instance, stagingRing, buffer->vulkanBuffer, 0, hostCopy, buffer->size) != VK_SUCCESS ||
+        ceFlushStagingRing(instance, stagingRing) != VK_SUCCESS) {
+        free(hostCopy);
+        return ceResult(CE_ERROR_INTERNAL, "Vk failed to read back a device-local buffer");
+    }
+    buffer->mappedData = *target = hostCopy;
+    return CE_SUCCESS;
+}
+
+void
+ceUnmapBufferMemory(CeInstance instance, CeBuffer buffer) {
+    //host-visible buffers stay persistently mapped by the memory arena
+    if(!buffer->isStaged || !buffer->mappedData)
+        return;
+    CeStagingRing stagingRing = ceGetInstanceStagingRing(instance);
+    if(ceStagingUpload(instance, stagingRing, buffer->vulkanBuffer, 0, buffer->mappedData, buffer->size) != VK_SUCCESS ||
+        ceFlushStagingRing(instance, stagingRing) != VK_SUCCESS)
+        ceResult(CE_ERROR_INTERNAL, "Vk failed to write back a device-local buffer");
+    free(buffer->mappedData);
+    buffer->mappedData = NULL;
+}
+
+CeBool32
+ceIsBufferHostMemoryImported(CeBuffer buffer) {
+    return buffer && (buffer->importedMemory || (buffer->hostMemory && buffer->cpuMemory == buffer->hostMemory)) ? CE_TRUE : CE_FALSE;
+}
+
+CeResult
+ceSyncBufferHostMemory(CeInstance instance, CeBuffer buffer, CeBool32 toDevice) {
+    if(!instance || !buffer)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot sync buffer host memory: some parameters were NULL");
+    if(!buffer->hostMemory)
+        return ceResult(CE_ERROR_INVALID_ARG, "cannot sync buffer host memory: the buffer was not created with pHostMemory");
+    if(buffer->importedMemory || buffer->cpuMemory)
+        return CE_SUCCESS;
+    if(!buffer->isStaged) {
+        if(toDevice)
+            memcpy(buffer->allocation.mappedData, buffer->hostMemory, buffer->size);
+        else
+            memcpy(buffer->hostMemory, buffer->allocation.mappedData, buffer->size);
+        return CE_SUCCESS;
+    }
+    CeStagingRing stagingRing = ceGetInstanceStagingRing(instance);
+    VkResult result = toDevice ?
+        ceStagingUpload(instance, stagingRing, buffer->vulkanBuffer, 0, buffer->hostMemory, buffer->size) :
+        ceStagingDownload(instance, stagingRing, buffer->vulkanBuffer, 0, buffer->hostMemory, buffer->size);
+    if(result != VK_SUCCESS || ceFlushStagingRing(instance, stagingRing) != VK_SUCCESS)
+        return ceResult(CE_ERROR_INTERNAL, "Vk failed to copy a buffer's host memory");
+    return CE_SUCCESS;
+}
+
+VkBuffer
+ceGetBufferVulkanBuffer(CeBuffer buffer) {
+    return buffer->vulkanBuffer;
+}
+
+VkDeviceSize
+ceGetBufferSize(CeBuffer buffer) {
+    return buffer->size;
+}
+
+uint32_t
+ceGetBufferElementCount(CeBuffer buffer) {
+    return buffer->elementCount;
+}
+
+void*
+ceGetBufferMappedData(CeBuffer buffer) {
+    return buffer->cpuMemory ? buffer->cpuMemory : buffer->mappedData;
+}
+
+void*
+ceGetBufferCpuMemory(CeBuffer buffer) {
+    return buffer->cpuMemory;
+}
+
+void
+ceDestroyBuffer(CeInstance instance, CeBuffer buffer) {
+    if(!buffer)
+        return;
+    if(ceGetInstanceCpuBackend(instance)) {
+        if(buffer->ownsCpuMemory)
+            free(buffer->cpuMemory);
+        free(buffer);
+        return;
+    }
+    if(buffer->isStaged)
+        free(buffer->mappedData);
+    vkDestroyBuffer(ceGetInstanceVulkanDevice(instance), buffer->vulkanBuffer, NULL);
+    if(buffer->importedMemory)
+        vkFreeMemory(ceGetInstanceVulkanDevice(instance), buffer->importedMemory, NULL);
+    ceArenaFree(instance, ceGetInstanceMemoryArena(instance), &buffer->allocation);
+    free(buffer);
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include "ce-def.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t uElementSize;
+    uint32_t uElementCount;
+    void* pInitialData;
+    CeBool32 bKeepMapped;
+    CeBindingPlacement ePlacement;
+    //if not NULL the buffer is this host memory (a malloc'd or mmap'd region) and ignores the initial data, mapping and placement.
+    //it **must** stay valid until the buffer is destroyed, see ceSyncBufferHostMemory for devices which cannot import it
+    void* pHostMemory;
+} CeBufferCreationArgs;
+
+/**
+* Create a CE buffer which can be bound to any number of pipelines created from the same instance.
+* \param instance the instance the buffer is going to be created from
+* \param args pointer to a CeBufferCreationArgs structure containing parameters for buffer creation
+* \param buffer the buffer handle the function writes to
+*/
+CeResult
+ceCreateBuffer(CeInstance instance, const CeBufferCreationArgs* args, CeBuffer* buffer);
+
+/**
+* Map a buffer's memory and write its address to a supplied pointer.
+* Device-local buffers are read back into a host copy which is written back by ceUnmapBufferMemory.
+*/
+CeResult
+ceMapBufferMemory(CeInstance, CeBuffer, void**);
+
+void
+ceUnmapBufferMemory(CeInstance, CeBuffer);
+
+/**
+* Whether a buffer created with pHostMemory uses that memory directly.
+* Devices without VK_EXT_external_memory_host, and pointers or sizes which are not aligned
+* to the device's minImportedHostPointerAlignment, get a buffer of their own which the host memory is copied to.
+*/
+CeBool32
+ceIsBufferHostMemoryImported(CeBuffer);
+
+/**
+* Copy between a buffer and the host memory it was created with, if it could not be imported.
+* bToDevice copies host writes made since creation to the buffer, otherwise the device's writes are copied to the host memory.
+* Imported buffers need no copy, the device's writes are in the host memory once the commands writing them completed.
+*/
+CeResult
+ceSyncBufferHostMemory(CeInstance, CeBuffer, CeBool32 bToDevice);
+
+/**
+* Destroy a CE buffer. 
+* Pipelines using the buffer **must** be destroyed first.
+*/
+void
+ceDestroyBuffer(CeInstance, CeBuffer);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,57 @@
+#pragma once
+#include "ce-def.h"
+#include "ce-command.h"
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan_core.h>
+
+VkCommandBuffer
+ceGetCommandVulkanCommandBuffer(CeCommand);
+
+
+//records a compute to compute barrier
+void
+ceRecordCommandBarrier(CeCommand, CeBool32 bMemoryBarrier, const VkBufferMemoryBarrier* pBufferBarriers, uint32_t uBufferBarrierCount);
+
+//records a copy of source to destination, as much of it as destination holds, followed by a barrier making it visible to
+//the shaders and indirect dispatches recorded after it
+void
+ceRecordCommandCopy(CeCommand, CeBuffer source, CeBuffer destination);
+
+//records everything recorded to source since it was begun, source can then be reset or destroyed
+CeResult
+ceAppendCommandOps(CeCommand, CeCommand source);
+
+//makes the next run of the command wait on the device for the last run of after, or on the host without timeline semaphores
+void
+ceSetCommandRunAfter(CeCommand, CeCommand after);
+
+//submissions are numbered from 1 by ceRunCommand, 0 means the command was never run
+CeBool32
+ceIsCommandSubmissionDone(CeInstance, CeCommand, uint64_t submission);
+
+VkResult
+ceWaitCommandSubmissions(CeInstance, const CeCommand*, const uint64_t* submissions, uint32_t count, CeBool32 waitAll, uint64_t timeout);
+
+//ceRunCommands without flushing the batches the commands are queued in
+CeResult
+ceSubmitCommands(CeInstance, const CeCommand*, uint32_t count);
+
+//the batch the command was queued in and not submitted by yet, NULL when there is none
+CeSubmitBatch
+ceGetCommandQueuedBatch(CeCommand);
+
+void
+ceSetCommandQueuedBatch(CeCommand, CeSubmitBatch);
+
+//records that the batch holding the command's latest run failed to submit it, waiting on or querying the command returns it
+void
+ceSetCommandQueuedRunResult(CeCommand, CeResult);
+
+//submits the commands queued in the batch, unlike ceFlushSubmitBatch it leaves the failures of earlier flushes to be reported
+CeResult
+ceSubmitQueuedCommands(CeSubmitBatch);
+
+//the semaphore the command's last run signals and the value it signals it to, after submitting the command's batch if needed.
+//the semaphore is VK_NULL_HANDLE without timeline semaphores, returns CE_FALSE if the batch could not be submitted
+CeBool32
+ceGetCommandLastRunSemaphore(CeInstance, CeCommand, VkSemaphore*, uint64_t* pValue);
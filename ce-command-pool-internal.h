@@ -0,0 +1,35 @@
+#pragma once
+#include "ce-def.h"
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan_core.h>
+
+/*
+* The command pool set gives every thread its own VkCommandPool, created the first time the thread
+* allocates a command buffer, so threads can allocate and record without waiting on each other.
+* The pool of a thread which exits is handed to the next thread needing one.
+*/
+typedef struct CeCommandPoolSet_t *CeCommandPoolSet;
+typedef struct CeCommandPool_t *CeCommandPool;
+
+VkResult
+ceCreateCommandPoolSet(CeInstance, uint32_t queueFamilyIndex, CeCommandPoolSet*);
+
+//allocates from the calling thread's pool and writes which pool the buffer belongs to
+VkResult
+ceAllocateCommandBuffer(CeInstance, CeCommandPoolSet, VkCommandBufferLevel, CeCommandPool*, VkCommandBuffer*);
+
+//can be called from any thread, a buffer freed away from its pool's thread is freed by that thread on its next allocation
+void
+ceFreeCommandBuffer(CeInstance, CeCommandPool, VkCommandBuffer);
+
+//must be held while recording to, resetting or beginning a buffer of the pool,
+//it is only ever contended when a buffer is used away from the thread it was allocated on
+void
+ceLockCommandPool(CeCommandPool);
+
+void
+ceUnlockCommandPool(CeCommandPool);
+
+//every buffer still allocated from the set is freed along with it
+void
+ceDestroyCommandPoolSet(CeInstance, CeCommandPoolSet);
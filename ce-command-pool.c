@@ -0,0 +1,185 @@
+#include "ce-command-pool-internal.h"
+#include "ce-def.h"
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan_core.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "ce-instance-internal.h"
+
+struct CeDeferredFree {
+    struct CeDeferredFree* next;
+    VkCommandBuffer commandBuffer;
+};
+
+struct CeCommandPool_t {
+    CeCommandPoolSet set;
+    VkCommandPool vulkanCommandPool;
+    pthread_mutex_t mutex;
+    //buffers freed by other threads, pushed without taking the pool's lock
+    _Atomic(struct CeDeferredFree*) deferredFrees;
+    //cleared when the thread the pool belongs to exits
+    atomic_bool hasOwner;
+    struct CeCommandPool_t* next;
+    struct CeCommandPool_t* nextOrphan;
+};
+
+struct CeCommandPoolSet_t {
+    VkDevice vulkanDevice;
+    uint32_t queueFamilyIndex;
+    pthread_key_t threadPoolKey;
+    //only taken when a thread gets its pool for the first time or exits
+    pthread_mutex_t mutex;
+    CeCommandPool pools;
+    CeCommandPool orphans;
+};
+
+//the pool's lock must be held
+static void __freeDeferred(CeCommandPool pool) {
+    struct CeDeferredFree* entry = atomic_exchange(&pool->deferredFrees, NULL);
+    while(entry) {
+        struct CeDeferredFree* next = entry->next;
+        vkFreeCommandBuffers(pool->set->vulkanDevice, pool->vulkanCommandPool, 1, &entry->commandBuffer);
+        free(entry);
+        entry = next;
+    }
+}
+
+static void __orphanThreadPool(void* pPool) {
+    CeCommandPool pool = pPool;
+    CeCommandPoolSet set = pool->set;
+    pthread_mutex_lock(&set->mutex);
+    pthread_mutex_lock(&pool->mutex);
+    atomic_store(&pool->hasOwner, CE_FALSE);
+    __freeDeferred(pool);
+    pthread_mutex_unlock(&pool->mutex);
+    pool->nextOrphan = set->orphans;
+    set->orphans = pool;
+    pthread_mutex_unlock(&set->mutex);
+}
+
+VkResult
+ceCreateCommandPoolSet(CeInstance instance, uint32_t queueFamilyIndex, CeCommandPoolSet* target) {
+    CeCommandPoolSet set = calloc(1, sizeof(struct CeCommandPoolSet_t));
+    if(!set)
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    if(pthread_key_create(&set->threadPoolKey, __orphanThreadPool)) {
+        free(set);
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+    set->vulkanDevice = ceGetInstanceVulkanDevice(instance);
+    set->queueFamilyIndex = queueFamilyIndex;
+    pthread_mutex_init(&set->mutex, NULL);
+    *target = set;
+    return VK_SUCCESS;
+}
+
+static VkResult __getThreadPool(CeCommandPoolSet set, CeCommandPool* target) {
+    CeCommandPool pool = pthread_getspecific(set->threadPoolKey);
+    if(pool) {
+        *target = pool;
+        return VK_SUCCESS;
+    }
+    pthread_mutex_lock(&set->mutex);
+    if(set->orphans) {
+        pool = set->orphans;
+        set->orphans = pool->nextOrphan;
+    } else {
+        pool = calloc(1, sizeof(struct CeCommandPool_t));
+        if(!pool) {
+            pthread_mutex_unlock(&set->mutex);
+            return VK_ERROR_OUT_OF_HOST_MEMORY;
+        }
+        VkCommandPoolCreateInfo poolInfo = {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+            .queueFamilyIndex = set->queueFamilyIndex,
+            .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+        };
+        VkResult result = vkCreateCommandPool(set->vulkanDevice, &poolInfo, NULL, &pool->vulkanCommandPool);
+        if(result != VK_SUCCESS) {
+            pthread_mutex_unlock(&set->mutex);
+            free(pool);
+            return result;
+        }
+        pool->set = set;
+        pthread_mutex_init(&pool->mutex, NULL);
+        atomic_init(&pool->deferredFrees, NULL);
+        pool->next = set->pools;
+        set->pools = pool;
+    }
+    atomic_store(&pool->hasOwner, CE_TRUE);
+    pthread_mutex_unlock(&set->mutex);
+    pthread_setspecific(set->threadPoolKey, pool);
+    *target = pool;
+    return VK_SUCCESS;
+}
+
+VkResult
+ceAllocateCommandBuffer(CeInstance instance, CeCommandPoolSet set, VkCommandBufferLevel level, CeCommandPool* pPool, VkCommandBuffer* target) {
+    CeCommandPool pool;
+    VkResult result = __getThreadPool(set, &pool);
+    if(result != VK_SUCCESS)
+        return result;
+    VkCommandBufferAllocateInfo allocInfo = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .commandPool = pool->vulkanCommandPool,
+        .level = level,
+        .commandBufferCount = 1,
+    };
+    pthread_mutex_lock(&pool->mutex);
+    __freeDeferred(pool);
+    result = vkAllocateCommandBuffers(set->vulkanDevice, &allocInfo, target);
+    pthread_mutex_unlock(&pool->mutex);
+    if(result == VK_SUCCESS)
+        *pPool = pool;
+    return result;
+}
+
+void
+ceFreeCommandBuffer(CeInstance instance, CeCommandPool pool, VkCommandBuffer commandBuffer) {
+    if(!pool || !commandBuffer)
+        return;
+    //the pool's thread is busy recording with it, so rather than waiting on it the free is left for later
+    if(pthread_getspecific(pool->set->threadPoolKey) != pool && atomic_load(&pool->hasOwner)) {
+        struct CeDeferredFree* entry = malloc(sizeof(struct CeDeferredFree));
+        if(entry) {
+            entry->commandBuffer = commandBuffer;
+            entry->next = atomic_load(&pool->deferredFrees);
+            while(!atomic_compare_exchange_weak(&pool->deferredFrees, &entry->next, entry));
+            return;
+        }
+    }
+    pthread_mutex_lock(&pool->mutex);
+    vkFreeCommandBuffers(pool->set->vulkanDevice, pool->vulkanCommandPool, 1, &commandBuffer);
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+void
+ceLockCommandPool(CeCommandPool pool) {
+    pthread_mutex_lock(&pool->mutex);
+}
+
+void
+ceUnlockCommandPool(CeCommandPool pool) {
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+void
+ceDestroyCommandPoolSet(CeInstance instance, CeCommandPoolSet set) {
+    if(!set)
+        return;
+    pthread_key_delete(set->threadPoolKey);
+    for(CeCommandPool pool = set->pools, next; pool; pool = next) {
+        next = pool->next;
+        //destroying the pool frees its buffers, only the bookkeeping of the deferred ones is left
+        for(struct CeDeferredFree* entry = atomic_load(&pool->deferredFrees), *nextEntry; entry; entry = nextEntry) {
+            nextEntry = entry->next;
+            free(entry);
+        }
+        vkDestroyCommandPool(set->vulkanDevice, pool->vulkanCommandPool, NULL);
+        pthread_mutex_destroy(&pool->mutex);
+        free(pool);
+    }
+    pthread_mutex_destroy(&set->mutex);
+    free(set);
+}
@@ -6,19 +6,295 @@
 #include <vulkan/vulkan.h>
 #include <vulkan/vulkan_core.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
 #include "ce-instance-internal.h"
 #include "ce-pipeline-internal.h"
 #include "ce-error-internal.h"
 #include "ce-pipeline.h"
+#include "ce-command-internal.h"
+#include "ce-trace-internal.h"
+#include "ce-command-pool-internal.h"
+#include "ce-transfer-internal.h"
+#include "ce-buffer-internal.h"
+
+#define CE_DEFAULT_MAX_PROFILED_PIPELINES 64
+//runs of a command with live constants which can be in flight before the next one waits for the oldest
+#define CE_MAX_LIVE_SLOTS 4
+
+//the command's own copy of the live constants of a pipeline, made the first time the pipeline is recorded to it
+struct CeLiveRegion {
+    CePipeline pipeline;
+    //device-local, read by the shader in place of the pipeline's live constant buffer
+    CeBuffer buffer;
+    VkDescriptorPool descriptorPool;
+    //the pipeline's bindings and buffer, bound when the pipeline is recorded
+    VkDescriptorSet descriptorSet;
+};
+
+//a region written by each run, of the command or of one of its secondary commands, whose values are at offset in each live slot
+struct CeLiveCopy {
+    CePipeline pipeline;
+    CeBuffer buffer;
+    uint32_t offset;
+};
+
+//holds the live constants of a run, which are copied to the live regions right before the run
+struct CeLiveSlot {
+    //host-visible and kept mapped
+    CeBuffer values;
+    void* mappedValues;
+    //recorded once with the copy of every region, submitted ahead of the command's own buffer
+    VkCommandBuffer copyCommand;
+    CeCommandPool copyCommandPool;
+    //the run which last read the slot, 0 if none did
+    uint64_t submission;
+};
 
 struct CeCommand_t {
-    VkQueue vulkanQueue;
+    //the live regions are created with it while recording
+    CeInstance instance;
     VkCommandBuffer commandBuffer;
+    //the pool of the thread the command was created on, locked around everything recorded to the buffer
+    CeCommandPool commandPool;
+    //signalled by each run, only used when the instance has no timeline semaphores
     VkFence commandFence;
-    uint32_t vulkanQueueIndex;
-    uint32_t workGroupCount;
+    //replaces commandFence when the latest run was submitted along with other commands
+    struct CeBatchFence* batchFence;
+    //reaches submissionCount when the last run completes, VK_NULL_HANDLE without timeline semaphores
+    VkSemaphore timelineSemaphore;
+    //number of times the command was run
+    uint64_t submissionCount;
+    //queue of the last run, given back to the scheduler once that run is seen completed
+    atomic_uint scheduledQueue;
+    _Atomic(CeSubmitBatch) queuedBatch;
+    //why the batch holding the command's latest run failed to submit it, CE_SUCCESS once a run is submitted
+    _Atomic(CeResult) queuedRunResult;
+    //transfers the next run waits for on the device
+    CeTransfer* transferWaits;
+    uint32_t transferWaitCount;
+    uint32_t transferWaitCapacity;
+    //the next run waits on the device for the last run of this command to complete, NULL when it does not
+    CeCommand runAfter;
+    //two timestamps per profiled pipeline, VK_NULL_HANDLE when profiling is off
+    VkQueryPool timestampQueryPool;
+    //one invocation count per profiled pipeline, VK_NULL_HANDLE when statistics are off
+    VkQueryPool statisticsQueryPool;
+    CePipeline* profiledPipelines;
+    uint32_t profiledPipelineCount;
+    uint32_t maxProfiledPipelines;
+    CeBool32 isSecondary;
+    //everything recorded since ceBeginCommand, what CPU runs go through and where pipelines with live constants are found
+    struct CeCommandOp* ops;
+    uint32_t opCount;
+    uint32_t opCapacity;
+    //one per pipeline with live constants ever recorded to the command, kept until it is destroyed
+    struct CeLiveRegion* liveRegions;
+    uint32_t liveRegionCount;
+    uint32_t liveRegionCapacity;
+    //the regions of the command and of its secondary commands recorded since ceBeginCommand, gathered when it is first run
+    struct CeLiveCopy* liveCopies;
+    uint32_t liveCopyCount;
+    uint32_t liveCopyCapacity;
+    //the size of the live constants of a run, the sum of the copies' sizes
+    uint32_t liveValueSize;
+    //set when something was recorded since the copies were gathered
+    CeBool32 liveCopiesAreStale;
+    struct CeLiveSlot liveSlots[CE_MAX_LIVE_SLOTS];
+    uint32_t liveSlotCount;
+    //only set on CPU instances, the op list is then all there is and runs on the host when the command is submitted
+    CeCpuBackend cpuBackend;
 };
 
+//a fence signalled by runs submitted together, destroyed once every command of the batch moved on to another run
+struct CeBatchFence {
+    VkFence vulkanFence;
+    atomic_uint refCount;
+};
+
+enum CeCommandOpType {
+    CE_COMMAND_OP_PIPELINE,
+    CE_COMMAND_OP_SECONDARY,
+    CE_COMMAND_OP_BARRIER,
+    CE_COMMAND_OP_COPY,
+};
+
+struct CeCommandOp {
+    enum CeCommandOpType type;
+    CePipeline pipeline;
+    CeCommand secondary;
+    CeBool32 hasMemoryBarrier;
+    VkBufferMemoryBarrier* bufferBarriers;
+    uint32_t bufferBarrierCount;
+    CeBuffer copySource;
+    CeBuffer copyDestination;
+};
+
+//liveDescriptorSet is the set of the command's live region for the pipeline, VK_NULL_HANDLE when it has no live constants
+static void __recordPipelineInline(CeCommand command, CePipeline pipeline, VkDescriptorSet liveDescriptorSet) {
+    vkCmdBindPipeline(command->commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, ceGetPipelineVulkanPipeline(pipeline));
+    VkDescriptorSet pipeDescSet = liveDescriptorSet ? liveDescriptorSet : ceGetPipelineVulkanDescriptorSet(pipeline);
+    vkCmdBindDescriptorSets(command->commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, ceGetPipelineVulkanPipelineLayout(pipeline), 0, 1,
+     &pipeDescSet, 0, NULL);
+    
+    const uint32_t constantCount = ceGetPipelineConstantCount(pipeline);
+    for(uint32_t i = 0; i < constantCount; ++i) {
+        //live constants are read from the command's live region
+        if(ceGetPipelineConstantIsLive(pipeline, i))
+            continue;
+        uint32_t dataOffset;
+        CePipelineConstantInfo constInfo;
+        ceGetPipelineConstantData(pipeline, 
+        i, &constInfo.pData, &constInfo.uDataSize, &dataOffset);
+        vkCmdPushConstants(command->commandBuffer, 
+        ceGetPipelineVulkanPipelineLayout(pipeline), VK_SHADER_STAGE_COMPUTE_BIT, dataOffset, constInfo.uDataSize, constInfo.pData);
+    }
+    ceRecordPipelineDispatch(command->commandBuffer, pipeline);
+}
+
+VkCommandBuffer
+ceGetCommandVulkanCommandBuffer(CeCommand command) {
+    return command->commandBuffer;
+}
+
+static void __recordOp(CeCommand command, const struct CeCommandOp* op, VkDescriptorSet liveDescriptorSet) {
+    if(op->type == CE_COMMAND_OP_COPY) {
+        const VkDeviceSize sourceSize = ceGetBufferSize(op->copySource), destinationSize = ceGetBufferSize(op->copyDestination);
+        VkBufferCopy region = {
+            .size = sourceSize < destinationSize ? sourceSize : destinationSize,
+        };
+        vkCmdCopyBuffer(command->commandBuffer, ceGetBufferVulkanBuffer(op->copySource), ceGetBufferVulkanBuffer(op->copyDestination),
+            1, &region);
+        VkMemoryBarrier memoryBarrier = {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT,
+        };
+        vkCmdPipelineBarrier(command->commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &memoryBarrier, 0, NULL, 0, NULL);
+        return;
+    }
+    if(op->type == CE_COMMAND_OP_SECONDARY) {
+        vkCmdExecuteCommands(command->commandBuffer, 1, &op->secondary->commandBuffer);
+        return;
+    }
+    if(op->type == CE_COMMAND_OP_BARRIER) {
+        VkMemoryBarrier memoryBarrier = {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT,
+        };
+        //indirect dispatches read their counts in the draw indirect stage, before the shader runs
+        vkCmdPipelineBarrier(command->commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+            op->hasMemoryBarrier ? 1 : 0, &memoryBarrier, op->bufferBarrierCount, op->bufferBarriers, 0, NULL);
+        return;
+    }
+
+    CeBool32 isProfiled = command->timestampQueryPool && command->profiledPipelineCount < command->maxProfiledPipelines;
+    const uint32_t profileIndex = command->profiledPipelineCount;
+    if(isProfiled) {
+        command->profiledPipelines[profileIndex] = op->pipeline;
+        ++command->profiledPipelineCount;
+        vkCmdWriteTimestamp(command->commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, command->timestampQueryPool, profileIndex * 2);
+        if(command->statisticsQueryPool)
+            vkCmdBeginQuery(command->commandBuffer, command->statisticsQueryPool, profileIndex, 0);
+    }
+    //queries cannot be active across a secondary command buffer without inherited queries, so counted pipelines are recorded inline,
+    //and so are pipelines with live constants, which bind the command's set instead of the pipeline's
+    if(ceGetPipelineVulkanCommand(op->pipeline) && !liveDescriptorSet && !(isProfiled && command->statisticsQueryPool)) {
+        VkCommandBuffer pipeBuf = ceGetPipelineVulkanCommand(op->pipeline);
+        vkCmdExecuteCommands(command->commandBuffer, 1, &pipeBuf);    
+    } else {
+        __recordPipelineInline(command, op->pipeline, liveDescriptorSet);
+    }
+    if(isProfiled) {
+        if(command->statisticsQueryPool)
+            vkCmdEndQuery(command->commandBuffer, command->statisticsQueryPool, profileIndex);
+        vkCmdWriteTimestamp(command->commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, command->timestampQueryPool, profileIndex * 2 + 1);
+    }
+}
+
+//the region of a pipeline with live constants, created the first time the pipeline is recorded to the command
+static VkResult __acquireLiveRegion(CeCommand command, CePipeline pipeline, VkDescriptorSet* target) {
+    for(uint32_t i = 0; i < command->liveRegionCount; ++i) {
+        if(command->liveRegions[i].pipeline == pipeline) {
+            *target = command->liveRegions[i].descriptorSet;
+            return VK_SUCCESS;
+        }
+    }
+    if(command->liveRegionCount == command->liveRegionCapacity) {
+        const uint32_t capacity = command->liveRegionCapacity ? command->liveRegionCapacity * 2 : 4;
+        struct CeLiveRegion* regions = realloc(command->liveRegions, capacity * sizeof(struct CeLiveRegion));
+        if(!regions)
+            return VK_ERROR_OUT_OF_HOST_MEMORY;
+        command->liveRegions = regions;
+        command->liveRegionCapacity = capacity;
+    }
+    struct CeLiveRegion region = {
+        .pipeline = pipeline,
+    };
+    CeBufferCreationArgs bufferArgs = {
+        .uElementSize = sizeof(uint32_t),
+        .uElementCount = ceGetPipelineLiveConstantSize(pipeline) / sizeof(uint32_t),
+        .ePlacement = CE_BINDING_PLACEMENT_DEVICE_LOCAL,
+    };
+    if(ceCreateBuffer(command->instance, &bufferArgs, &region.buffer) != CE_SUCCESS)
+        return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+    VkResult result = ceCreatePipelineLiveDescriptorSet(command->instance, pipeline, region.buffer,
+        &region.descriptorPool, &region.descriptorSet);
+    if(result != VK_SUCCESS) {
+        ceDestroyBuffer(command->instance, region.buffer);
+        return result;
+    }
+    command->liveRegions[command->liveRegionCount++] = region;
+    *target = region.descriptorSet;
+    return VK_SUCCESS;
+}
+
+static void __destroyLiveRegions(CeInstance instance, CeCommand command) {
+    for(uint32_t i = 0; i < command->liveRegionCount; ++i) {
+        vkDestroyDescriptorPool(ceGetInstanceVulkanDevice(instance), command->liveRegions[i].descriptorPool, NULL);
+        ceDestroyBuffer(instance, command->liveRegions[i].buffer);
+    }
+    free(command->liveRegions);
+    command->liveRegions = NULL;
+    command->liveRegionCount = command->liveRegionCapacity = 0;
+}
+
+//takes ownership of the op's barriers, freeing them when it fails
+static CeResult __appendOp(CeCommand command, const struct CeCommandOp* op) {
+    VkDescriptorSet liveDescriptorSet = VK_NULL_HANDLE;
+    if(op->type == CE_COMMAND_OP_PIPELINE && !command->cpuBackend && ceGetPipelineLiveConstantSize(op->pipeline) &&
+        __acquireLiveRegion(command, op->pipeline, &liveDescriptorSet) != VK_SUCCESS) {
+        return ceResult(CE_ERROR_INTERNAL, "cannot record pipeline: failed to create the command's copy of its live constants");
+    }
+    if(command->opCount == command->opCapacity) {
+        const uint32_t capacity = command->opCapacity ? command->opCapacity * 2 : 8;
+        struct CeCommandOp* ops = realloc(command->ops, capacity * sizeof(struct CeCommandOp));
+        if(!ops) {
+            free(op->bufferBarriers);
+            return ceResult(CE_ERROR_INTERNAL, "stdlib failed to grow the op list of a command");
+        }
+        command->ops = ops;
+        command->opCapacity = capacity;
+    }
+    command->ops[command->opCount++] = *op;
+    command->liveCopiesAreStale = CE_TRUE;
+    if(command->cpuBackend)
+        return CE_SUCCESS;
+    ceLockCommandPool(command->commandPool);
+    __recordOp(command, op, liveDescriptorSet);
+    ceUnlockCommandPool(command->commandPool);
+    return CE_SUCCESS;
+}
+
+static void __clearOps(CeCommand command) {
+    for(uint32_t i = 0; i < command->opCount; ++i)
+        free(command->ops[i].bufferBarriers);
+    command->opCount = 0;
+    command->liveCopiesAreStale = CE_TRUE;
+}
 
 CeResult 
 ceRecordToCommand(const CeCommandRecordingArgs* args, CeCommand command) {
@@ -28,97 +304,771 @@ ceRecordToCommand(const CeCommandRecordingArgs* args, CeCommand command) {
         return ceResult(CE_ERROR_INVALID_ARG, "cannot record pipeline: none passed");
     if(args->bRecordCommand && !args->pSuppliedCommand)
         return ceResult(CE_ERROR_INVALID_ARG, "cannot record secondary command: none passed");
-    if(args->bRecordCommand) {
-        vkCmdExecuteCommands(command->commandBuffer, 1, &args->pSuppliedCommand->commandBuffer);
-    } else if(ceGetPipelineVulkanCommand(args->pSuppliedPipeline)) {
-        VkCommandBuffer pipeBuf = ceGetPipelineVulkanCommand(args->pSuppliedPipeline);
-        vkCmdExecuteCommands(command->commandBuffer, 1, &pipeBuf);    
-    } else {
-        vkCmdBindPipeline(command->commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, ceGetPipelineVulkanPipeline(args->pSuppliedPipeline));
-        VkDescriptorSet pipeDescSet = ceGetPipelineVulkanDescriptorSet(args->pSuppliedPipeline);
-        vkCmdBindDescriptorSets(command->commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, ceGetPipelineVulkanPipelineLayout(args->pSuppliedPipeline), 0, 1,
-         &pipeDescSet, 0, NULL);
-        
-        const uint32_t constantCount = ceGetPipelineConstantCount(args->pSuppliedPipeline);
-        for(uint32_t i = 0; i < constantCount; ++i) {
-            uint32_t dataOffset;
-            CePipelineConstantInfo constInfo;
-            ceGetPipelineConstantData(args->pSuppliedPipeline, 
-            i, &constInfo.pData, &constInfo.uDataSize, &dataOffset);
-            vkCmdPushConstants(command->commandBuffer, 
-            ceGetPipelineVulkanPipelineLayout(args->pSuppliedPipeline), VK_SHADER_STAGE_COMPUTE_BIT, dataOffset, constInfo.uDataSize, constInfo.pData);
-        }
-        vkCmdDispatch(command->commandBuffer, 
-        ceGetPipelineDispatchWorkgroupCount(args->pSuppliedPipeline),
-         1, 1);
+    struct CeCommandOp op = {
+        .type = args->bRecordCommand ? CE_COMMAND_OP_SECONDARY : CE_COMMAND_OP_PIPELINE,
+    };
+    if(args->bRecordCommand)
+        op.secondary = args->pSuppliedCommand;
+    else
+        op.pipeline = args->pSuppliedPipeline;
+    return __appendOp(command, &op);
+}
+
+void
+ceRecordCommandBarrier(CeCommand command, CeBool32 bMemoryBarrier, const VkBufferMemoryBarrier* pBufferBarriers, uint32_t uBufferBarrierCount) {
+    struct CeCommandOp op = {
+        .type = CE_COMMAND_OP_BARRIER,
+        .hasMemoryBarrier = bMemoryBarrier,
+        .bufferBarrierCount = uBufferBarrierCount,
+    };
+    if(uBufferBarrierCount) {
+        op.bufferBarriers = malloc(uBufferBarrierCount * sizeof(VkBufferMemoryBarrier));
+        memcpy(op.bufferBarriers, pBufferBarriers, uBufferBarrierCount * sizeof(VkBufferMemoryBarrier));
+    }
+    __appendOp(command, &op);
+}
+
+void
+ceRecordCommandCopy(CeCommand command, CeBuffer source, CeBuffer destination) {
+    struct CeCommandOp op = {
+        .type = CE_COMMAND_OP_COPY,
+        .copySource = source,
+        .copyDestination = destination,
+    };
+    __appendOp(command, &op);
+}
+
+CeResult
+ceAppendCommandOps(CeCommand command, CeCommand source) {
+    for(uint32_t i = 0; i < source->opCount; ++i) {
+        struct CeCommandOp op = source->ops[i];
+        //each command frees its own barriers
+        if(op.bufferBarrierCount) {
+            op.bufferBarriers = malloc(op.bufferBarrierCount * sizeof(VkBufferMemoryBarrier));
+            if(!op.bufferBarriers)
+                return ceResult(CE_ERROR_INTERNAL, "stdlib failed to allocate the barriers of a command");
+            memcpy(op.bufferBarriers, source->ops[i].bufferBarriers, op.bufferBarrierCount * sizeof(VkBufferMemoryBarrier));
+        }
+        CeResult result = __appendOp(command, &op);
+        if(result != CE_SUCCESS)
+            return result;
     }
     return CE_SUCCESS;
 }
 
+void
+ceSetCommandRunAfter(CeCommand command, CeCommand after) {
+    command->runAfter = after;
+}
+
+static VkResult __createProfilingQueryPools(CeInstance instance, const CeCommandCreationArgs* args, CeCommand command) {
+    command->maxProfiledPipelines = args->uMaxProfiledPipelines ? args->uMaxProfiledPipelines : CE_DEFAULT_MAX_PROFILED_PIPELINES;
+    command->profiledPipelines = calloc(command->maxProfiledPipelines, sizeof(CePipeline));
+    if(!command->profiledPipelines)
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    VkQueryPoolCreateInfo timestampInfo = {
+        .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+        .queryType = VK_QUERY_TYPE_TIMESTAMP,
+        .queryCount = command->maxProfiledPipelines * 2,
+    };
+    VkResult result = vkCreateQueryPool(ceGetInstanceVulkanDevice(instance), &timestampInfo, NULL, &command->timestampQueryPool);
+    if(result != VK_SUCCESS) {
+        command->timestampQueryPool = VK_NULL_HANDLE;
+        return result;
+    }
+    //silently skipped on devices which cannot count invocations, their profiles report 0
+    if(!args->bEnablePipelineStatistics || !ceGetInstanceVulkanEnabledFeatures(instance)->pipelineStatisticsQuery)
+        return VK_SUCCESS;
+    VkQueryPoolCreateInfo statisticsInfo = {
+        .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+        .queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS,
+        .queryCount = command->maxProfiledPipelines,
+        .pipelineStatistics = VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT,
+    };
+    result = vkCreateQueryPool(ceGetInstanceVulkanDevice(instance), &statisticsInfo, NULL, &command->statisticsQueryPool);
+    if(result != VK_SUCCESS)
+        command->statisticsQueryPool = VK_NULL_HANDLE;
+    return result;
+}
+
+static CeResult __failCommandCreation(CeInstance instance, CeCommand* command, CeResult result, const char* message) {
+    ceDestroyCommand(instance, *command);
+    *command = NULL;
+    return ceResult(result, message);
+}
+
 CeResult
 ceCreateCommand(CeInstance instance, const CeCommandCreationArgs* args, CeCommand* target) {
     if(!instance || !args || !target)
         return ceResult(CE_ERROR_NULL_PASSED, "cannot create commands: some necessary parameters were NULL");
 
-    *target = malloc(sizeof(struct CeCommand_t));
-    (*target)->vulkanQueueIndex = ceGetInstanceNextFreeQueue(instance);
-    ceSetInstanceQueueToBusy(instance, (*target)->vulkanQueueIndex);
+    *target = calloc(1, sizeof(struct CeCommand_t));
+    if(!*target)
+        return ceResult(CE_ERROR_INTERNAL, "stdlib failed to allocate a command");
+    (*target)->instance = instance;
+    (*target)->isSecondary = args->bIsSecondaryCommand;
+    atomic_init(&(*target)->scheduledQueue, CE_NO_QUEUE);
+    atomic_init(&(*target)->queuedBatch, NULL);
+    atomic_init(&(*target)->queuedRunResult, CE_SUCCESS);
+    (*target)->cpuBackend = ceGetInstanceCpuBackend(instance);
+    if((*target)->cpuBackend) {
+        if(args->bEnableProfiling)
+            return __failCommandCreation(instance, target, CE_ERROR_INVALID_ARG, "cannot profile command: CPU instances have no timestamp queries");
+        return CE_SUCCESS;
+    }
 
+    if(ceGetInstanceTimelineSemaphoresEnabled(instance)) {
+        VkSemaphoreTypeCreateInfo timelineInfo = {
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+            .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+            .initialValue = 0,
+        };
+        VkSemaphoreCreateInfo semaphoreInfo = {
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+            .pNext = &timelineInfo,
+        };
+        if(vkCreateSemaphore(ceGetInstanceVulkanDevice(instance), &semaphoreInfo, NULL, &(*target)->timelineSemaphore) != VK_SUCCESS) {
+            (*target)->timelineSemaphore = VK_NULL_HANDLE;
+            return __failCommandCreation(instance, target, CE_ERROR_INTERNAL, "Vk failed to create timeline semaphore on device for command");
+        }
+    } else {
+        VkFenceCreateInfo fenceInfo = {
+            .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO
+        };
 
-    {
-        VkPhysicalDeviceProperties props;
-        vkGetPhysicalDeviceProperties(ceGetInstanceVulkanPhysicalDevice(instance), &props);
-        (*target)->workGroupCount = props.limits.maxComputeWorkGroupCount[0];
+        if(vkCreateFence(ceGetInstanceVulkanDevice(instance), &fenceInfo, NULL, &(*target)->commandFence) != VK_SUCCESS) {
+            (*target)->commandFence = VK_NULL_HANDLE;
+            return __failCommandCreation(instance, target, CE_ERROR_INTERNAL, "Vk failed to create fence on device for command");
+        }
     }
 
-    vkGetDeviceQueue(ceGetInstanceVulkanDevice(instance),
-    ceGetInstanceVulkanQueueFamilyIndex(instance),
-    (*target)->vulkanQueueIndex, &(*target)->vulkanQueue);
+    VkCommandBufferLevel level = args->bIsSecondaryCommand ? VK_COMMAND_BUFFER_LEVEL_SECONDARY : VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    if(ceAllocateCommandBuffer(instance, ceGetInstanceCommandPoolSet(instance), level,
+        &(*target)->commandPool, &(*target)->commandBuffer) != VK_SUCCESS) {
+        (*target)->commandBuffer = VK_NULL_HANDLE;
+        return __failCommandCreation(instance, target, CE_ERROR_INTERNAL, "Vk failed to allocate the command buffer for CeCommand");
+    }    
+    if(args->bEnableProfiling) {
+        if(!ceGetInstanceTimestampValidBits(instance))
+            return __failCommandCreation(instance, target, CE_ERROR_INVALID_ARG,
+                "cannot profile command: the device queues do not support timestamps");
+        if(__createProfilingQueryPools(instance, args, *target) != VK_SUCCESS)
+            return __failCommandCreation(instance, target, CE_ERROR_INTERNAL, "Vk failed to create the query pools for a profiled CeCommand");
+    }
+    return CE_SUCCESS;
+}
 
-    VkFenceCreateInfo fenceInfo = {
-        .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO
+static VkResult __beginVkCommandBuffer(CeCommand command) {
+    VkCommandBufferInheritanceInfo inheritanceInfo = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+    };
+    VkCommandBufferBeginInfo beginInfo = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT,
+        .pInheritanceInfo = command->isSecondary ? &inheritanceInfo : NULL,
     };
+    VkResult result = vkBeginCommandBuffer(command->commandBuffer, &beginInfo);
+    if(result != VK_SUCCESS)
+        return result;
+    if(command->timestampQueryPool) {
+        command->profiledPipelineCount = 0;
+        vkCmdResetQueryPool(command->commandBuffer, command->timestampQueryPool, 0, command->maxProfiledPipelines * 2);
+        if(command->statisticsQueryPool)
+            vkCmdResetQueryPool(command->commandBuffer, command->statisticsQueryPool, 0, command->maxProfiledPipelines);
+    }
+    return VK_SUCCESS;
+}
 
-    if(vkCreateFence(ceGetInstanceVulkanDevice(instance), &fenceInfo, NULL, &(*target)->commandFence) != VK_SUCCESS)
-        return ceResult(CE_ERROR_INTERNAL, "Vk failed to create fence on device for command");
+static uint64_t __getTimestampMask(CeInstance instance) {
+    const uint32_t validBits = ceGetInstanceTimestampValidBits(instance);
+    return validBits >= 64 ? ~((uint64_t)0) : (((uint64_t)1 << validBits) - 1);
+}
+
+//timestamps are masked to the valid bits, invocations may be NULL when only the timestamps are needed
+static VkResult __readProfileQueries(CeInstance instance, CeCommand command, uint64_t* timestamps, uint64_t* invocations) {
+    VkDevice device = ceGetInstanceVulkanDevice(instance);
+    const uint32_t count = command->profiledPipelineCount;
+    VkResult result = vkGetQueryPoolResults(device, command->timestampQueryPool, 0, count * 2,
+        count * 2 * sizeof(uint64_t), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+    if(result != VK_SUCCESS)
+        return result;
+    const uint64_t mask = __getTimestampMask(instance);
+    for(uint32_t i = 0; i < count * 2; ++i)
+        timestamps[i] &= mask;
+    if(invocations && command->statisticsQueryPool)
+        result = vkGetQueryPoolResults(device, command->statisticsQueryPool, 0, count,
+            count * sizeof(uint64_t), invocations, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+    return result;
+}
 
-    VkCommandBufferAllocateInfo allocInfo = {
-        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
-        .commandPool = ceGetInstanceVulkanCommandPool(instance),
-        .level = args->bIsSecondaryCommand ? 
-            VK_COMMAND_BUFFER_LEVEL_SECONDARY : VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-        .commandBufferCount = 1,
+//the GPU clock has no fixed relation to the host clock, so the last timestamp is pinned to the moment the fence was seen signalled
+static void __traceGpuSpans(CeInstance instance, CeCommand command, uint64_t hostDone) {
+    const uint32_t count = command->profiledPipelineCount;
+    if(!count)
+        return;
+    uint64_t* timestamps = calloc(count * 2, sizeof(uint64_t));
+    if(!timestamps || __readProfileQueries(instance, command, timestamps, NULL) != VK_SUCCESS) {
+        free(timestamps);
+        return;
+    }
+    const uint64_t mask = __getTimestampMask(instance);
+    const double period = ceGetInstanceVulkanDeviceProperties(instance)->limits.timestampPeriod;
+    uint64_t last = 0;
+    for(uint32_t i = 0; i < count * 2; ++i)
+        last = timestamps[i] > last ? timestamps[i] : last;
+    for(uint32_t i = 0; i < count; ++i) {
+        uint64_t begin = hostDone - (uint64_t)(((last - timestamps[i * 2]) & mask) * period);
+        uint64_t end = hostDone - (uint64_t)(((last - timestamps[i * 2 + 1]) & mask) * period);
+        ceTraceGpuSpan("gpu pipeline", begin, end, (uint64_t)(uintptr_t)command->profiledPipelines[i]);
+    }
+    free(timestamps);
+}
+
+//the queue load is given back once, by whoever sees the last run completed first
+static void __releaseScheduledQueue(CeInstance instance, CeCommand command) {
+    const uint32_t queueIndex = atomic_exchange(&command->scheduledQueue, CE_NO_QUEUE);
+    if(queueIndex != CE_NO_QUEUE)
+        ceSchedulerRelease(ceGetInstanceQueueScheduler(instance), queueIndex);
+}
+
+static void __releaseBatchFence(CeInstance instance, CeCommand command) {
+    struct CeBatchFence* batchFence = command->batchFence;
+    command->batchFence = NULL;
+    if(batchFence && atomic_fetch_sub(&batchFence->refCount, 1) == 1) {
+        vkDestroyFence(ceGetInstanceVulkanDevice(instance), batchFence->vulkanFence, NULL);
+        free(batchFence);
+    }
+}
+
+//the fence signalled by the latest run, VK_NULL_HANDLE with timeline semaphores
+static VkFence __getRunFence(CeCommand command) {
+    return command->batchFence ? command->batchFence->vulkanFence : command->commandFence;
+}
+
+//ops run in order on the calling thread, each dispatch being spread over the workers, so barriers are already satisfied
+static void __runCpuOps(CeCpuBackend cpuBackend, CeCommand command) {
+    for(uint32_t i = 0; i < command->opCount; ++i) {
+        const struct CeCommandOp* op = &command->ops[i];
+        if(op->type == CE_COMMAND_OP_PIPELINE) {
+            ceRunCpuPipeline(cpuBackend, op->pipeline);
+        } else if(op->type == CE_COMMAND_OP_COPY) {
+            const uint64_t sourceSize = ceGetBufferSize(op->copySource), destinationSize = ceGetBufferSize(op->copyDestination);
+            memcpy(ceGetBufferCpuMemory(op->copyDestination), ceGetBufferCpuMemory(op->copySource),
+                sourceSize < destinationSize ? sourceSize : destinationSize);
+        }
+        else if(op->type == CE_COMMAND_OP_SECONDARY)
+            __runCpuOps(cpuBackend, op->secondary);
+    }
+}
+
+static CeResult __runCpuCommands(CeInstance instance, const CeCommand* commands, uint32_t count) {
+    uint64_t traceBegin = ceTraceBegin();
+    for(uint32_t i = 0; i < count; ++i) {
+        //transfers of CPU instances are done by the time they are started, waiting only reports their failures
+        for(uint32_t j = 0; j < commands[i]->transferWaitCount; ++j) {
+            if(ceWaitTransfer(instance, commands[i]->transferWaits[j]) != CE_SUCCESS)
+                return ceResult(CE_ERROR_INTERNAL, "cannot run command: a transfer it waits for failed");
+        }
+        __runCpuOps(commands[i]->cpuBackend, commands[i]);
+        ++commands[i]->submissionCount;
+        commands[i]->transferWaitCount = 0;
+        commands[i]->runAfter = NULL;
+    }
+    ceTraceEnd("CPU command run", traceBegin);
+    return CE_SUCCESS;
+}
+
+//secondary commands keep their own regions, which the commands executing them write before each run
+static VkResult __gatherLiveCopies(CeCommand command, CeCommand source) {
+    for(uint32_t i = 0; i < source->opCount; ++i) {
+        const struct CeCommandOp* op = &source->ops[i];
+        if(op->type == CE_COMMAND_OP_SECONDARY) {
+            VkResult result = __gatherLiveCopies(command, op->secondary);
+            if(result != VK_SUCCESS)
+                return result;
+        }
+        if(op->type != CE_COMMAND_OP_PIPELINE || !ceGetPipelineLiveConstantSize(op->pipeline))
+            continue;
+        CeBuffer buffer = NULL;
+        for(uint32_t j = 0; j < source->liveRegionCount && !buffer; ++j)
+            buffer = source->liveRegions[j].pipeline == op->pipeline ? source->liveRegions[j].buffer : NULL;
+        //a pipeline recorded several times to the same command reads the same region every time
+        CeBool32 isGathered = CE_FALSE;
+        for(uint32_t j = 0; j < command->liveCopyCount && !isGathered; ++j)
+            isGathered = command->liveCopies[j].buffer == buffer;
+        if(isGathered)
+            continue;
+        if(command->liveCopyCount == command->liveCopyCapacity) {
+            const uint32_t capacity = command->liveCopyCapacity ? command->liveCopyCapacity * 2 : 4;
+            struct CeLiveCopy* copies = realloc(command->liveCopies, capacity * sizeof(struct CeLiveCopy));
+            if(!copies)
+                return VK_ERROR_OUT_OF_HOST_MEMORY;
+            command->liveCopies = copies;
+            command->liveCopyCapacity = capacity;
+        }
+        command->liveCopies[command->liveCopyCount++] = (struct CeLiveCopy){
+            .pipeline = op->pipeline,
+            .buffer = buffer,
+            .offset = command->liveValueSize,
+        };
+        command->liveValueSize += ceGetPipelineLiveConstantSize(op->pipeline);
+    }
+    return VK_SUCCESS;
+}
+
+static void __destroyLiveSlot(CeInstance instance, struct CeLiveSlot* slot) {
+    if(slot->values)
+        ceDestroyBuffer(instance, slot->values);
+    if(slot->copyCommand)
+        ceFreeCommandBuffer(instance, slot->copyCommandPool, slot->copyCommand);
+    *slot = (struct CeLiveSlot){0};
+}
+
+static void __destroyLiveSlots(CeInstance instance, CeCommand command) {
+    for(uint32_t i = 0; i < command->liveSlotCount; ++i)
+        __destroyLiveSlot(instance, &command->liveSlots[i]);
+    command->liveSlotCount = 0;
+}
+
+//the slots of an earlier recording copy to other regions, they are replaced the first time the command runs again
+static VkResult __prepareLiveCopies(CeInstance instance, CeCommand command) {
+    if(!command->liveCopiesAreStale)
+        return VK_SUCCESS;
+    __destroyLiveSlots(instance, command);
+    command->liveCopyCount = 0;
+    command->liveValueSize = 0;
+    VkResult result = __gatherLiveCopies(command, command);
+    if(result != VK_SUCCESS) {
+        command->liveCopyCount = 0;
+        return result;
+    }
+    command->liveCopiesAreStale = CE_FALSE;
+    return VK_SUCCESS;
+}
+
+static VkResult __recordLiveSlotCopies(CeCommand command, struct CeLiveSlot* slot) {
+    VkCommandBufferBeginInfo beginInfo = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
     };
-    
-    if(vkAllocateCommandBuffers(ceGetInstanceVulkanDevice(instance), &allocInfo, &(*target)->commandBuffer) != VK_SUCCESS) {
-        return ceResult(CE_ERROR_INTERNAL, "Vk failed to allocate the command buffer for CeCommand");
-    }    
+    ceLockCommandPool(slot->copyCommandPool);
+    VkResult result = vkBeginCommandBuffer(slot->copyCommand, &beginInfo);
+    if(result != VK_SUCCESS) {
+        ceUnlockCommandPool(slot->copyCommandPool);
+        return result;
+    }
+    //the previous run of the command, or of another one executing the same secondary commands, may still read the regions
+    VkMemoryBarrier readBarrier = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_SHADER_READ_BIT,
+        .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+    };
+    vkCmdPipelineBarrier(slot->copyCommand, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+        1, &readBarrier, 0, NULL, 0, NULL);
+    for(uint32_t i = 0; i < command->liveCopyCount; ++i) {
+        const struct CeLiveCopy* liveCopy = &command->liveCopies[i];
+        VkBufferCopy copy = {
+            .srcOffset = liveCopy->offset,
+            .size = ceGetPipelineLiveConstantSize(liveCopy->pipeline),
+        };
+        vkCmdCopyBuffer(slot->copyCommand, ceGetBufferVulkanBuffer(slot->values), ceGetBufferVulkanBuffer(liveCopy->buffer), 1, &copy);
+    }
+    VkMemoryBarrier writeBarrier = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+    };
+    vkCmdPipelineBarrier(slot->copyCommand, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+        1, &writeBarrier, 0, NULL, 0, NULL);
+    result = vkEndCommandBuffer(slot->copyCommand);
+    ceUnlockCommandPool(slot->copyCommandPool);
+    return result;
+}
+
+static VkResult __createLiveSlot(CeInstance instance, CeCommand command, struct CeLiveSlot* slot) {
+    CeBufferCreationArgs valueArgs = {
+        .uElementSize = sizeof(uint32_t),
+        .uElementCount = command->liveValueSize / sizeof(uint32_t),
+        .bKeepMapped = CE_TRUE,
+        .ePlacement = CE_BINDING_PLACEMENT_HOST_VISIBLE,
+    };
+    if(ceCreateBuffer(instance, &valueArgs, &slot->values) != CE_SUCCESS) {
+        slot->values = NULL;
+        return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+    }
+    slot->mappedValues = ceGetBufferMappedData(slot->values);
+    VkResult result = ceAllocateCommandBuffer(instance, ceGetInstanceCommandPoolSet(instance), VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+        &slot->copyCommandPool, &slot->copyCommand);
+    if(result != VK_SUCCESS) {
+        slot->copyCommand = VK_NULL_HANDLE;
+        return result;
+    }
+    return __recordLiveSlotCopies(command, slot);
+}
+
+//writes the current live constants to a slot no run in flight reads from, waiting for the oldest run when every slot is taken
+static VkResult __acquireLiveSlot(CeInstance instance, CeCommand command, struct CeLiveSlot** target) {
+    struct CeLiveSlot* slot = NULL;
+    for(uint32_t i = 0; i < command->liveSlotCount && !slot; ++i) {
+        if(ceIsCommandSubmissionDone(instance, command, command->liveSlots[i].submission))
+            slot = &command->liveSlots[i];
+    }
+    if(!slot && command->liveSlotCount < CE_MAX_LIVE_SLOTS) {
+        slot = &command->liveSlots[command->liveSlotCount];
+        VkResult result = __createLiveSlot(instance, command, slot);
+        if(result != VK_SUCCESS) {
+            __destroyLiveSlot(instance, slot);
+            return result;
+        }
+        ++command->liveSlotCount;
+    }
+    if(!slot) {
+        //runs complete in order, the oldest one is the first to free its slot
+        slot = &command->liveSlots[0];
+        for(uint32_t i = 1; i < command->liveSlotCount; ++i)
+            slot = command->liveSlots[i].submission < slot->submission ? &command->liveSlots[i] : slot;
+        VkResult result = ceWaitCommandSubmissions(instance, &command, &slot->submission, 1, CE_TRUE, ~((uint64_t)0));
+        if(result != VK_SUCCESS)
+            return result;
+    }
+    for(uint32_t i = 0; i < command->liveCopyCount; ++i)
+        ceWritePipelineLiveConstants(command->liveCopies[i].pipeline, (char*)slot->mappedValues + command->liveCopies[i].offset);
+    *target = slot;
+    return VK_SUCCESS;
+}
+
+//submits every command in a single VkSubmitInfo, signalling each command's timeline semaphore or one fence shared by the batch
+CeResult
+ceSubmitCommands(CeInstance instance, const CeCommand* commands, uint32_t count) {
+    if(commands[0]->cpuBackend) {
+        CeResult result = __runCpuCommands(instance, commands, count);
+        for(uint32_t i = 0; i < count && result == CE_SUCCESS; ++i)
+            atomic_store(&commands[i]->queuedRunResult, CE_SUCCESS);
+        return result;
+    }
+    VkDevice device = ceGetInstanceVulkanDevice(instance);
+    uint64_t traceBegin = ceTraceBegin();
+    //all the commands share the same kind of completion tracking since it depends on the instance
+    const CeBool32 useTimeline = commands[0]->timelineSemaphore != VK_NULL_HANDLE;
+    uint32_t transferWaitCount = 0;
+    for(uint32_t i = 0; i < count; ++i)
+        transferWaitCount += commands[i]->transferWaitCount;
+    //each command can also wait for the last run of another one, and for its own last run if it has live constants
+    VkSemaphore* waitSemaphores = malloc((transferWaitCount + 2 * count) * sizeof(VkSemaphore));
+    uint64_t* waitValues = malloc((transferWaitCount + 2 * count) * sizeof(uint64_t));
+    VkPipelineStageFlags* waitStages = malloc((transferWaitCount + 2 * count) * sizeof(VkPipelineStageFlags));
+    struct CeLiveSlot** liveSlots = calloc(count, sizeof(struct CeLiveSlot*));
+    uint32_t waitCount = 0, liveSlotCount = 0;
+    for(uint32_t i = 0; i < count; ++i) {
+        //the fences of the previous run are reset or destroyed below and its queue load given back, so it has to be over
+        if(!useTimeline && commands[i]->submissionCount &&
+            ceWaitCommandSubmissions(instance, &commands[i], &commands[i]->submissionCount, 1, CE_TRUE, ~((uint64_t)0)) != VK_SUCCESS) {
+            free(waitSemaphores);
+            free(waitValues);
+            free(waitStages);
+            free(liveSlots);
+            return ceResult(CE_ERROR_INTERNAL, "cannot run command: failed to wait for its previous run");
+        }
+        //the live constants are copied to the command's regions by the slot's copy, submitted right before the command
+        if(__prepareLiveCopies(instance, commands[i]) != VK_SUCCESS) {
+            free(waitSemaphores);
+            free(waitValues);
+            free(waitStages);
+            free(liveSlots);
+            return ceResult(CE_ERROR_INTERNAL, "cannot run command: failed to gather its live constants");
+        }
+        if(commands[i]->liveCopyCount) {
+            if(__acquireLiveSlot(instance, commands[i], &liveSlots[i]) != VK_SUCCESS) {
+                free(waitSemaphores);
+                free(waitValues);
+                free(waitStages);
+                free(liveSlots);
+                return ceResult(CE_ERROR_INTERNAL, "cannot run command: failed to write its live constants");
+            }
+            ++liveSlotCount;
+            //runs on other queues could still read the regions the copy writes, without timeline semaphores they were waited on above
+            if(commands[i]->submissionCount && useTimeline) {
+                waitSemaphores[waitCount] = commands[i]->timelineSemaphore;
+                waitValues[waitCount] = commands[i]->submissionCount;
+                waitStages[waitCount++] = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+            }
+        }
+        CeCommand after = commands[i]->runAfter;
+        if(after) {
+            VkSemaphore afterSemaphore;
+            uint64_t afterValue;
+            //without timeline semaphores the hand-off happens on the host
+            if(!ceGetCommandLastRunSemaphore(instance, after, &afterSemaphore, &afterValue) ||
+                (!afterSemaphore && ceWaitCommand(instance, after) != CE_SUCCESS)) {
+                free(waitSemaphores);
+                free(waitValues);
+                free(waitStages);
+                free(liveSlots);
+                return ceResult(CE_ERROR_INTERNAL, "cannot run command: the command it runs after failed");
+            }
+            if(afterSemaphore && afterValue) {
+                waitSemaphores[waitCount] = afterSemaphore;
+                waitValues[waitCount] = afterValue;
+                waitStages[waitCount++] = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+            }
+        }
+        for(uint32_t j = 0; j < commands[i]->transferWaitCount; ++j) {
+            ceGetTransferSemaphore(commands[i]->transferWaits[j], &waitSemaphores[waitCount], &waitValues[waitCount]);
+            waitStages[waitCount] = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+            if(waitSemaphores[waitCount]) {
+                ++waitCount;
+                continue;
+            }
+            //without timeline semaphores the hand-off happens on the host
+            if(ceWaitTransfer(instance, commands[i]->transferWaits[j]) != CE_SUCCESS) {
+                free(waitSemaphores);
+                free(waitValues);
+                free(waitStages);
+                free(liveSlots);
+                return ceResult(CE_ERROR_INTERNAL, "cannot run command: a transfer it waits for failed");
+            }
+        }
+    }
+    VkCommandBuffer* commandBuffers = malloc((count + liveSlotCount) * sizeof(VkCommandBuffer));
+    VkSemaphore* semaphores = malloc(count * sizeof(VkSemaphore));
+    uint64_t* signalValues = malloc(count * sizeof(uint64_t));
+    uint32_t commandBufferCount = 0;
+    for(uint32_t i = 0; i < count; ++i) {
+        if(liveSlots[i])
+            commandBuffers[commandBufferCount++] = liveSlots[i]->copyCommand;
+        commandBuffers[commandBufferCount++] = commands[i]->commandBuffer;
+        semaphores[i] = commands[i]->timelineSemaphore;
+        signalValues[i] = commands[i]->submissionCount + 1;
+        //the previous run has to be done for the command to run again, even if it was never waited on through CE,
+        //which is made sure of above without timeline semaphores
+        __releaseScheduledQueue(instance, commands[i]);
+        __releaseBatchFence(instance, commands[i]);
+    }
+    VkTimelineSemaphoreSubmitInfo timelineInfo = {
+        .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+        .waitSemaphoreValueCount = waitCount,
+        .pWaitSemaphoreValues = waitValues,
+        .signalSemaphoreValueCount = count,
+        .pSignalSemaphoreValues = signalValues,
+    };
+    VkSubmitInfo subInfo = {
+        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .pNext = useTimeline ? &timelineInfo : NULL,
+        .waitSemaphoreCount = waitCount,
+        .pWaitSemaphores = waitSemaphores,
+        .pWaitDstStageMask = waitStages,
+        .commandBufferCount = commandBufferCount,
+        .pCommandBuffers = commandBuffers,
+        .signalSemaphoreCount = useTimeline ? count : 0,
+        .pSignalSemaphores = semaphores,
+    };
+    VkFence fence = VK_NULL_HANDLE;
+    struct CeBatchFence* batchFence = NULL;
+    VkResult result = VK_SUCCESS;
+    if(!useTimeline && count == 1) {
+        //the fence stays signalled after a run so that it can be queried and waited on any number of times
+        fence = commands[0]->commandFence;
+        if(commands[0]->submissionCount)
+            vkResetFences(device, 1, &fence);
+    } else if(!useTimeline) {
+        VkFenceCreateInfo fenceInfo = {
+            .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO
+        };
+        batchFence = malloc(sizeof(struct CeBatchFence));
+        result = batchFence ? vkCreateFence(device, &fenceInfo, NULL, &batchFence->vulkanFence) : VK_ERROR_OUT_OF_HOST_MEMORY;
+        if(result == VK_SUCCESS) {
+            fence = batchFence->vulkanFence;
+            atomic_init(&batchFence->refCount, count);
+        } else {
+            //the fence was never created, there is nothing to destroy
+            free(batchFence);
+            batchFence = NULL;
+        }
+    }
+    CeQueueScheduler scheduler = ceGetInstanceQueueScheduler(instance);
+    uint32_t queueIndex;
+    if(result == VK_SUCCESS)
+        result = ceSchedulerSubmit(scheduler, 1, &subInfo, fence, &queueIndex);
+    free(commandBuffers);
+    free(semaphores);
+    free(signalValues);
+    free(waitSemaphores);
+    free(waitValues);
+    free(waitStages);
+    if(result != VK_SUCCESS) {
+        free(liveSlots);
+        if(batchFence) {
+            vkDestroyFence(device, batchFence->vulkanFence, NULL);
+            free(batchFence);
+        }
+        return ceResult(CE_ERROR_INTERNAL, "Vk failed to run command");
+    }
+    //every command gives back its share of the queue's load once it is seen completed
+    ceSchedulerHold(scheduler, queueIndex, count - 1);
+    for(uint32_t i = 0; i < count; ++i) {
+        atomic_store(&commands[i]->scheduledQueue, queueIndex);
+        commands[i]->batchFence = batchFence;
+        atomic_store(&commands[i]->queuedRunResult, CE_SUCCESS);
+        ++commands[i]->submissionCount;
+        commands[i]->transferWaitCount = 0;
+        commands[i]->runAfter = NULL;
+        if(liveSlots[i])
+            liveSlots[i]->submission = commands[i]->submissionCount;
+    }
+    free(liveSlots);
+    ceTraceEnd("vkQueueSubmit", traceBegin);
     return CE_SUCCESS;
 }
 
+CeSubmitBatch
+ceGetCommandQueuedBatch(CeCommand command) {
+    return atomic_load(&command->queuedBatch);
+}
+
+void
+ceSetCommandQueuedBatch(CeCommand command, CeSubmitBatch batch) {
+    atomic_store(&command->queuedBatch, batch);
+}
+
+void
+ceSetCommandQueuedRunResult(CeCommand command, CeResult result) {
+    atomic_store(&command->queuedRunResult, result);
+}
+
+//a run still sitting in a batch is submitted before the command is waited on or run again
+static CeResult __flushQueuedBatch(CeInstance instance, CeCommand command) {
+    CeSubmitBatch batch = atomic_load(&command->queuedBatch);
+    return batch ? ceSubmitQueuedCommands(batch) : CE_SUCCESS;
+}
+
+//like __flushQueuedBatch, but also fails when the batch was flushed by its own thread and could not submit the run
+static CeResult __flushQueuedRun(CeInstance instance, CeCommand command) {
+    CeResult result = __flushQueuedBatch(instance, command);
+    return result == CE_SUCCESS ? atomic_load(&command->queuedRunResult) : result;
+}
+
 CeResult 
 ceRunCommand(CeInstance instance, CeCommand command) {
     if(!command)
         return ceResult(CE_ERROR_NULL_PASSED, "cannot run command: none passed");
-    VkSubmitInfo subInfo = {
-        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-        .commandBufferCount = 1,
-        .pCommandBuffers = &command->commandBuffer
-    };
-    if(vkQueueSubmit(command->vulkanQueue, 1, &subInfo, command->commandFence) != VK_SUCCESS)
-        return ceResult(CE_ERROR_INTERNAL, "Vk failed to run command");
+    CeResult result = __flushQueuedBatch(instance, command);
+    if(result != CE_SUCCESS)
+        return result;
+    return ceSubmitCommands(instance, &command, 1);
+}
+
+CeResult
+ceAddCommandTransferWait(CeCommand command, CeTransfer transfer) {
+    if(!command || !transfer)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot make command wait for transfer: some parameters were NULL");
+    if(command->transferWaitCount == command->transferWaitCapacity) {
+        command->transferWaitCapacity = command->transferWaitCapacity ? command->transferWaitCapacity * 2 : 4;
+        command->transferWaits = realloc(command->transferWaits, command->transferWaitCapacity * sizeof(CeTransfer));
+    }
+    command->transferWaits[command->transferWaitCount++] = transfer;
     return CE_SUCCESS;
 }
 
+CeBool32
+ceGetCommandLastRunSemaphore(CeInstance instance, CeCommand command, VkSemaphore* pSemaphore, uint64_t* pValue) {
+    if(__flushQueuedRun(instance, command) != CE_SUCCESS)
+        return CE_FALSE;
+    *pSemaphore = command->timelineSemaphore;
+    *pValue = command->submissionCount;
+    return CE_TRUE;
+}
+
+CeResult
+ceRunCommands(CeInstance instance, const CeCommand* pCommands, uint32_t uCommandCount) {
+    if(!instance || !pCommands)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot run commands: some parameters were NULL");
+    if(!uCommandCount)
+        return CE_SUCCESS;
+    for(uint32_t i = 0; i < uCommandCount; ++i) {
+        if(!pCommands[i])
+            return ceResult(CE_ERROR_NULL_PASSED, "cannot run commands: one of them is NULL");
+        CeResult result = __flushQueuedBatch(instance, pCommands[i]);
+        if(result != CE_SUCCESS)
+            return result;
+    }
+    return ceSubmitCommands(instance, pCommands, uCommandCount);
+}
+
+CeBool32
+ceIsCommandSubmissionDone(CeInstance instance, CeCommand command, uint64_t submission) {
+    if(!submission || command->cpuBackend)
+        return CE_TRUE;
+    CeBool32 isDone;
+    if(command->timelineSemaphore) {
+        uint64_t value = 0;
+        vkGetSemaphoreCounterValue(ceGetInstanceVulkanDevice(instance), command->timelineSemaphore, &value);
+        isDone = value >= submission;
+    } else {
+        //a fence only tracks the latest run
+        isDone = submission < command->submissionCount ||
+            vkGetFenceStatus(ceGetInstanceVulkanDevice(instance), __getRunFence(command)) == VK_SUCCESS;
+    }
+    if(isDone && submission == command->submissionCount)
+        __releaseScheduledQueue(instance, command);
+    return isDone;
+}
+
+VkResult
+ceWaitCommandSubmissions(CeInstance instance, const CeCommand* commands, const uint64_t* submissions, uint32_t count,
+    CeBool32 waitAll, uint64_t timeout) {
+    //CPU runs are over by the time ceSubmitCommands returns
+    if(ceGetInstanceCpuBackend(instance))
+        return VK_SUCCESS;
+    //commands which were never run or are already done are left out, any of them satisfies a wait-any
+    VkSemaphore* semaphores = malloc(count * sizeof(VkSemaphore));
+    VkFence* fences = malloc(count * sizeof(VkFence));
+    uint32_t semaphoreCount = 0, fenceCount = 0;
+    CeBool32 anyDone = CE_FALSE;
+    uint64_t* values = malloc(count * sizeof(uint64_t));
+    for(uint32_t i = 0; i < count; ++i) {
+        if(!submissions[i] || (!commands[i]->timelineSemaphore && submissions[i] < commands[i]->submissionCount)) {
+            anyDone = CE_TRUE;
+            continue;
+        }
+        if(commands[i]->timelineSemaphore) {
+            semaphores[semaphoreCount] = commands[i]->timelineSemaphore;
+            values[semaphoreCount++] = submissions[i];
+        } else {
+            fences[fenceCount++] = __getRunFence(commands[i]);
+        }
+    }
+    VkResult result = VK_SUCCESS;
+    if(!(anyDone && !waitAll)) {
+        VkDevice device = ceGetInstanceVulkanDevice(instance);
+        if(semaphoreCount) {
+            VkSemaphoreWaitInfo waitInfo = {
+                .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+                .flags = waitAll ? 0 : VK_SEMAPHORE_WAIT_ANY_BIT,
+                .semaphoreCount = semaphoreCount,
+                .pSemaphores = semaphores,
+                .pValues = values,
+            };
+            result = vkWaitSemaphores(device, &waitInfo, timeout);
+        } else if(fenceCount) {
+            result = vkWaitForFences(device, fenceCount, fences, waitAll ? VK_TRUE : VK_FALSE, timeout);
+        }
+    }
+    free(semaphores);
+    free(fences);
+    free(values);
+    return result;
+}
+
 CeResult
 ceBeginCommand(CeCommand command) {
     if(!command)
         return ceResult(CE_ERROR_NULL_PASSED, "cannot begin command: none passed");
-    VkCommandBufferBeginInfo beginInfo = {
-        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
-        .flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT
-    };
-    if(vkBeginCommandBuffer(command->commandBuffer, &beginInfo))
+    __clearOps(command);
+    if(command->cpuBackend)
+        return CE_SUCCESS;
+    ceLockCommandPool(command->commandPool);
+    VkResult result = __beginVkCommandBuffer(command);
+    ceUnlockCommandPool(command->commandPool);
+    if(result != VK_SUCCESS)
         return ceResult(CE_ERROR_INTERNAL, "Vk failed to begin command buffer recording");
     return CE_SUCCESS;
 }
@@ -127,7 +1077,12 @@ CeResult
 ceEndCommand(CeCommand command) {
     if(!command)
         return ceResult(CE_ERROR_NULL_PASSED, "cannot end command: none passed");
-    if(vkEndCommandBuffer(command->commandBuffer) != VK_SUCCESS)
+    if(command->cpuBackend)
+        return CE_SUCCESS;
+    ceLockCommandPool(command->commandPool);
+    VkResult result = vkEndCommandBuffer(command->commandBuffer);
+    ceUnlockCommandPool(command->commandPool);
+    if(result != VK_SUCCESS)
         return ceResult(CE_ERROR_INTERNAL, "Vk failed to end command buffer recording");
     return CE_SUCCESS;
 }
@@ -137,32 +1092,184 @@ ceWaitCommand(CeInstance instance, CeCommand command) {
     if(!instance || !command)
         return ceResult(CE_ERROR_NULL_PASSED, "cannot wait for command: some parameters were NULL");
     
-    VkResult result = vkWaitForFences(
-        ceGetInstanceVulkanDevice(instance), 1,
-        &command->commandFence, VK_TRUE, ~((uint64_t)0));
-    //vkWaitForFences(ceGetInstanceVulkanDevice(instance), 1, &command->commandFence, VK_FALSE, ~((uint64_t)0));
-    vkResetFences(ceGetInstanceVulkanDevice(instance), 1, &command->commandFence);
+    return ceWaitCommandTimeout(instance, command, ~((uint64_t)0));
+}
+
+CeResult
+ceQueryCommand(CeInstance instance, CeCommand command) {
+    if(!instance || !command)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot query command: some parameters were NULL");
+    CeResult flushResult = __flushQueuedRun(instance, command);
+    if(flushResult != CE_SUCCESS)
+        return flushResult;
+    return ceIsCommandSubmissionDone(instance, command, command->submissionCount) ? CE_SUCCESS : CE_NOT_READY;
+}
+
+CeResult
+ceWaitCommandTimeout(CeInstance instance, CeCommand command, uint64_t uTimeoutNs) {
+    if(!instance || !command)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot wait for command: some parameters were NULL");
+    CeResult flushResult = __flushQueuedRun(instance, command);
+    if(flushResult != CE_SUCCESS)
+        return flushResult;
+    
+    uint64_t traceBegin = ceTraceBegin();
+    VkResult result = ceWaitCommandSubmissions(instance, &command, &command->submissionCount, 1, CE_TRUE, uTimeoutNs);
+    if(result == VK_TIMEOUT)
+        return CE_TIMEOUT;
     if(result == VK_ERROR_DEVICE_LOST)
-        return ceResult(CE_ERROR_INTERNAL, "Vk failed to wait for a fence, device was lost");
+        return ceResult(CE_ERROR_INTERNAL, "Vk failed to wait for a command, device was lost");
     else if(result != VK_SUCCESS)
-        return ceResult(CE_ERROR_INTERNAL, "Vk failed to wait for a fence");
+        return ceResult(CE_ERROR_INTERNAL, "Vk failed to wait for a command");
+    __releaseScheduledQueue(instance, command);
+    ceTraceEnd("ceWaitCommand", traceBegin);
+    if(traceBegin && command->timestampQueryPool)
+        __traceGpuSpans(instance, command, ceTraceNow());
+    return CE_SUCCESS;
+}
+
+CeResult
+ceWaitCommands(CeInstance instance, const CeCommand* pCommands, uint32_t uCommandCount, CeBool32 bWaitAll,
+    uint64_t uTimeoutNs, uint32_t* pCompletedIndex) {
+    if(!instance || !pCommands || !uCommandCount)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot wait for commands: none passed");
+    for(uint32_t i = 0; i < uCommandCount; ++i) {
+        CeResult flushResult = __flushQueuedRun(instance, pCommands[i]);
+        if(flushResult != CE_SUCCESS)
+            return flushResult;
+    }
+    uint64_t* submissions = malloc(uCommandCount * sizeof(uint64_t));
+    for(uint32_t i = 0; i < uCommandCount; ++i)
+        submissions[i] = pCommands[i]->submissionCount;
+    uint64_t traceBegin = ceTraceBegin();
+    VkResult result = ceWaitCommandSubmissions(instance, pCommands, submissions, uCommandCount, bWaitAll, uTimeoutNs);
+    free(submissions);
+    if(result == VK_TIMEOUT)
+        return CE_TIMEOUT;
+    if(result != VK_SUCCESS)
+        return ceResult(CE_ERROR_INTERNAL, "Vk failed to wait for commands");
+    ceTraceEnd("ceWaitCommands", traceBegin);
+    if(pCompletedIndex) {
+        for(uint32_t i = 0; i < uCommandCount; ++i) {
+            if(ceIsCommandSubmissionDone(instance, pCommands[i], pCommands[i]->submissionCount)) {
+                *pCompletedIndex = i;
+                break;
+            }
+        }
+    }
+    return CE_SUCCESS;
+}
+
+CeResult
+ceSetCommandCompletionCallback(CeInstance instance, CeCommand command, CeCommandCompletionCallback callback, void* pUserData) {
+    if(!instance || !command || !callback)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot set completion callback: some parameters were NULL");
+    CeResult flushResult = __flushQueuedRun(instance, command);
+    if(flushResult != CE_SUCCESS)
+        return flushResult;
+    if(command->cpuBackend) {
+        callback(command, pUserData);
+        return CE_SUCCESS;
+    }
+    if(ceAddCompletionCallback(instance, ceGetInstanceCompletionQueue(instance), command, command->submissionCount,
+        callback, pUserData) != VK_SUCCESS)
+        return ceResult(CE_ERROR_INTERNAL, "failed to start the completion thread");
     return CE_SUCCESS;
 }
 
 CeResult ceResetCommand(CeCommand command) {
     if(!command)
         return ceResult(CE_ERROR_NULL_PASSED, "cannot reset command: none passed");
-    if(vkResetCommandBuffer(command->commandBuffer, 0)) {
+    __clearOps(command);
+    if(command->cpuBackend)
+        return CE_SUCCESS;
+    ceLockCommandPool(command->commandPool);
+    VkResult result = vkResetCommandBuffer(command->commandBuffer, 0);
+    ceUnlockCommandPool(command->commandPool);
+    if(result != VK_SUCCESS) {
         return ceResult(CE_ERROR_INTERNAL, "Vk failed to reset a command buffer");
     }
     return CE_SUCCESS;
 }
 
+CeResult
+ceGetCommandProfile(CeInstance instance, CeCommand command, CeCommandProfile* profile) {
+    if(!instance || !command || !profile)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot get command profile: some parameters were NULL");
+    if(!command->timestampQueryPool)
+        return ceResult(CE_ERROR_INVALID_ARG, "cannot get command profile: the command was created without profiling");
+    const uint32_t count = command->profiledPipelineCount;
+    profile->uGpuTimeNs = 0;
+    if(!count) {
+        profile->uPipelineProfileCount = 0;
+        return CE_SUCCESS;
+    }
+    uint64_t* timestamps = calloc(count * 2, sizeof(uint64_t));
+    uint64_t* invocations = calloc(count, sizeof(uint64_t));
+    VkResult result = __readProfileQueries(instance, command, timestamps, invocations);
+    if(result != VK_SUCCESS) {
+        free(timestamps);
+        free(invocations);
+        if(result == VK_NOT_READY)
+            return CE_NOT_READY;
+        return ceResult(CE_ERROR_INTERNAL, "Vk failed to read the query results of a profiled command");
+    }
+
+    const uint64_t mask = __getTimestampMask(instance);
+    const double period = ceGetInstanceVulkanDeviceProperties(instance)->limits.timestampPeriod;
+    uint64_t first = ~((uint64_t)0), last = 0;
+    for(uint32_t i = 0; i < count; ++i) {
+        uint64_t begin = timestamps[i * 2], end = timestamps[i * 2 + 1];
+        first = begin < first ? begin : first;
+        last = end > last ? end : last;
+        if(!profile->pPipelineProfiles || i >= profile->uPipelineProfileCount)
+            continue;
+        profile->pPipelineProfiles[i].pPipeline = command->profiledPipelines[i];
+        profile->pPipelineProfiles[i].uGpuTimeNs = (uint64_t)(((end - begin) & mask) * period);
+        profile->pPipelineProfiles[i].uInvocationCount = invocations[i];
+    }
+    profile->uGpuTimeNs = (uint64_t)(((last - first) & mask) * period);
+    if(!profile->pPipelineProfiles || profile->uPipelineProfileCount > count)
+        profile->uPipelineProfileCount = count;
+    free(timestamps);
+    free(invocations);
+    return CE_SUCCESS;
+}
+
 void 
 ceDestroyCommand(CeInstance instance, CeCommand command) {
-    ceSetInstanceQueueToFree(instance, command->vulkanQueueIndex);
-    vkResetCommandBuffer(command->commandBuffer, VK_COMMAND_BUFFER_RESET_RELEASE_RESOURCES_BIT);
-    vkDestroyFence(ceGetInstanceVulkanDevice(instance), command->commandFence, NULL);
-    vkFreeCommandBuffers(ceGetInstanceVulkanDevice(instance), ceGetInstanceVulkanCommandPool(instance), 1, &command->commandBuffer);
+    if(!command)
+        return;
+    if(command->cpuBackend) {
+        __clearOps(command);
+        free(command->ops);
+        free(command->transferWaits);
+        free(command);
+        return;
+    }
+    //the completion thread may still be waiting on the command or about to run its callbacks
+    ceRemoveCompletionCallbacks(instance, ceGetInstanceCompletionQueue(instance), command);
+    //a fence cannot be destroyed while a run still signals it, nor the queue load given back before the run is over
+    if(command->submissionCount)
+        ceWaitCommandSubmissions(instance, &command, &command->submissionCount, 1, CE_TRUE, ~((uint64_t)0));
+    __releaseScheduledQueue(instance, command);
+    __releaseBatchFence(instance, command);
+    if(command->commandFence)
+        vkDestroyFence(ceGetInstanceVulkanDevice(instance), command->commandFence, NULL);
+    if(command->timelineSemaphore)
+        vkDestroySemaphore(ceGetInstanceVulkanDevice(instance), command->timelineSemaphore, NULL);
+    if(command->timestampQueryPool)
+        vkDestroyQueryPool(ceGetInstanceVulkanDevice(instance), command->timestampQueryPool, NULL);
+    if(command->statisticsQueryPool)
+        vkDestroyQueryPool(ceGetInstanceVulkanDevice(instance), command->statisticsQueryPool, NULL);
+    free(command->profiledPipelines);
+    __clearOps(command);
+    __destroyLiveSlots(instance, command);
+    __destroyLiveRegions(instance, command);
+    free(command->ops);
+    free(command->liveCopies);
+    free(command->transferWaits);
+    if(command->commandBuffer)
+        ceFreeCommandBuffer(instance, command->commandPool, command->commandBuffer);
     free(command);
 }
@@ -6,6 +6,12 @@ extern "C" {
 
 typedef struct {
     CeBool32 bIsSecondaryCommand;
+    //measure how long each pipeline recorded to the command runs on the GPU, see ceGetCommandProfile
+    CeBool32 bEnableProfiling;
+    //also count the shader invocations of each pipeline, if the device supports it
+    CeBool32 bEnablePipelineStatistics;
+    //maximum number of pipelines profiled between two ceBeginCommand calls, 0 means 64
+    uint32_t uMaxProfiledPipelines;
 } CeCommandCreationArgs;
 
 typedef struct {
@@ -15,6 +21,33 @@ typedef struct {
         CeCommand pSuppliedCommand;
     };
 } CeCommandRecordingArgs;
+typedef struct {
+    CePipeline pPipeline;
+    //time the pipeline took on the GPU, in nanoseconds
+    uint64_t uGpuTimeNs;
+    //compute shader invocations, 0 unless pipeline statistics were enabled
+    uint64_t uInvocationCount;
+} CePipelineProfile;
+
+typedef struct {
+    //array the profiles of each recorded pipeline are written to, in recording order. may be NULL
+    CePipelineProfile* pPipelineProfiles;
+    //capacity of pPipelineProfiles, set to the number of profiled pipelines by ceGetCommandProfile
+    uint32_t uPipelineProfileCount;
+    //time between the start of the first profiled pipeline and the end of the last one, in nanoseconds
+    uint64_t uGpuTimeNs;
+} CeCommandProfile;
+
+typedef struct {
+    //the queued commands are submitted once there are this many of them, 0 means 64
+    uint32_t uMaxCommandCount;
+    //or once the first of them has waited this long, in nanoseconds. 0 means they only wait for the count
+    uint64_t uMaxDelayNs;
+} CeSubmitBatchCreationArgs;
+
+//called on CE's completion thread with the command that completed and the user data it was registered with
+typedef void (*CeCommandCompletionCallback)(CeCommand command, void* pUserData);
+
 /**
 * Create a CE command from a CE instance using some parameters and write its address to a supplied handle.
 * \param instance the instance the command is going to be created from
@@ -36,12 +69,92 @@ ceEndCommand(CeCommand);
 CeResult
 ceWaitCommand(CeInstance, CeCommand);
 
+/**
+* Check whether the last run of a command completed, without blocking.
+* Returns CE_SUCCESS if it did (or if the command was never run) and CE_NOT_READY if it is still running.
+*/
+CeResult
+ceQueryCommand(CeInstance instance, CeCommand command);
+
+/**
+* Wait for the last run of a command for at most uTimeoutNs nanoseconds.
+* Returns CE_SUCCESS if it completed and CE_TIMEOUT if it is still running.
+*/
+CeResult
+ceWaitCommandTimeout(CeInstance instance, CeCommand command, uint64_t uTimeoutNs);
+
+/**
+* Wait for the last run of several commands, created from the same instance, for at most uTimeoutNs nanoseconds.
+* \param bWaitAll CE_TRUE to wait for all of them, CE_FALSE to return as soon as one of them completed
+* \param pCompletedIndex if not NULL and the function succeeds, receives the index of a completed command
+* Returns CE_SUCCESS when the wait is satisfied and CE_TIMEOUT otherwise.
+*/
+CeResult
+ceWaitCommands(CeInstance instance, const CeCommand* pCommands, uint32_t uCommandCount, CeBool32 bWaitAll,
+    uint64_t uTimeoutNs, uint32_t* pCompletedIndex);
+
+/**
+* Have a function called once the last run of a command completes.
+* The callback runs on a thread owned by the instance, and **must not** block for long
+* since it delays every other callback. The command **must not** be run again before its callback ran.
+*/
+CeResult
+ceSetCommandCompletionCallback(CeInstance instance, CeCommand command, CeCommandCompletionCallback callback, void* pUserData);
+
 CeResult
 ceResetCommand(CeCommand);
 
 CeResult
 ceRunCommand(CeInstance, CeCommand);
 
+/**
+* Run several commands, created from the same instance, with a single queue submission.
+* Each command can still be waited on, queried and given a callback on its own.
+* A command **must not** appear twice in pCommands.
+*/
+CeResult
+ceRunCommands(CeInstance instance, const CeCommand* pCommands, uint32_t uCommandCount);
+
+/**
+* Make the next run of a command wait on the device for a transfer started with ceUploadBufferAsync or ceDownloadBufferAsync.
+* Runs using a buffer after a transfer to or from it **must** wait for that transfer, either this way or on the host.
+* The transfer **must not** be destroyed before the run completed.
+*/
+CeResult
+ceAddCommandTransferWait(CeCommand command, CeTransfer transfer);
+
+/**
+* Create a batch which collects commands and runs them together with ceRunCommands
+* once its count or delay threshold is reached. Batches can be shared by several threads.
+*/
+CeResult
+ceCreateSubmitBatch(CeInstance instance, const CeSubmitBatchCreationArgs* args, CeSubmitBatch* batch);
+
+/**
+* Queue a run of a command in a batch. Waiting on, querying or running a queued command submits its batch first.
+*/
+CeResult
+ceQueueCommand(CeInstance instance, CeSubmitBatch batch, CeCommand command);
+
+//run every command queued in the batch now, also returns the failure of a flush the delay threshold triggered since the last call
+CeResult
+ceFlushSubmitBatch(CeInstance instance, CeSubmitBatch batch);
+
+//runs the commands still queued in the batch before destroying it
+void
+ceDestroySubmitBatch(CeInstance instance, CeSubmitBatch batch);
+
+/**
+* Read the GPU timings of the last run of a command created with profiling enabled.
+* The command **must** have been waited upon.
+* If pPipelineProfiles is NULL only the number of profiled pipelines and the total time are written.
+* \param instance the instance the command was created from
+* \param command the command whose profile is read
+* \param profile pointer to the CeCommandProfile structure the function fills
+*/
+CeResult
+ceGetCommandProfile(CeInstance instance, CeCommand command, CeCommandProfile* profile);
+
 void
 ceDestroyCommand(CeInstance, CeCommand);
 
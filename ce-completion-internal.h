@@ -0,0 +1,28 @@
+#pragma once
+#include "ce-def.h"
+#include "ce-command.h"
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan_core.h>
+
+/*
+* The completion queue owns a thread which waits for the submissions commands were given a
+* completion callback for, and runs each callback once its submission is done.
+* The thread is only started when the first callback is added.
+*/
+typedef struct CeCompletionQueue_t *CeCompletionQueue;
+
+VkResult
+ceCreateCompletionQueue(CeInstance, CeCompletionQueue*);
+
+//the callback is run on the completion thread once the given submission of the command is done
+VkResult
+ceAddCompletionCallback(CeInstance, CeCompletionQueue, CeCommand, uint64_t submission, CeCommandCompletionCallback, void* pUserData);
+
+//called when the command is destroyed, blocks until the callbacks of its completed runs ran and the thread no longer uses it.
+//callbacks of runs which did not complete are dropped
+void
+ceRemoveCompletionCallbacks(CeInstance, CeCompletionQueue, CeCommand);
+
+//stops the completion thread, callbacks which did not run yet are dropped
+void
+ceDestroyCompletionQueue(CeInstance, CeCompletionQueue);
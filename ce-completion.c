@@ -0,0 +1,223 @@
+#include "ce-completion-internal.h"
+#include "ce-def.h"
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan_core.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "ce-command-internal.h"
+
+//how long the thread waits on the GPU before looking for callbacks added in the meantime
+#define CE_COMPLETION_POLL_TIMEOUT_NS 1000000ull
+
+struct CeCompletionEntry {
+    struct CeCompletionEntry* next;
+    CeCommand command;
+    uint64_t submission;
+    CeCommandCompletionCallback callback;
+    void* pUserData;
+};
+
+struct CeCompletionQueue_t {
+    CeInstance instance;
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t condition;
+    struct CeCompletionEntry* entries;
+    uint32_t entryCount;
+    //the commands the thread is waiting on or running callbacks of without holding the lock, polledCount is 0 when it is not
+    CeCommand* polledCommands;
+    uint32_t polledCount;
+    //signalled whenever the thread is done with the polled commands
+    pthread_cond_t pollDoneCondition;
+    //room for every entry, grown when a callback is added so that running out of memory fails ceAddCompletionCallback,
+    //the thread swaps in the spare arrays before it polls again
+    CeCommand* spareCommands;
+    uint64_t* spareSubmissions;
+    uint32_t pollCapacity;
+    CeBool32 threadStarted;
+    CeBool32 stopping;
+};
+
+VkResult
+ceCreateCompletionQueue(CeInstance instance, CeCompletionQueue* target) {
+    *target = calloc(1, sizeof(struct CeCompletionQueue_t));
+    if(!*target)
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    (*target)->instance = instance;
+    pthread_mutex_init(&(*target)->mutex, NULL);
+    pthread_cond_init(&(*target)->condition, NULL);
+    pthread_cond_init(&(*target)->pollDoneCondition, NULL);
+    return VK_SUCCESS;
+}
+
+static void* __completionThread(void* pQueue) {
+    CeCompletionQueue queue = pQueue;
+    CeCommand* commands = NULL;
+    uint64_t* submissions = NULL;
+
+    pthread_mutex_lock(&queue->mutex);
+    while(!queue->stopping) {
+        if(!queue->entries) {
+            pthread_cond_wait(&queue->condition, &queue->mutex);
+            continue;
+        }
+        //the GPU is waited on without holding the lock so that callbacks can keep being added
+        const uint32_t count = queue->entryCount;
+        if(queue->spareCommands) {
+            free(commands);
+            free(submissions);
+            commands = queue->spareCommands;
+            submissions = queue->spareSubmissions;
+            queue->spareCommands = NULL;
+            queue->spareSubmissions = NULL;
+        }
+        uint32_t i = 0;
+        for(struct CeCompletionEntry* entry = queue->entries; entry; entry = entry->next, ++i) {
+            commands[i] = entry->command;
+            submissions[i] = entry->submission;
+        }
+        queue->polledCommands = commands;
+        queue->polledCount = count;
+        pthread_mutex_unlock(&queue->mutex);
+        ceWaitCommandSubmissions(queue->instance, commands, submissions, count, CE_FALSE, CE_COMPLETION_POLL_TIMEOUT_NS);
+        pthread_mutex_lock(&queue->mutex);
+
+        struct CeCompletionEntry* done = NULL;
+        for(struct CeCompletionEntry** link = &queue->entries; *link;) {
+            struct CeCompletionEntry* entry = *link;
+            if(!ceIsCommandSubmissionDone(queue->instance, entry->command, entry->submission)) {
+                link = &entry->next;
+                continue;
+            }
+            *link = entry->next;
+            --queue->entryCount;
+            entry->next = done;
+            done = entry;
+        }
+        //callbacks may add callbacks of their own, so they run without the lock
+        pthread_mutex_unlock(&queue->mutex);
+        for(struct CeCompletionEntry* entry = done, *next; entry; entry = next) {
+            next = entry->next;
+            entry->callback(entry->command, entry->pUserData);
+            free(entry);
+        }
+        pthread_mutex_lock(&queue->mutex);
+        queue->polledCount = 0;
+        pthread_cond_broadcast(&queue->pollDoneCondition);
+    }
+    pthread_mutex_unlock(&queue->mutex);
+    free(commands);
+    free(submissions);
+    return NULL;
+}
+
+VkResult
+ceAddCompletionCallback(CeInstance instance, CeCompletionQueue queue, CeCommand command, uint64_t submission,
+    CeCommandCompletionCallback callback, void* pUserData) {
+    struct CeCompletionEntry* entry = malloc(sizeof(struct CeCompletionEntry));
+    if(!entry)
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    *entry = (struct CeCompletionEntry){
+        .command = command,
+        .submission = submission,
+        .callback = callback,
+        .pUserData = pUserData,
+    };
+    pthread_mutex_lock(&queue->mutex);
+    if(queue->entryCount == queue->pollCapacity) {
+        const uint32_t capacity = queue->pollCapacity ? queue->pollCapacity * 2 : 8;
+        CeCommand* commands = malloc(capacity * sizeof(CeCommand));
+        uint64_t* submissions = malloc(capacity * sizeof(uint64_t));
+        if(!commands || !submissions) {
+            pthread_mutex_unlock(&queue->mutex);
+            free(commands);
+            free(submissions);
+            free(entry);
+            return VK_ERROR_OUT_OF_HOST_MEMORY;
+        }
+        //spare arrays the thread has not taken yet are too small now
+        free(queue->spareCommands);
+        free(queue->spareSubmissions);
+        queue->spareCommands = commands;
+        queue->spareSubmissions = submissions;
+        queue->pollCapacity = capacity;
+    }
+    if(!queue->threadStarted) {
+        if(pthread_create(&queue->thread, NULL, __completionThread, queue)) {
+            pthread_mutex_unlock(&queue->mutex);
+            free(entry);
+            return VK_ERROR_INITIALIZATION_FAILED;
+        }
+        queue->threadStarted = CE_TRUE;
+    }
+    entry->next = queue->entries;
+    queue->entries = entry;
+    ++queue->entryCount;
+    pthread_cond_signal(&queue->condition);
+    pthread_mutex_unlock(&queue->mutex);
+    return VK_SUCCESS;
+}
+
+static CeBool32 __isCommandPolled(CeCompletionQueue queue, CeCommand command) {
+    for(uint32_t i = 0; i < queue->polledCount; ++i) {
+        if(queue->polledCommands[i] == command)
+            return CE_TRUE;
+    }
+    return CE_FALSE;
+}
+
+static CeBool32 __hasCommandEntry(CeCompletionQueue queue, CeCommand command) {
+    for(struct CeCompletionEntry* entry = queue->entries; entry; entry = entry->next) {
+        if(entry->command == command)
+            return CE_TRUE;
+    }
+    return CE_FALSE;
+}
+
+void
+ceRemoveCompletionCallbacks(CeInstance instance, CeCompletionQueue queue, CeCommand command) {
+    pthread_mutex_lock(&queue->mutex);
+    if(!queue->threadStarted) {
+        pthread_mutex_unlock(&queue->mutex);
+        return;
+    }
+    //the runs of a command being destroyed are over, those which did not complete never will
+    for(struct CeCompletionEntry** link = &queue->entries; *link;) {
+        struct CeCompletionEntry* entry = *link;
+        if(entry->command != command || ceIsCommandSubmissionDone(instance, command, entry->submission)) {
+            link = &entry->next;
+            continue;
+        }
+        *link = entry->next;
+        --queue->entryCount;
+        free(entry);
+    }
+    //a callback destroying its own command is run by the thread, which is done with the command once the callback returns
+    const CeBool32 isCompletionThread = pthread_equal(pthread_self(), queue->thread) ? CE_TRUE : CE_FALSE;
+    while(!isCompletionThread && (__hasCommandEntry(queue, command) || __isCommandPolled(queue, command)))
+        pthread_cond_wait(&queue->pollDoneCondition, &queue->mutex);
+    pthread_mutex_unlock(&queue->mutex);
+}
+
+void
+ceDestroyCompletionQueue(CeInstance instance, CeCompletionQueue queue) {
+    if(!queue)
+        return;
+    pthread_mutex_lock(&queue->mutex);
+    queue->stopping = CE_TRUE;
+    pthread_cond_signal(&queue->condition);
+    CeBool32 threadStarted = queue->threadStarted;
+    pthread_mutex_unlock(&queue->mutex);
+    if(threadStarted)
+        pthread_join(queue->thread, NULL);
+    for(struct CeCompletionEntry* entry = queue->entries, *next; entry; entry = next) {
+        next = entry->next;
+        free(entry);
+    }
+    free(queue->spareCommands);
+    free(queue->spareSubmissions);
+    pthread_mutex_destroy(&queue->mutex);
+    pthread_cond_destroy(&queue->condition);
+    pthread_cond_destroy(&queue->pollDoneCondition);
+    free(queue);
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include "ce-def.h"
+#include "ce-cpu.h"
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan_core.h>
+
+/*
+* The CPU backend runs loops over a range of indices on a pool of worker threads.
+* Each worker starts on its own contiguous block of the range, the same block of every loop, and takes chunks from the
+* front of it; workers which run out steal the back half of another worker's block. Workers are pinned to CPUs node by node,
+* so that with first-touch placement the memory a worker's blocks cover stays on its NUMA node from one loop to the next.
+*/
+typedef struct CeCpuBackend_t *CeCpuBackend;
+
+//runs groups first to first + count - 1 of a loop
+typedef void (*CeCpuLoopFunction)(void* pUserData, uint32_t first, uint32_t count);
+
+//0 workers means one per CPU the process can run on
+VkResult
+ceCreateCpuBackend(uint32_t workerCount, CeCpuBackend*);
+
+VkResult
+ceRegisterCpuBackendKernel(CeCpuBackend, const char* name, CeCpuKernelFunction);
+
+//NULL if no kernel was registered under the name
+CeCpuKernelFunction
+ceFindCpuBackendKernel(CeCpuBackend, const char* name);
+
+//runs function over every index below count and returns once it is done. loops from several threads run one after the other
+void
+ceRunCpuLoop(CeCpuBackend, uint32_t count, CeCpuLoopFunction function, void* pUserData);
+
+//runs the kernel over every work group of the dispatch
+void
+ceRunCpuDispatch(CeCpuBackend, CeCpuKernelFunction, const CeCpuDispatch*);
+
+//copies source to destination, or zeroes destination if source is NULL, with each worker touching the block it later processes first
+void
+ceFillCpuMemory(CeCpuBackend, void* destination, const void* source, uint64_t size);
+
+void
+ceDestroyCpuBackend(CeCpuBackend);
@@ -0,0 +1,391 @@
+#define _GNU_SOURCE
+#include "ce-cpu.h"
+#include "ce-def.h"
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan_core.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include "ce-cpu-internal.h"
+#include "ce-instance-internal.h"
+#include "ce-error-internal.h"
+
+//chunks a worker's block is split in, enough for the workers which finish first to have something to steal
+#define CE_CPU_CHUNKS_PER_WORKER 8
+//memory is first touched in chunks of this many bytes
+#define CE_CPU_FILL_CHUNK_SIZE (64u << 10)
+#define CE_CPU_MAX_NODES 1024
+
+struct CeCpuKernelEntry {
+    char* name;
+    CeCpuKernelFunction function;
+};
+
+struct CeCpuWorker {
+    //the groups [low 32 bits, high 32 bits) the worker has left, taken from the front by the worker and stolen from the back
+    _Alignas(64) atomic_uint_fast64_t range;
+    pthread_t thread;
+    CeCpuBackend backend;
+    uint32_t index;
+    //the CPU the worker is pinned to, -1 when it is not pinned
+    int cpu;
+    CeBool32 threadStarted;
+};
+
+struct CeCpuBackend_t {
+    struct CeCpuWorker* workers;
+    uint32_t workerCount;
+    //held for the whole of a loop, so that loops run one at a time
+    pthread_mutex_t loopMutex;
+    pthread_mutex_t mutex;
+    pthread_cond_t wake;
+    pthread_cond_t finished;
+    //increased by every loop, workers run a loop once for each value
+    uint64_t generation;
+    uint32_t busyWorkerCount;
+    CeBool32 stopping;
+    CeCpuLoopFunction function;
+    void* pUserData;
+    uint32_t chunkSize;
+    pthread_mutex_t kernelMutex;
+    struct CeCpuKernelEntry* kernels;
+    uint32_t kernelCount;
+    uint32_t kernelCapacity;
+};
+
+static uint64_t __packRange(uint32_t begin, uint32_t end) {
+    return (uint64_t)begin | ((uint64_t)end << 32);
+}
+
+static CeBool32 __takeChunk(CeCpuBackend backend, struct CeCpuWorker* worker, uint32_t* first, uint32_t* count) {
+    uint64_t range = atomic_load(&worker->range);
+    for(;;) {
+        const uint32_t begin = (uint32_t)range, end = (uint32_t)(range >> 32);
+        if(begin >= end)
+            return CE_FALSE;
+        const uint32_t taken = end - begin < backend->chunkSize ? end - begin : backend->chunkSize;
+        if(atomic_compare_exchange_weak(&worker->range, &range, __packRange(begin + taken, end))) {
+            *first = begin;
+            *count = taken;
+            return CE_TRUE;
+        }
+    }
+}
+
+//moves the back half of another worker's range to the worker, whose own range is empty
+static CeBool32 __steal(CeCpuBackend backend, struct CeCpuWorker* worker) {
+    for(uint32_t i = 1; i < backend->workerCount; ++i) {
+        struct CeCpuWorker* victim = &backend->workers[(worker->index + i) % backend->workerCount];
+        uint64_t range = atomic_load(&victim->range);
+        for(;;) {
+            const uint32_t begin = (uint32_t)range, end = (uint32_t)(range >> 32);
+            if(begin >= end)
+                break;
+            const uint32_t middle = begin + (end - begin) / 2;
+            if(atomic_compare_exchange_weak(&victim->range, &range, __packRange(begin, middle))) {
+                atomic_store(&worker->range, __packRange(middle, end));
+                return CE_TRUE;
+            }
+        }
+    }
+    return CE_FALSE;
+}
+
+static void __runWorker(CeCpuBackend backend, struct CeCpuWorker* worker) {
+    do {
+        uint32_t first, count;
+        while(__takeChunk(backend, worker, &first, &count))
+            backend->function(backend->pUserData, first, count);
+    } while(__steal(backend, worker));
+}
+
+static void* __workerThread(void* pWorker) {
+    struct CeCpuWorker* worker = pWorker;
+    CeCpuBackend backend = worker->backend;
+    if(worker->cpu >= 0) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(worker->cpu, &cpus);
+        pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    }
+    uint64_t generation = 0;
+    pthread_mutex_lock(&backend->mutex);
+    for(;;) {
+        while(!backend->stopping && backend->generation == generation)
+            pthread_cond_wait(&backend->wake, &backend->mutex);
+        if(backend->stopping)
+            break;
+        generation = backend->generation;
+        pthread_mutex_unlock(&backend->mutex);
+        __runWorker(backend, worker);
+        pthread_mutex_lock(&backend->mutex);
+        if(--backend->busyWorkerCount == 0)
+            pthread_cond_signal(&backend->finished);
+    }
+    pthread_mutex_unlock(&backend->mutex);
+    return NULL;
+}
+
+//appends the CPUs of a sysfs cpulist such as "0-3,8-11" which the process can run on and are not listed yet
+static uint32_t __parseCpuList(const char* list, const cpu_set_t* allowed, int* cpus, uint32_t count, uint32_t capacity) {
+    const char* cursor = list;
+    while(*cursor && count < capacity) {
+        char* next;
+        long first = strtol(cursor, &next, 10);
+        if(next == cursor)
+            break;
+        long last = first;
+        if(*next == '-')
+            last = strtol(next + 1, &next, 10);
+        for(long cpu = first; cpu <= last && count < capacity; ++cpu) {
+            if(cpu < 0 || cpu >= CPU_SETSIZE || !CPU_ISSET(cpu, allowed))
+                continue;
+            CeBool32 isListed = CE_FALSE;
+            for(uint32_t i = 0; i < count && !isListed; ++i)
+                isListed = cpus[i] == cpu;
+            if(!isListed)
+                cpus[count++] = (int)cpu;
+        }
+        cursor = *next == ',' ? next + 1 : next;
+        if(*cursor == '\n')
+            break;
+    }
+    return count;
+}
+
+//the CPUs the process can run on, node by node. 0 when the nodes cannot be read, the workers are left unpinned then
+static uint32_t __getCpuOrder(int* cpus, uint32_t capacity) {
+    cpu_set_t allowed;
+    if(sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+        return 0;
+    uint32_t count = 0;
+    for(uint32_t node = 0; node < CE_CPU_MAX_NODES; ++node) {
+        char path[64];
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%u/cpulist", node);
+        FILE* file = fopen(path, "r");
+        //node numbers can have gaps, so a missing node only ends the search once none was found at all
+        if(!file) {
+            if(!count && node)
+                break;
+            continue;
+        }
+        char list[4096];
+        if(fgets(list, sizeof(list), file))
+            count = __parseCpuList(list, &allowed, cpus, count, capacity);
+        fclose(file);
+    }
+    return count;
+}
+
+static uint32_t __getAvailableCpuCount(void) {
+    cpu_set_t allowed;
+    if(sched_getaffinity(0, sizeof(allowed), &allowed) == 0 && CPU_COUNT(&allowed) > 0)
+        return (uint32_t)CPU_COUNT(&allowed);
+    const long online = sysconf(_SC_NPROCESSORS_ONLN);
+    return online > 0 ? (uint32_t)online : 1;
+}
+
+VkResult
+ceCreateCpuBackend(uint32_t workerCount, CeCpuBackend* target) {
+    *target = calloc(1, sizeof(struct CeCpuBackend_t));
+    if(!*target)
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    CeCpuBackend backend = *target;
+    backend->workerCount = workerCount ? workerCount : __getAvailableCpuCount();
+    pthread_mutex_init(&backend->loopMutex, NULL);
+    pthread_mutex_init(&backend->mutex, NULL);
+    pthread_cond_init(&backend->wake, NULL);
+    pthread_cond_init(&backend->finished, NULL);
+    pthread_mutex_init(&backend->kernelMutex, NULL);
+    backend->workers = aligned_alloc(64, backend->workerCount * sizeof(struct CeCpuWorker));
+    if(!backend->workers)
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    memset(backend->workers, 0, backend->workerCount * sizeof(struct CeCpuWorker));
+    int* cpuOrder = malloc(CPU_SETSIZE * sizeof(int));
+    const uint32_t cpuCount = cpuOrder ? __getCpuOrder(cpuOrder, CPU_SETSIZE) : 0;
+    VkResult result = VK_SUCCESS;
+    for(uint32_t i = 0; i < backend->workerCount; ++i) {
+        struct CeCpuWorker* worker = &backend->workers[i];
+        atomic_init(&worker->range, 0);
+        worker->backend = backend;
+        worker->index = i;
+        worker->cpu = cpuCount ? cpuOrder[i % cpuCount] : -1;
+        if(pthread_create(&worker->thread, NULL, __workerThread, worker) != 0) {
+            result = VK_ERROR_INITIALIZATION_FAILED;
+            break;
+        }
+        worker->threadStarted = CE_TRUE;
+    }
+    free(cpuOrder);
+    return result;
+}
+
+void
+ceRunCpuLoop(CeCpuBackend backend, uint32_t count, CeCpuLoopFunction function, void* pUserData) {
+    if(!count)
+        return;
+    pthread_mutex_lock(&backend->loopMutex);
+    //worker i always starts on the i-th block, so it keeps touching the same memory loop after loop
+    const uint32_t workerCount = backend->workerCount;
+    for(uint32_t i = 0; i < workerCount; ++i) {
+        const uint32_t begin = (uint32_t)((uint64_t)count * i / workerCount);
+        const uint32_t end = (uint32_t)((uint64_t)count * (i + 1) / workerCount);
+        atomic_store(&backend->workers[i].range, __packRange(begin, end));
+    }
+    const uint32_t chunkCount = workerCount * CE_CPU_CHUNKS_PER_WORKER;
+    backend->chunkSize = count > chunkCount ? count / chunkCount : 1;
+    backend->function = function;
+    backend->pUserData = pUserData;
+    pthread_mutex_lock(&backend->mutex);
+    ++backend->generation;
+    backend->busyWorkerCount = workerCount;
+    pthread_cond_broadcast(&backend->wake);
+    while(backend->busyWorkerCount)
+        pthread_cond_wait(&backend->finished, &backend->mutex);
+    pthread_mutex_unlock(&backend->mutex);
+    pthread_mutex_unlock(&backend->loopMutex);
+}
+
+struct CeCpuKernelRun {
+    CeCpuKernelFunction kernel;
+    const CeCpuDispatch* dispatch;
+    //the flat group index loop index 0 stands for
+    uint64_t base;
+};
+
+//the groups are numbered x first, then y, then z. A range crossing rows is handed to the kernel one row at a time
+static void __runKernelGroups(void* pRun, uint32_t first, uint32_t count) {
+    const struct CeCpuKernelRun* run = pRun;
+    const uint64_t width = run->dispatch->uGroupCount[0];
+    const uint64_t height = run->dispatch->uGroupCount[1];
+    uint64_t index = run->base + first;
+    const uint64_t end = index + count;
+    while(index < end) {
+        const uint64_t x = index % width, row = index / width;
+        const uint64_t groupCount = width - x < end - index ? width - x : end - index;
+        run->kernel(run->dispatch, (uint32_t)x, (uint32_t)groupCount, (uint32_t)(row % height), (uint32_t)(row / height));
+        index += groupCount;
+    }
+}
+
+void
+ceRunCpuDispatch(CeCpuBackend backend, CeCpuKernelFunction kernel, const CeCpuDispatch* dispatch) {
+    struct CeCpuKernelRun run = {
+        .kernel = kernel,
+        .dispatch = dispatch,
+    };
+    //every group of the dispatch is split between the workers at once, instead of waking them for each row
+    const uint64_t groupCount = (uint64_t)dispatch->uGroupCount[0] * dispatch->uGroupCount[1] * dispatch->uGroupCount[2];
+    for(run.base = 0; run.base < groupCount; run.base += UINT32_MAX) {
+        const uint64_t count = groupCount - run.base;
+        ceRunCpuLoop(backend, count < UINT32_MAX ? (uint32_t)count : UINT32_MAX, __runKernelGroups, &run);
+    }
+}
+
+struct CeCpuFill {
+    char* destination;
+    const char* source;
+    uint64_t size;
+};
+
+static void __fillChunks(void* pFill, uint32_t first, uint32_t count) {
+    const struct CeCpuFill* fill = pFill;
+    const uint64_t begin = (uint64_t)first * CE_CPU_FILL_CHUNK_SIZE;
+    uint64_t end = (uint64_t)(first + count) * CE_CPU_FILL_CHUNK_SIZE;
+    end = end < fill->size ? end : fill->size;
+    if(fill->source)
+        memcpy(fill->destination + begin, fill->source + begin, end - begin);
+    else
+        memset(fill->destination + begin, 0, end - begin);
+}
+
+void
+ceFillCpuMemory(CeCpuBackend backend, void* destination, const void* source, uint64_t size) {
+    struct CeCpuFill fill = {
+        .destination = destination,
+        .source = source,
+        .size = size,
+    };
+    const uint64_t chunkCount = (size + CE_CPU_FILL_CHUNK_SIZE - 1) / CE_CPU_FILL_CHUNK_SIZE;
+    ceRunCpuLoop(backend, (uint32_t)chunkCount, __fillChunks, &fill);
+}
+
+VkResult
+ceRegisterCpuBackendKernel(CeCpuBackend backend, const char* name, CeCpuKernelFunction function) {
+    pthread_mutex_lock(&backend->kernelMutex);
+    for(uint32_t i = 0; i < backend->kernelCount; ++i) {
+        if(strcmp(backend->kernels[i].name, name) == 0) {
+            backend->kernels[i].function = function;
+            pthread_mutex_unlock(&backend->kernelMutex);
+            return VK_SUCCESS;
+        }
+    }
+    if(backend->kernelCount == backend->kernelCapacity) {
+        const uint32_t capacity = backend->kernelCapacity ? backend->kernelCapacity * 2 : 8;
+        struct CeCpuKernelEntry* kernels = realloc(backend->kernels, capacity * sizeof(struct CeCpuKernelEntry));
+        if(!kernels) {
+            pthread_mutex_unlock(&backend->kernelMutex);
+            return VK_ERROR_OUT_OF_HOST_MEMORY;
+        }
+        backend->kernels = kernels;
+        backend->kernelCapacity = capacity;
+    }
+    backend->kernels[backend->kernelCount++] = (struct CeCpuKernelEntry){
+        .name = strdup(name),
+        .function = function,
+    };
+    pthread_mutex_unlock(&backend->kernelMutex);
+    return VK_SUCCESS;
+}
+
+CeCpuKernelFunction
+ceFindCpuBackendKernel(CeCpuBackend backend, const char* name) {
+    CeCpuKernelFunction function = NULL;
+    pthread_mutex_lock(&backend->kernelMutex);
+    for(uint32_t i = 0; i < backend->kernelCount && !function; ++i) {
+        if(strcmp(backend->kernels[i].name, name) == 0)
+            function = backend->kernels[i].function;
+    }
+    pthread_mutex_unlock(&backend->kernelMutex);
+    return function;
+}
+
+void
+ceDestroyCpuBackend(CeCpuBackend backend) {
+    if(!backend)
+        return;
+    pthread_mutex_lock(&backend->mutex);
+    backend->stopping = CE_TRUE;
+    pthread_cond_broadcast(&backend->wake);
+    pthread_mutex_unlock(&backend->mutex);
+    for(uint32_t i = 0; backend->workers && i < backend->workerCount; ++i) {
+        if(backend->workers[i].threadStarted)
+            pthread_join(backend->workers[i].thread, NULL);
+    }
+    for(uint32_t i = 0; i < backend->kernelCount; ++i)
+        free(backend->kernels[i].name);
+    free(backend->kernels);
+    free(backend->workers);
+    pthread_mutex_destroy(&backend->loopMutex);
+    pthread_mutex_destroy(&backend->mutex);
+    pthread_cond_destroy(&backend->wake);
+    pthread_cond_destroy(&backend->finished);
+    pthread_mutex_destroy(&backend->kernelMutex);
+    free(backend);
+}
+
+CeResult
+ceRegisterCpuKernel(CeInstance instance, const char* pShaderFilename, CeCpuKernelFunction pfnKernel) {
+    if(!instance || !pShaderFilename || !pfnKernel)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot register CPU kernel: some parameters were NULL");
+    CeCpuBackend backend = ceGetInstanceCpuBackend(instance);
+    if(!backend)
+        return CE_SUCCESS;
+    if(ceRegisterCpuBackendKernel(backend, pShaderFilename, pfnKernel) != VK_SUCCESS)
+        return ceResult(CE_ERROR_INTERNAL, "stdlib failed to allocate a CPU kernel entry");
+    return CE_SUCCESS;
+}
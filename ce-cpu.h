@@ -0,0 +1,36 @@
+#pragma once
+#include "ce-def.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//what a CPU kernel gets in place of a compute shader's bindings, push constants and dispatch size
+typedef struct {
+    //the memory of each binding, in binding order, then the live constants with their values when the command started running
+    void* const* ppBindings;
+    const uint32_t* pBindingElementCounts;
+    //the push constants which are not live, laid out as the shader sees them
+    const void* pConstants;
+    uint32_t uGroupCount[3];
+} CeCpuDispatch;
+
+/*
+* Runs uGroupCountX work groups from x = uFirstGroupX, at y = uGroupY and z = uGroupZ.
+* Each work group stands for all of the shader's local invocations, which the kernel loops over itself.
+* The groups of a call are contiguous so that those loops walk memory in order and can be vectorized.
+*/
+typedef void (*CeCpuKernelFunction)(const CeCpuDispatch* pDispatch, uint32_t uFirstGroupX, uint32_t uGroupCountX,
+    uint32_t uGroupY, uint32_t uGroupZ);
+
+/**
+* Register the native kernel pipelines of a CPU instance run in place of a shader.
+* Pipelines created afterwards whose pShaderFilename is pShaderFilename run pfnKernel, registering a name again replaces its kernel.
+* Vulkan instances ignore registrations, so kernels can be registered whichever backend an instance ended up on.
+* \param pShaderFilename the shader's file name, compared as is
+*/
+CeResult
+ceRegisterCpuKernel(CeInstance instance, const char* pShaderFilename, CeCpuKernelFunction pfnKernel);
+
+#ifdef __cplusplus
+}
+#endif
@@ -11,6 +11,17 @@ extern "C" {
 CE_MAKE_HANDLE(CeInstance)
 CE_MAKE_HANDLE(CePipeline)
 CE_MAKE_HANDLE(CeCommand)
+CE_MAKE_HANDLE(CeBuffer)
+CE_MAKE_HANDLE(CeGraph)
+CE_MAKE_HANDLE(CeSubmitBatch)
+CE_MAKE_HANDLE(CeTransfer)
+CE_MAKE_HANDLE(CeShardedPipeline)
+CE_MAKE_HANDLE(CeStream)
+CE_MAKE_HANDLE(CeSort)
+CE_MAKE_HANDLE(CeReduce)
+CE_MAKE_HANDLE(CeScan)
+CE_MAKE_HANDLE(CeCompact)
+CE_MAKE_HANDLE(CeExecutable)
 
 #define DEBUG
 
@@ -23,7 +34,11 @@ typedef enum {
     CE_ERROR_NULL_PASSED,
     CE_ERROR_INVALID_ARG,
     CE_ERROR_INTERNAL,
-    CE_ERROR_BINDING_NOT_MAPPED
+    CE_ERROR_BINDING_NOT_MAPPED,
+    //not an error: the requested results are not available yet
+    CE_NOT_READY,
+    //not an error: the wait ended before what was waited for completed
+    CE_TIMEOUT
 } CeResult;
 
 typedef enum {
@@ -35,6 +50,21 @@ typedef enum {
 
 typedef uint32_t CeBool32;
 
+typedef enum {
+    //device-local unless the binding is kept mapped
+    CE_BINDING_PLACEMENT_AUTO = 0,
+    //lives in memory the device reads fastest, filled and read back through the instance staging buffer
+    CE_BINDING_PLACEMENT_DEVICE_LOCAL,
+    //lives in memory the host can map directly
+    CE_BINDING_PLACEMENT_HOST_VISIBLE
+} CeBindingPlacement;
+
+typedef enum {
+    CE_BINDING_ACCESS_READ_WRITE = 0,
+    CE_BINDING_ACCESS_READ_ONLY,
+    CE_BINDING_ACCESS_WRITE_ONLY
+} CeBindingAccess;
+
 #ifdef __cplusplus
 }
 #endif
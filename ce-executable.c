@@ -0,0 +1,186 @@
+#include "ce-executable.h"
+#include "ce-def.h"
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan_core.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ce-command.h"
+#include "ce-buffer.h"
+#include "ce-command-internal.h"
+#include "ce-buffer-internal.h"
+#include "ce-error-internal.h"
+#include "ce-trace-internal.h"
+
+#define CE_DEFAULT_MAX_LAUNCHES_IN_FLIGHT 2
+
+/*
+* A launch slot is a command recorded once, which copies its own host-visible copy of the parameters to the parameter
+* buffer before running the recorded work. Launches go round the slots, so the parameters of a slot are only written
+* once the launch which last used it completed, while the other slots can still be running.
+*/
+struct CeExecutableSlot {
+    CeCommand command;
+    //NULL when the executable has no parameter buffer
+    CeBuffer parameters;
+    void* mappedParameters;
+};
+
+struct CeExecutable_t {
+    struct CeExecutableSlot* slots;
+    uint32_t slotCount;
+    uint64_t launchCount;
+    //the parameters of the next launch
+    void* parameters;
+    uint64_t parameterSize;
+};
+
+static CeResult __readInitialParameters(CeInstance instance, CeBuffer parameterBuffer, CeExecutable executable) {
+    executable->parameterSize = ceGetBufferSize(parameterBuffer);
+    executable->parameters = malloc(executable->parameterSize);
+    if(!executable->parameters)
+        return ceResult(CE_ERROR_INTERNAL, "stdlib failed to allocate the parameters of an executable");
+    void* mapped;
+    CeResult result = ceMapBufferMemory(instance, parameterBuffer, &mapped);
+    if(result != CE_SUCCESS)
+        return result;
+    memcpy(executable->parameters, mapped, executable->parameterSize);
+    ceUnmapBufferMemory(instance, parameterBuffer);
+    return CE_SUCCESS;
+}
+
+static CeResult __createSlot(CeInstance instance, const CeExecutableCreationArgs* args, CeExecutable executable,
+    struct CeExecutableSlot* slot) {
+    if(args->pParameterBuffer) {
+        CeBufferCreationArgs bufferArgs = {
+            .uElementSize = 1,
+            .uElementCount = (uint32_t)executable->parameterSize,
+            .pInitialData = executable->parameters,
+            .bKeepMapped = CE_TRUE,
+            .ePlacement = CE_BINDING_PLACEMENT_HOST_VISIBLE,
+        };
+        CeResult result = ceCreateBuffer(instance, &bufferArgs, &slot->parameters);
+        if(result != CE_SUCCESS)
+            return result;
+        result = ceMapBufferMemory(instance, slot->parameters, &slot->mappedParameters);
+        if(result != CE_SUCCESS)
+            return result;
+    }
+    CeCommandCreationArgs commandArgs = {0};
+    CeResult result = ceCreateCommand(instance, &commandArgs, &slot->command);
+    if(result != CE_SUCCESS)
+        return result;
+    result = ceBeginCommand(slot->command);
+    if(result != CE_SUCCESS)
+        return result;
+    if(slot->parameters)
+        ceRecordCommandCopy(slot->command, slot->parameters, args->pParameterBuffer);
+    result = ceAppendCommandOps(slot->command, args->pCommand);
+    if(result != CE_SUCCESS)
+        return result;
+    return ceEndCommand(slot->command);
+}
+
+CeResult
+ceCreateExecutable(CeInstance instance, const CeExecutableCreationArgs* args, CeExecutable* executable) {
+    if(!instance || !args || !executable || !args->pCommand)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot create executable: some parameters were NULL");
+    if(args->pParameterBuffer && ceGetBufferSize(args->pParameterBuffer) > UINT32_MAX)
+        return ceResult(CE_ERROR_INVALID_ARG, "cannot create executable: the parameter buffer is larger than 4GiB");
+    uint64_t traceBegin = ceTraceBegin();
+    *executable = calloc(1, sizeof(struct CeExecutable_t));
+    if(!*executable)
+        return ceResult(CE_ERROR_INTERNAL, "stdlib failed to allocate an executable");
+    CeResult result = args->pParameterBuffer ? __readInitialParameters(instance, args->pParameterBuffer, *executable) : CE_SUCCESS;
+    if(result == CE_SUCCESS) {
+        (*executable)->slotCount = args->uMaxLaunchesInFlight ? args->uMaxLaunchesInFlight : CE_DEFAULT_MAX_LAUNCHES_IN_FLIGHT;
+        (*executable)->slots = calloc((*executable)->slotCount, sizeof(struct CeExecutableSlot));
+        if(!(*executable)->slots) {
+            (*executable)->slotCount = 0;
+            result = ceResult(CE_ERROR_INTERNAL, "stdlib failed to allocate the launch slots of an executable");
+        }
+    }
+    for(uint32_t i = 0; i < (*executable)->slotCount && result == CE_SUCCESS; ++i)
+        result = __createSlot(instance, args, *executable, &(*executable)->slots[i]);
+    if(result != CE_SUCCESS) {
+        //the slots created so far never ran, they can go straight away
+        ceDestroyExecutable(instance, *executable);
+        *executable = NULL;
+        return result;
+    }
+    ceTraceEnd("ceCreateExecutable", traceBegin);
+    return CE_SUCCESS;
+}
+
+CeResult
+ceSetExecutableParameters(CeExecutable executable, uint64_t uOffset, const void* pData, uint64_t uSize) {
+    if(!executable || !pData)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot set executable parameters: some parameters were NULL");
+    if(uOffset + uSize > executable->parameterSize)
+        return ceResult(CE_ERROR_INVALID_ARG, "cannot set executable parameters: the range goes past the end of the parameter buffer");
+    memcpy((char*)executable->parameters + uOffset, pData, uSize);
+    return CE_SUCCESS;
+}
+
+static struct CeExecutableSlot* __getNextSlot(CeExecutable executable) {
+    return &executable->slots[executable->launchCount % executable->slotCount];
+}
+
+CeResult
+ceAddExecutableTransferWait(CeExecutable executable, CeTransfer transfer) {
+    if(!executable || !transfer)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot make executable wait for transfer: some parameters were NULL");
+    return ceAddCommandTransferWait(__getNextSlot(executable)->command, transfer);
+}
+
+CeResult
+ceLaunchExecutable(CeInstance instance, CeExecutable executable) {
+    if(!instance || !executable)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot launch executable: some parameters were NULL");
+    struct CeExecutableSlot* slot = __getNextSlot(executable);
+    //the slot's parameters are read by its previous launch until it completes
+    CeResult result = ceWaitCommand(instance, slot->command);
+    if(result != CE_SUCCESS)
+        return result;
+    if(slot->parameters)
+        memcpy(slot->mappedParameters, executable->parameters, executable->parameterSize);
+    //every launch copies to the same parameter buffer, so it cannot start before the previous one is done with it
+    CeCommand previous = ceGetExecutableLaunchCommand(executable);
+    if(previous && previous != slot->command)
+        ceSetCommandRunAfter(slot->command, previous);
+    result = ceRunCommand(instance, slot->command);
+    if(result != CE_SUCCESS)
+        return result;
+    ++executable->launchCount;
+    return CE_SUCCESS;
+}
+
+CeCommand
+ceGetExecutableLaunchCommand(CeExecutable executable) {
+    if(!executable || !executable->launchCount)
+        return NULL;
+    return executable->slots[(executable->launchCount - 1) % executable->slotCount].command;
+}
+
+CeResult
+ceWaitExecutable(CeInstance instance, CeExecutable executable) {
+    if(!instance || !executable)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot wait for executable: some parameters were NULL");
+    //launches complete in order, so the last one completing means they all did
+    CeCommand last = ceGetExecutableLaunchCommand(executable);
+    return last ? ceWaitCommand(instance, last) : CE_SUCCESS;
+}
+
+void
+ceDestroyExecutable(CeInstance instance, CeExecutable executable) {
+    if(!executable)
+        return;
+    for(uint32_t i = 0; i < executable->slotCount; ++i) {
+        if(executable->slots[i].command)
+            ceDestroyCommand(instance, executable->slots[i].command);
+        if(executable->slots[i].parameters)
+            ceDestroyBuffer(instance, executable->slots[i].parameters);
+    }
+    free(executable->slots);
+    free(executable->parameters);
+    free(executable);
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include "ce-def.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    //a command which was recorded, its recording is copied so the command can be reset or destroyed once the executable exists
+    CeCommand pCommand;
+    //optional, the buffer the recorded pipelines read their per-launch parameters from, set with ceSetExecutableParameters
+    CeBuffer pParameterBuffer;
+    //launches which can run at the same time before a launch waits on the host for an earlier one to complete, 0 means 2
+    uint32_t uMaxLaunchesInFlight;
+} CeExecutableCreationArgs;
+
+/**
+* Compile a recorded command into an executable, recorded once and launched any number of times with a single submit.
+* Each launch first copies the parameters set since the previous one to pParameterBuffer, then runs what was recorded.
+* The pipelines and secondary commands recorded to pCommand **must** outlive the executable.
+* \param instance the instance the command was created from
+* \param args pointer to a CeExecutableCreationArgs structure
+* \param executable the handle the function writes to
+*/
+CeResult
+ceCreateExecutable(CeInstance instance, const CeExecutableCreationArgs* args, CeExecutable* executable);
+
+/**
+* Set parameters of the next launches, uSize bytes written at uOffset of the parameter buffer.
+* The parameters start as the parameter buffer's content when the executable was created, and keep their values from one
+* launch to the next. Launches which were already made are not affected.
+*/
+CeResult
+ceSetExecutableParameters(CeExecutable executable, uint64_t uOffset, const void* pData, uint64_t uSize);
+
+/**
+* Make the next launch wait on the device for a transfer, to feed it new input without waiting on the host.
+*/
+CeResult
+ceAddExecutableTransferWait(CeExecutable executable, CeTransfer transfer);
+
+/**
+* Launch an executable. Launches run one after the other, each of them starting once the previous one completed.
+* When uMaxLaunchesInFlight launches are already running the call waits for the oldest one.
+* On devices without timeline semaphores that ordering is kept on the host: each launch waits for the previous one
+* to complete before it is submitted, so launches never overlap the host's work.
+*/
+CeResult
+ceLaunchExecutable(CeInstance instance, CeExecutable executable);
+
+/**
+* Get the command the last launch ran, NULL before the first launch. It can be passed as the afterCommand of transfers,
+* to ceWaitCommand or to ceSetCommandCompletionCallback, but **must not** be recorded, run or destroyed.
+*/
+CeCommand
+ceGetExecutableLaunchCommand(CeExecutable executable);
+
+/**
+* Wait for every launch of an executable to complete.
+*/
+CeResult
+ceWaitExecutable(CeInstance instance, CeExecutable executable);
+
+/**
+* Destroy an executable, none of its launches **must** still be running.
+*/
+void
+ceDestroyExecutable(CeInstance instance, CeExecutable executable);
+
+#ifdef __cplusplus
+}
+#endif
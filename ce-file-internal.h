@@ -0,0 +1,10 @@
+#pragma once
+#include "ce-def.h"
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan_core.h>
+#include <stddef.h>
+
+//writes the chunks one after the other to a temporary file next to the target, syncs it and renames it over the target,
+//so readers see either the old file or the whole new one. Concurrent writers each use their own temporary file
+VkResult
+ceWriteFileAtomically(const char* filename, const void* const* pChunks, const size_t* pChunkSizes, uint32_t chunkCount);
@@ -0,0 +1,39 @@
+#include "ce-file-internal.h"
+#include "ce-def.h"
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan_core.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdatomic.h>
+
+//the pid keeps processes apart and the counter keeps the writers of one process apart
+static atomic_ulong temporaryFileCounter;
+
+VkResult
+ceWriteFileAtomically(const char* filename, const void* const* pChunks, const size_t* pChunkSizes, uint32_t chunkCount) {
+    size_t nameLength = strlen(filename) + 48;
+    char* temporaryName = malloc(nameLength);
+    if(!temporaryName)
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    snprintf(temporaryName, nameLength, "%s.%ld.%lu.tmp", filename, (long)getpid(),
+        atomic_fetch_add(&temporaryFileCounter, 1));
+    FILE* file = fopen(temporaryName, "wb");
+    if(!file) {
+        free(temporaryName);
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+    CeBool32 written = CE_TRUE;
+    for(uint32_t i = 0; i < chunkCount && written; ++i)
+        written = !pChunkSizes[i] || fwrite(pChunks[i], pChunkSizes[i], 1, file) == 1;
+    written = fflush(file) == 0 && fsync(fileno(file)) == 0 && written;
+    written = fclose(file) == 0 && written;
+    VkResult result = VK_SUCCESS;
+    if(!written || rename(temporaryName, filename) != 0) {
+        remove(temporaryName);
+        result = VK_ERROR_INITIALIZATION_FAILED;
+    }
+    free(temporaryName);
+    return result;
+}
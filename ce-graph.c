@@ -0,0 +1,235 @@
+#include "ce-graph.h"
+#include "ce-def.h"
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan_core.h>
+#include <stdlib.h>
+#include "ce-command.h"
+#include "ce-command-internal.h"
+#include "ce-pipeline-internal.h"
+#include "ce-buffer-internal.h"
+#include "ce-error-internal.h"
+
+struct CeGraphNode {
+    CePipeline pipeline;
+    //nodes this one was explicitly made to wait for with ceAddGraphDependency
+    uint32_t* explicitDependencies;
+    uint32_t explicitDependencyCount;
+    //nodes on the same level do not depend on each other and are recorded without barriers in between
+    uint32_t level;
+};
+
+struct CeGraph_t {
+    CeInstance instance;
+    struct CeGraphNode* nodes;
+    uint32_t nodeCount;
+    uint32_t nodeCapacity;
+};
+
+CeResult
+ceCreateGraph(CeInstance instance, CeGraph* graph) {
+    if(!instance || !graph)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot create graph: some parameters were NULL");
+    *graph = calloc(1, sizeof(struct CeGraph_t));
+    (*graph)->instance = instance;
+    return CE_SUCCESS;
+}
+
+CeResult
+ceAddGraphNode(CeGraph graph, CePipeline pipeline, uint32_t* pNodeIndex) {
+    if(!graph || !pipeline)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot add graph node: some parameters were NULL");
+    if(graph->nodeCount == graph->nodeCapacity) {
+        graph->nodeCapacity = graph->nodeCapacity ? graph->nodeCapacity * 2 : 8;
+        graph->nodes = realloc(graph->nodes, graph->nodeCapacity * sizeof(struct CeGraphNode));
+    }
+    graph->nodes[graph->nodeCount] = (struct CeGraphNode){
+        .pipeline = pipeline,
+    };
+    if(pNodeIndex)
+        *pNodeIndex = graph->nodeCount;
+    ++graph->nodeCount;
+    return CE_SUCCESS;
+}
+
+CeResult
+ceAddGraphDependency(CeGraph graph, uint32_t uFirstNode, uint32_t uSecondNode) {
+    if(!graph)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot add graph dependency: none passed");
+    if(uSecondNode >= graph->nodeCount || uFirstNode >= uSecondNode)
+        return ceResult(CE_ERROR_INVALID_ARG, "cannot add graph dependency: the first node must have been added before the second");
+    struct CeGraphNode* node = &graph->nodes[uSecondNode];
+    node->explicitDependencies = realloc(node->explicitDependencies, (node->explicitDependencyCount + 1) * sizeof(uint32_t));
+    node->explicitDependencies[node->explicitDependencyCount++] = uFirstNode;
+    return CE_SUCCESS;
+}
+
+static CeBool32 __accessWrites(CeBindingAccess access) {
+    return access != CE_BINDING_ACCESS_READ_ONLY;
+}
+
+static CeBool32 __accessReads(CeBindingAccess access) {
+    return access != CE_BINDING_ACCESS_WRITE_ONLY;
+}
+
+//the buffers a node uses are its bindings, then the buffer its indirect dispatch reads its counts from if it has one
+static uint32_t __getNodeBufferCount(const struct CeGraphNode* node) {
+    return ceGetPipelineBindingCount(node->pipeline) + (ceGetPipelineIndirectBuffer(node->pipeline) ? 1 : 0);
+}
+
+static CeBuffer __getNodeBuffer(const struct CeGraphNode* node, uint32_t index) {
+    if(index < ceGetPipelineBindingCount(node->pipeline))
+        return ceGetPipelineBindingBuffer(node->pipeline, index);
+    return ceGetPipelineIndirectBuffer(node->pipeline);
+}
+
+static CeBindingAccess __getNodeBufferAccess(const struct CeGraphNode* node, uint32_t index) {
+    if(index < ceGetPipelineBindingCount(node->pipeline))
+        return ceGetPipelineBindingAccess(node->pipeline, index);
+    return CE_BINDING_ACCESS_READ_ONLY;
+}
+
+static VkAccessFlags __getNodeBufferReadAccess(const struct CeGraphNode* node, uint32_t index) {
+    if(index < ceGetPipelineBindingCount(node->pipeline))
+        return VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT;
+    return VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+}
+
+static CeBool32 __nodeExplicitlyDependsOn(const struct CeGraphNode* node, uint32_t other) {
+    for(uint32_t i = 0; i < node->explicitDependencyCount; ++i) {
+        if(node->explicitDependencies[i] == other)
+            return CE_TRUE;
+    }
+    return CE_FALSE;
+}
+
+//a later node depends on an earlier one when both use a buffer and at least one of them writes it
+static CeBool32 __nodesConflict(const struct CeGraphNode* earlier, const struct CeGraphNode* later) {
+    const uint32_t earlierCount = __getNodeBufferCount(earlier);
+    const uint32_t laterCount = __getNodeBufferCount(later);
+    for(uint32_t i = 0; i < earlierCount; ++i) {
+        CeBuffer buffer = __getNodeBuffer(earlier, i);
+        CeBool32 earlierWrites = __accessWrites(__getNodeBufferAccess(earlier, i));
+        for(uint32_t j = 0; j < laterCount; ++j) {
+            if(__getNodeBuffer(later, j) != buffer)
+                continue;
+            if(earlierWrites || __accessWrites(__getNodeBufferAccess(later, j)))
+                return CE_TRUE;
+        }
+    }
+    return CE_FALSE;
+}
+
+static uint32_t __computeGraphLevels(CeGraph graph) {
+    uint32_t levelCount = 0;
+    for(uint32_t j = 0; j < graph->nodeCount; ++j) {
+        graph->nodes[j].level = 0;
+        for(uint32_t i = 0; i < j; ++i) {
+            if(graph->nodes[i].level + 1 <= graph->nodes[j].level)
+                continue;
+            if(__nodeExplicitlyDependsOn(&graph->nodes[j], i) || __nodesConflict(&graph->nodes[i], &graph->nodes[j]))
+                graph->nodes[j].level = graph->nodes[i].level + 1;
+        }
+        if(graph->nodes[j].level + 1 > levelCount)
+            levelCount = graph->nodes[j].level + 1;
+    }
+    return levelCount;
+}
+
+static void __addBufferBarrier(VkBufferMemoryBarrier** barriers, uint32_t* barrierCount, uint32_t* barrierCapacity,
+    CeBuffer buffer, VkAccessFlags srcAccess, VkAccessFlags dstAccess) {
+    VkBuffer vulkanBuffer = ceGetBufferVulkanBuffer(buffer);
+    for(uint32_t i = 0; i < *barrierCount; ++i) {
+        if((*barriers)[i].buffer == vulkanBuffer) {
+            (*barriers)[i].srcAccessMask |= srcAccess;
+            (*barriers)[i].dstAccessMask |= dstAccess;
+            return;
+        }
+    }
+    if(*barrierCount == *barrierCapacity) {
+        *barrierCapacity = *barrierCapacity ? *barrierCapacity * 2 : 8;
+        *barriers = realloc(*barriers, *barrierCapacity * sizeof(VkBufferMemoryBarrier));
+    }
+    (*barriers)[(*barrierCount)++] = (VkBufferMemoryBarrier){
+        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+        .srcAccessMask = srcAccess,
+        .dstAccessMask = dstAccess,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .buffer = vulkanBuffer,
+        .offset = 0,
+        .size = VK_WHOLE_SIZE,
+    };
+}
+
+//records the barriers that make every node of a level wait for what it depends on in the previous levels
+static void __recordLevelBarriers(CeGraph graph, uint32_t level, CeCommand command) {
+    VkBufferMemoryBarrier* barriers = NULL;
+    uint32_t barrierCount = 0, barrierCapacity = 0;
+    CeBool32 needsMemoryBarrier = CE_FALSE;
+
+    for(uint32_t j = 0; j < graph->nodeCount; ++j) {
+        const struct CeGraphNode* later = &graph->nodes[j];
+        if(later->level != level)
+            continue;
+        for(uint32_t i = 0; i < j; ++i) {
+            const struct CeGraphNode* earlier = &graph->nodes[i];
+            if(__nodeExplicitlyDependsOn(later, i))
+                needsMemoryBarrier = CE_TRUE;
+            const uint32_t earlierCount = __getNodeBufferCount(earlier);
+            const uint32_t laterCount = __getNodeBufferCount(later);
+            for(uint32_t a = 0; a < earlierCount; ++a) {
+                CeBuffer buffer = __getNodeBuffer(earlier, a);
+                CeBindingAccess earlierAccess = __getNodeBufferAccess(earlier, a);
+                for(uint32_t b = 0; b < laterCount; ++b) {
+                    if(__getNodeBuffer(later, b) != buffer)
+                        continue;
+                    CeBindingAccess laterAccess = __getNodeBufferAccess(later, b);
+                    if(!__accessWrites(earlierAccess) && !__accessWrites(laterAccess))
+                        continue;
+                    //write-after-read hazards only need the execution dependency, so they carry no source access
+                    __addBufferBarrier(&barriers, &barrierCount, &barrierCapacity, buffer,
+                        __accessWrites(earlierAccess) ? VK_ACCESS_SHADER_WRITE_BIT : 0,
+                        (__accessReads(laterAccess) ? __getNodeBufferReadAccess(later, b) : 0) |
+                        (__accessWrites(laterAccess) ? VK_ACCESS_SHADER_WRITE_BIT : 0));
+                }
+            }
+        }
+    }
+
+    //a global memory barrier already covers every buffer
+    if(needsMemoryBarrier || barrierCount)
+        ceRecordCommandBarrier(command, needsMemoryBarrier, barriers, needsMemoryBarrier ? 0 : barrierCount);
+    free(barriers);
+}
+
+CeResult
+ceRecordGraphToCommand(CeGraph graph, CeCommand command) {
+    if(!graph || !command)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot record graph: some parameters were NULL");
+    const uint32_t levelCount = __computeGraphLevels(graph);
+    for(uint32_t level = 0; level < levelCount; ++level) {
+        if(level)
+            __recordLevelBarriers(graph, level, command);
+        for(uint32_t i = 0; i < graph->nodeCount; ++i) {
+            if(graph->nodes[i].level != level)
+                continue;
+            CeCommandRecordingArgs recordingArgs = {
+                .bRecordCommand = CE_FALSE,
+                .pSuppliedPipeline = graph->nodes[i].pipeline,
+            };
+            CeResult result = ceRecordToCommand(&recordingArgs, command);
+            if(result != CE_SUCCESS)
+                return result;
+        }
+    }
+    return CE_SUCCESS;
+}
+
+void
+ceDestroyGraph(CeGraph graph) {
+    for(uint32_t i = 0; i < graph->nodeCount; ++i) {
+        free(graph->nodes[i].explicitDependencies);
+    }
+    free(graph->nodes);
+    free(graph);
+}
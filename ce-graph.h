@@ -0,0 +1,50 @@
+#pragma once
+#include "ce-def.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+* Create an empty CE graph.
+* A graph is a list of pipelines whose data dependencies are tracked through the buffers their bindings share,
+* and which records itself to a command with only the barriers those dependencies require.
+* \param instance the instance the graph's pipelines are created from
+* \param graph the graph handle the function writes to
+*/
+CeResult
+ceCreateGraph(CeInstance instance, CeGraph* graph);
+
+/**
+* Add a pipeline to a graph.
+* Nodes run in the order they are added whenever they depend on each other, and may overlap otherwise.
+* \param graph the graph the pipeline is added to
+* \param pipeline the pipeline the node runs
+* \param pNodeIndex if not NULL, the index of the new node is written to it
+*/
+CeResult
+ceAddGraphNode(CeGraph graph, CePipeline pipeline, uint32_t* pNodeIndex);
+
+/**
+* Make a node wait for every memory access of an earlier one, 
+* for dependencies that do not go through shared buffers.
+* \param graph the graph the nodes belong to
+* \param uFirstNode the node that runs first
+* \param uSecondNode the node that waits, it **must** have been added after uFirstNode
+*/
+CeResult
+ceAddGraphDependency(CeGraph graph, uint32_t uFirstNode, uint32_t uSecondNode);
+
+/**
+* Record every node of a graph, and the barriers between them, to a command which is being recorded.
+* \param graph the graph to record
+* \param command the command to record to
+*/
+CeResult
+ceRecordGraphToCommand(CeGraph graph, CeCommand command);
+
+void
+ceDestroyGraph(CeGraph graph);
+
+#ifdef __cplusplus
+}
+#endif
@@ -2,6 +2,16 @@
 #include "ce-instance.h"
 #include <vulkan/vulkan.h>
 #include <vulkan/vulkan_core.h>
+#include "ce-staging-internal.h"
+#include "ce-memory-internal.h"
+#include "ce-shader-internal.h"
+#include "ce-completion-internal.h"
+#include "ce-queue-internal.h"
+#include "ce-command-pool-internal.h"
+#include "ce-autotune-db-internal.h"
+#include "ce-cpu-internal.h"
+
+#define CE_INVALID_MEMORY_TYPE (~((uint32_t)0))
 
 VkInstance
 ceGetInstanceVulkanInstance(CeInstance);
@@ -12,8 +22,76 @@ ceGetInstanceVulkanDevice(CeInstance);
 uint32_t
 ceGetInstanceVulkanQueueFamilyIndex(CeInstance);
 
-VkCommandPool
-ceGetInstanceVulkanCommandPool(CeInstance);
+CeCommandPoolSet
+ceGetInstanceCommandPoolSet(CeInstance);
 
 VkPhysicalDevice
-ceGetInstanceVulkanPhysicalDevice(CeInstance);
\ No newline at end of file
+ceGetInstanceVulkanPhysicalDevice(CeInstance);
+
+//returns the first memory type allowed by memoryTypeBits which has all of requiredFlags, or CE_INVALID_MEMORY_TYPE
+uint32_t
+ceGetInstanceMemoryTypeIndex(CeInstance, uint32_t memoryTypeBits, VkMemoryPropertyFlags requiredFlags);
+
+VkMemoryPropertyFlags
+ceGetInstanceMemoryTypeFlags(CeInstance, uint32_t memoryTypeIndex);
+
+CeStagingRing
+ceGetInstanceStagingRing(CeInstance);
+
+CeMemoryArena
+ceGetInstanceMemoryArena(CeInstance);
+
+CeShaderCache
+ceGetInstanceShaderCache(CeInstance);
+
+CeCompletionQueue
+ceGetInstanceCompletionQueue(CeInstance);
+
+CeQueueScheduler
+ceGetInstanceQueueScheduler(CeInstance);
+
+//the family transfers run on, the compute family itself when the device has no transfer-only family
+uint32_t
+ceGetInstanceTransferQueueFamilyIndex(CeInstance);
+
+CeQueueScheduler
+ceGetInstanceTransferQueueScheduler(CeInstance);
+
+CeCommandPoolSet
+ceGetInstanceTransferCommandPoolSet(CeInstance);
+
+//whether the device was created with timeline semaphores (Vulkan 1.2)
+CeBool32
+ceGetInstanceTimelineSemaphoresEnabled(CeInstance);
+
+VkPipelineCache
+ceGetInstanceVulkanPipelineCache(CeInstance);
+
+const VkPhysicalDeviceProperties*
+ceGetInstanceVulkanDeviceProperties(CeInstance);
+
+const VkPhysicalDeviceFeatures*
+ceGetInstanceVulkanEnabledFeatures(CeInstance);
+
+//number of meaningful bits in the timestamps written on the instance's queues, 0 if they do not support timestamps
+uint32_t
+ceGetInstanceTimestampValidBits(CeInstance);
+
+//VK_UUID_SIZE bytes identifying the physical device
+const uint8_t*
+ceGetInstanceDeviceUUID(CeInstance);
+
+CeAutotuneDatabase
+ceGetInstanceAutotuneDatabase(CeInstance);
+
+//whether compute shaders can use subgroup arithmetic, SPIR-V using it needs Vulkan 1.1
+CeBool32
+ceGetInstanceSubgroupArithmeticSupported(CeInstance);
+
+//NULL when host memory cannot be imported, otherwise writes the alignment imported pointers and sizes need
+PFN_vkGetMemoryHostPointerPropertiesEXT
+ceGetInstanceHostPointerImport(CeInstance, VkDeviceSize* pAlignment);
+
+//NULL for Vulkan instances, which is how the other modules tell the backends apart
+CeCpuBackend
+ceGetInstanceCpuBackend(CeInstance);
@@ -6,33 +6,63 @@
 #include "ce-instance-internal.h"
 #include <string.h>
 #include "ce-error-internal.h"
+#include "ce-staging-internal.h"
+#include "ce-memory-internal.h"
+#include "ce-pipeline-cache-internal.h"
+#include "ce-trace-internal.h"
+#include "ce-completion-internal.h"
+#include "ce-queue-internal.h"
+#include "ce-command-pool-internal.h"
+#include "ce-autotune-db-internal.h"
 
 struct CeInstance_t {
     VkPhysicalDevice vulkanPhysicalDevice;
     VkInstance vulkanInstance;
     VkDevice vulkanDevice;
-    VkCommandPool vulkanCommandPool;
+    CeCommandPoolSet commandPoolSet;
     VkDescriptorPool vulkanDescriptorPool;
     uint32_t vulkanQueueFamily;
     uint32_t vulkanQueueCount;
-    struct CeInstanceQueueList* queueListHead;
+    uint32_t vulkanQueueTimestampValidBits;
+    //equal to vulkanQueueFamily with a transferQueueCount of 0 when the device has no transfer-only family
+    uint32_t transferQueueFamily;
+    uint32_t transferQueueCount;
+    CeQueueScheduler transferQueueScheduler;
+    CeCommandPoolSet transferCommandPoolSet;
+    VkPhysicalDeviceFeatures vulkanEnabledFeatures;
+    uint32_t vulkanApiVersion;
+    //commands signal a timeline semaphore instead of a fence when this is set
+    CeBool32 timelineSemaphoresEnabled;
+    //NULL unless VK_EXT_external_memory_host is enabled, buffers then import host memory instead of copying it
+    PFN_vkGetMemoryHostPointerPropertiesEXT getMemoryHostPointerProperties;
+    VkDeviceSize minImportedHostPointerAlignment;
+    CeQueueScheduler queueScheduler;
     VkDebugUtilsMessengerEXT debugMessenger;
+    VkPhysicalDeviceProperties vulkanDeviceProperties;
+    VkPhysicalDeviceMemoryProperties vulkanMemoryProperties;
+    //the pipeline cache UUID stands in for it on devices older than 1.1
+    uint8_t deviceUUID[VK_UUID_SIZE];
+    //compute shaders can use subgroup arithmetic (Vulkan 1.1)
+    CeBool32 subgroupArithmeticSupported;
+    //shared by every pipeline of the instance, and saved to pipelineCacheFilename if there is one
+    VkPipelineCache vulkanPipelineCache;
+    char* pipelineCacheFilename;
+    CeStagingRing stagingRing;
+    CeMemoryArena memoryArena;
+    CeShaderCache shaderCache;
+    CeCompletionQueue completionQueue;
+    //owned by the instance returned by ceCreateInstance, its devices use the same one
+    CeAutotuneDatabase autotuneDatabase;
+    //the instance a device was opened by, NULL for the instance returned by ceCreateInstance which owns vulkanInstance
+    CeInstance parent;
+    //every device the instance opened, the first one being the instance itself. only set on the owning instance
+    CeInstance* devices;
+    uint32_t deviceCount;
+    CeBackend backend;
+    //only set on CPU instances, which have no Vulkan objects at all
+    CeCpuBackend cpuBackend;
 };
 
-struct CeInstanceQueueList {
-    struct CeInstanceQueueList* next;
-    CeBool32 is_free;
-};
-
-static VkResult __createVkCommandPool(CeInstance instance) {
-    VkCommandPoolCreateInfo commandInfo = {
-        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
-        .queueFamilyIndex = instance->vulkanQueueFamily,
-        .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
-    };
-    return vkCreateCommandPool(instance->vulkanDevice, &commandInfo, NULL, &instance->vulkanCommandPool);
-}
-
 #ifdef DEBUG
 CeBool32 layersAreSupported(const char** layers, uint32_t layerCount) {
     uint32_t availableLayerCount;
@@ -70,6 +100,12 @@ static VkResult __createVkInstance(CeInstance instance, const CeInstanceCreation
         .engineVersion = VK_MAKE_API_VERSION(0, 0, 1, 0),
         .pEngineName = "Compute Engine (VK) 0.1.0",
     };
+    //1.2 brings timeline semaphores, older loaders and devices simply go without them
+    uint32_t loaderVersion = VK_API_VERSION_1_0;
+    if(vkEnumerateInstanceVersion(&loaderVersion) != VK_SUCCESS)
+        loaderVersion = VK_API_VERSION_1_0;
+    instance->vulkanApiVersion = loaderVersion < VK_API_VERSION_1_2 ? loaderVersion : VK_API_VERSION_1_2;
+    applicationInfo.apiVersion = instance->vulkanApiVersion;
     #ifdef DEBUG 
     static const char* validationLayers[] = {
         "VK_LAYER_KHRONOS_validation"
@@ -88,22 +124,67 @@ static VkResult __createVkInstance(CeInstance instance, const CeInstanceCreation
     return result;
 }
 
-static void __chooseVkDevice(CeInstance instance) {
+static VkResult __chooseVkDevices(VkInstance vulkanInstance, const CeInstanceCreationArgs* args, uint32_t deviceCount, VkPhysicalDevice* targets) {
     uint32_t physicalDeviceCount;
-    vkEnumeratePhysicalDevices(instance->vulkanInstance, &physicalDeviceCount, NULL);
+    vkEnumeratePhysicalDevices(vulkanInstance, &physicalDeviceCount, NULL);
+    if(!physicalDeviceCount)
+        return VK_ERROR_INITIALIZATION_FAILED;
     VkPhysicalDevice *physicalDevices = malloc(sizeof(VkPhysicalDevice) * physicalDeviceCount);
-    vkEnumeratePhysicalDevices(instance->vulkanInstance, &physicalDeviceCount, physicalDevices);
-    instance->vulkanPhysicalDevice = physicalDevices[0];
-    for(uint32_t i = 0; i < physicalDeviceCount; ++i) {
+    vkEnumeratePhysicalDevices(vulkanInstance, &physicalDeviceCount, physicalDevices);
+    VkResult result = VK_SUCCESS;
+    if(args->pPhysicalDeviceIndices) {
+        for(uint32_t i = 0; i < deviceCount && result == VK_SUCCESS; ++i) {
+            if(args->pPhysicalDeviceIndices[i] < physicalDeviceCount)
+                targets[i] = physicalDevices[args->pPhysicalDeviceIndices[i]];
+            else
+                result = VK_ERROR_INITIALIZATION_FAILED;
+        }
+        free(physicalDevices);
+        return result;
+    }
+    if(deviceCount > physicalDeviceCount) {
+        free(physicalDevices);
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+    //discrete GPUs first, then the others in enumeration order
+    uint32_t chosenCount = 0;
+    for(uint32_t i = 0; i < physicalDeviceCount && chosenCount < deviceCount; ++i) {
         VkPhysicalDeviceProperties devProp;
         vkGetPhysicalDeviceProperties(physicalDevices[i], &devProp);
-        if(devProp.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU) {
-            instance->vulkanPhysicalDevice = physicalDevices[i];
-            free(physicalDevices);
-            return;
-        }
-    }  
+        if(devProp.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
+            targets[chosenCount++] = physicalDevices[i];
+    }
+    for(uint32_t i = 0; i < physicalDeviceCount && chosenCount < deviceCount; ++i) {
+        VkPhysicalDeviceProperties devProp;
+        vkGetPhysicalDeviceProperties(physicalDevices[i], &devProp);
+        if(devProp.deviceType != VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
+            targets[chosenCount++] = physicalDevices[i];
+    }
     free(physicalDevices);
+    return result;
+}
+
+static void __getVkDeviceProperties(CeInstance instance) {
+    vkGetPhysicalDeviceProperties(instance->vulkanPhysicalDevice, &instance->vulkanDeviceProperties);
+    vkGetPhysicalDeviceMemoryProperties(instance->vulkanPhysicalDevice, &instance->vulkanMemoryProperties);
+    memcpy(instance->deviceUUID, instance->vulkanDeviceProperties.pipelineCacheUUID, VK_UUID_SIZE);
+    if(instance->vulkanApiVersion >= VK_API_VERSION_1_1 && instance->vulkanDeviceProperties.apiVersion >= VK_API_VERSION_1_1) {
+        VkPhysicalDeviceSubgroupProperties subgroupProperties = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_PROPERTIES,
+        };
+        VkPhysicalDeviceIDProperties idProperties = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES,
+            .pNext = &subgroupProperties,
+        };
+        VkPhysicalDeviceProperties2 properties2 = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+            .pNext = &idProperties,
+        };
+        vkGetPhysicalDeviceProperties2(instance->vulkanPhysicalDevice, &properties2);
+        memcpy(instance->deviceUUID, idProperties.deviceUUID, VK_UUID_SIZE);
+        instance->subgroupArithmeticSupported = (subgroupProperties.supportedStages & VK_SHADER_STAGE_COMPUTE_BIT) &&
+            (subgroupProperties.supportedOperations & VK_SUBGROUP_FEATURE_ARITHMETIC_BIT) ? CE_TRUE : CE_FALSE;
+    }
 }
 
 static void __getOptimalVkDeviceQueueFamilyIndex(CeInstance instance) {
@@ -112,12 +193,29 @@ static void __getOptimalVkDeviceQueueFamilyIndex(CeInstance instance) {
     VkQueueFamilyProperties *queueFamilies = malloc(sizeof(VkQueueFamilyProperties) * queueFamilyCount);
     vkGetPhysicalDeviceQueueFamilyProperties(instance->vulkanPhysicalDevice, &queueFamilyCount, queueFamilies);
 
+    //an async compute family (compute without graphics) is preferred, its queues do not compete with rendering
+    uint32_t computeFamily = queueFamilyCount;
+    for(uint32_t i = 0; i < queueFamilyCount; ++i) {
+        if(!(queueFamilies[i].queueFlags & VK_QUEUE_COMPUTE_BIT))
+            continue;
+        if(computeFamily == queueFamilyCount || !(queueFamilies[i].queueFlags & VK_QUEUE_GRAPHICS_BIT)) {
+            computeFamily = i;
+            if(!(queueFamilies[i].queueFlags & VK_QUEUE_GRAPHICS_BIT))
+                break;
+        }
+    }
+    instance->vulkanQueueCount = queueFamilies[computeFamily].queueCount;
+    instance->vulkanQueueFamily = computeFamily;
+    instance->vulkanQueueTimestampValidBits = queueFamilies[computeFamily].timestampValidBits;
 
-
+    //a transfer-only family is usually backed by DMA engines which copy while the compute queues run
+    instance->transferQueueFamily = computeFamily;
+    instance->transferQueueCount = 0;
     for(uint32_t i = 0; i < queueFamilyCount; ++i) {
-        if(queueFamilies[i].queueFlags & VK_QUEUE_COMPUTE_BIT) {
-            instance->vulkanQueueCount = queueFamilies[i].queueCount;
-            instance->vulkanQueueFamily = i;
+        const VkQueueFlags flags = queueFamilies[i].queueFlags;
+        if((flags & VK_QUEUE_TRANSFER_BIT) && !(flags & (VK_QUEUE_COMPUTE_BIT | VK_QUEUE_GRAPHICS_BIT))) {
+            instance->transferQueueFamily = i;
+            instance->transferQueueCount = queueFamilies[i].queueCount;
             break;
         }
     }
@@ -125,76 +223,307 @@ static void __getOptimalVkDeviceQueueFamilyIndex(CeInstance instance) {
     free(queueFamilies);
 }
 
+static CeBool32 __deviceSupportsExtension(CeInstance instance, const char* name) {
+    uint32_t extensionCount = 0;
+    vkEnumerateDeviceExtensionProperties(instance->vulkanPhysicalDevice, NULL, &extensionCount, NULL);
+    VkExtensionProperties* extensions = malloc((extensionCount ? extensionCount : 1) * sizeof(VkExtensionProperties));
+    vkEnumerateDeviceExtensionProperties(instance->vulkanPhysicalDevice, NULL, &extensionCount, extensions);
+    CeBool32 found = CE_FALSE;
+    for(uint32_t i = 0; i < extensionCount && !found; ++i)
+        found = strcmp(extensions[i].extensionName, name) == 0;
+    free(extensions);
+    return found;
+}
+
 static VkResult __createVkDeviceSingle(CeInstance instance) {
-    __chooseVkDevice(instance);
+    __getVkDeviceProperties(instance);
 
     __getOptimalVkDeviceQueueFamilyIndex(instance);
-    float* queuePriorities = calloc(instance->vulkanQueueCount, sizeof(float));
+    const uint32_t priorityCount = instance->vulkanQueueCount > instance->transferQueueCount ?
+        instance->vulkanQueueCount : instance->transferQueueCount;
+    float* queuePriorities = calloc(priorityCount, sizeof(float));
 
     for(int i = 0; i < instance->vulkanQueueCount; ++i) {
         queuePriorities[i] = 1.f - (i / (float)instance->vulkanQueueCount);
     }
 
-    VkDeviceQueueCreateInfo queueInfo = {
-        .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
-        .queueCount = instance->vulkanQueueCount,
-        .queueFamilyIndex = instance->vulkanQueueFamily,
-        .pQueuePriorities = queuePriorities
+    VkDeviceQueueCreateInfo queueInfos[2] = {
+        {
+            .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+            .queueCount = instance->vulkanQueueCount,
+            .queueFamilyIndex = instance->vulkanQueueFamily,
+            .pQueuePriorities = queuePriorities
+        },
+        {
+            .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+            .queueCount = instance->transferQueueCount,
+            .queueFamilyIndex = instance->transferQueueFamily,
+            .pQueuePriorities = queuePriorities
+        },
     };
 
+    //only the optional features CE can make use of are turned on
+    VkPhysicalDeviceFeatures supportedFeatures;
+    vkGetPhysicalDeviceFeatures(instance->vulkanPhysicalDevice, &supportedFeatures);
+    instance->vulkanEnabledFeatures.pipelineStatisticsQuery = supportedFeatures.pipelineStatisticsQuery;
+    VkPhysicalDeviceVulkan12Features enabledFeatures12 = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+    };
+    if(instance->vulkanApiVersion >= VK_API_VERSION_1_2 && instance->vulkanDeviceProperties.apiVersion >= VK_API_VERSION_1_2) {
+        VkPhysicalDeviceVulkan12Features supportedFeatures12 = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+        };
+        VkPhysicalDeviceFeatures2 supportedFeatures2 = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+            .pNext = &supportedFeatures12,
+        };
+        vkGetPhysicalDeviceFeatures2(instance->vulkanPhysicalDevice, &supportedFeatures2);
+        enabledFeatures12.timelineSemaphore = supportedFeatures12.timelineSemaphore;
+        instance->timelineSemaphoresEnabled = supportedFeatures12.timelineSemaphore;
+    }
+
+    //importing host memory builds on external memory, which is core since 1.1
+    const char* enabledExtensions[1];
+    uint32_t enabledExtensionCount = 0;
+    const CeBool32 importsHostMemory = instance->vulkanApiVersion >= VK_API_VERSION_1_1 &&
+        instance->vulkanDeviceProperties.apiVersion >= VK_API_VERSION_1_1 &&
+        __deviceSupportsExtension(instance, VK_EXT_EXTERNAL_MEMORY_HOST_EXTENSION_NAME);
+    if(importsHostMemory) {
+        enabledExtensions[enabledExtensionCount++] = VK_EXT_EXTERNAL_MEMORY_HOST_EXTENSION_NAME;
+        VkPhysicalDeviceExternalMemoryHostPropertiesEXT hostProperties = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTERNAL_MEMORY_HOST_PROPERTIES_EXT,
+        };
+        VkPhysicalDeviceProperties2 properties2 = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+            .pNext = &hostProperties,
+        };
+        vkGetPhysicalDeviceProperties2(instance->vulkanPhysicalDevice, &properties2);
+        instance->minImportedHostPointerAlignment = hostProperties.minImportedHostPointerAlignment;
+    }
+
     VkDeviceCreateInfo deviceCreateInfo = {
         .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
-        .pQueueCreateInfos = &queueInfo,
-        .queueCreateInfoCount = 1,
-        
+        .pNext = instance->timelineSemaphoresEnabled ? &enabledFeatures12 : NULL,
+        .pQueueCreateInfos = queueInfos,
+        .queueCreateInfoCount = instance->transferQueueCount ? 2 : 1,
+        .pEnabledFeatures = &instance->vulkanEnabledFeatures,
+        .ppEnabledExtensionNames = enabledExtensions,
+        .enabledExtensionCount = enabledExtensionCount,
     };
 
     VkResult result = vkCreateDevice(instance->vulkanPhysicalDevice, &deviceCreateInfo, NULL, &instance->vulkanDevice);
     free(queuePriorities);
+    if(result == VK_SUCCESS && importsHostMemory)
+        instance->getMemoryHostPointerProperties = (PFN_vkGetMemoryHostPointerPropertiesEXT)
+            vkGetDeviceProcAddr(instance->vulkanDevice, "vkGetMemoryHostPointerPropertiesEXT");
     return result;
 }
 
+//creates everything an instance needs on its device, the VkInstance and the physical device are already set
+static CeResult __openDevice(CeInstance instance, const CeInstanceCreationArgs* args) {
+    uint64_t traceBegin = ceTraceBegin();
+    if(__createVkDeviceSingle(instance) != VK_SUCCESS)
+        return ceResult(CE_ERROR_INTERNAL, "failed to create a Vk logical device");
+    ceTraceEnd("vkCreateDevice", traceBegin);
+
+    if(ceCreateQueueScheduler(instance, instance->vulkanQueueFamily, instance->vulkanQueueCount, &instance->queueScheduler) != VK_SUCCESS)
+        return ceResult(CE_ERROR_INTERNAL, "failed to create the queue scheduler");
+    if(ceCreateCommandPoolSet(instance, instance->vulkanQueueFamily, &instance->commandPoolSet) != VK_SUCCESS)
+        return ceResult(CE_ERROR_INTERNAL, "failed to create the command pools");
+    if(instance->transferQueueCount) {
+        if(ceCreateQueueScheduler(instance, instance->transferQueueFamily, instance->transferQueueCount,
+            &instance->transferQueueScheduler) != VK_SUCCESS)
+            return ceResult(CE_ERROR_INTERNAL, "failed to create the transfer queue scheduler");
+        if(ceCreateCommandPoolSet(instance, instance->transferQueueFamily, &instance->transferCommandPoolSet) != VK_SUCCESS)
+            return ceResult(CE_ERROR_INTERNAL, "failed to create the transfer command pools");
+    }
+    if(ceCreateMemoryArena(instance, args->uMemoryBlockSize, &instance->memoryArena) != VK_SUCCESS)
+        return ceResult(CE_ERROR_INTERNAL, "failed to create the memory arena");
+    if(ceCreateStagingRing(instance, args->uStagingBufferSize, &instance->stagingRing) != VK_SUCCESS)
+        return ceResult(CE_ERROR_INTERNAL, "failed to create the staging buffer");
+    if(ceCreateShaderCache(instance, &instance->shaderCache) != VK_SUCCESS)
+        return ceResult(CE_ERROR_INTERNAL, "failed to create the shader cache");
+    if(ceCreateCompletionQueue(instance, &instance->completionQueue) != VK_SUCCESS)
+        return ceResult(CE_ERROR_INTERNAL, "failed to create the completion queue");
+    //only the owning instance loads and saves the cache file, devices writing it in turn would overwrite each other
+    if(args->pPipelineCacheFilename && !instance->parent)
+        instance->pipelineCacheFilename = strdup(args->pPipelineCacheFilename);
+    traceBegin = ceTraceBegin();
+    if(ceLoadPipelineCache(instance, instance->pipelineCacheFilename, &instance->vulkanPipelineCache) != VK_SUCCESS)
+        return ceResult(CE_ERROR_INTERNAL, "failed to create a Vk pipeline cache");
+    ceTraceEnd("pipeline cache load", traceBegin);
+    return CE_SUCCESS;
+}
+
+static CeResult __openCpuDevice(CeInstance instance, const CeInstanceCreationArgs* args) {
+    instance->backend = CE_BACKEND_CPU;
+    instance->devices = calloc(1, sizeof(CeInstance));
+    instance->devices[0] = instance;
+    instance->deviceCount = 1;
+    uint64_t traceBegin = ceTraceBegin();
+    if(ceCreateCpuBackend(args->uCpuThreadCount, &instance->cpuBackend) != VK_SUCCESS)
+        return ceResult(CE_ERROR_INTERNAL, "failed to start the CPU backend's worker threads");
+    ceTraceEnd("CPU backend start", traceBegin);
+    return CE_SUCCESS;
+}
+
+//software implementations such as lavapipe are slower than the CPU backend's native kernels
+static CeBool32 __areSoftwareDevices(const VkPhysicalDevice* physicalDevices, uint32_t deviceCount) {
+    for(uint32_t i = 0; i < deviceCount; ++i) {
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(physicalDevices[i], &properties);
+        if(properties.deviceType != VK_PHYSICAL_DEVICE_TYPE_CPU)
+            return CE_FALSE;
+    }
+    return CE_TRUE;
+}
+
 CeResult ceCreateInstance(const CeInstanceCreationArgs * args, CeInstance *instance) {
     if(!args || !instance) 
         return ceResult(CE_ERROR_NULL_PASSED, "cannot create instance: some parameters were NULL");
 
-    *instance = malloc(sizeof(struct CeInstance_t));
-    if(__createVkInstance(*instance, args) != VK_SUCCESS)
+    *instance = calloc(1, sizeof(struct CeInstance_t));
+    if(ceCreateAutotuneDatabase(args->pAutotuneDatabaseFilename, &(*instance)->autotuneDatabase) != VK_SUCCESS)
+        return ceResult(CE_ERROR_INTERNAL, "failed to create the autotune database");
+    if(args->eBackend == CE_BACKEND_CPU) {
+        if(args->uDeviceCount > 1 || args->pPhysicalDeviceIndices)
+            return ceResult(CE_ERROR_INVALID_ARG, "cannot create instance: the CPU backend opens a single device");
+        return __openCpuDevice(*instance, args);
+    }
+    uint64_t traceBegin = ceTraceBegin();
+    if(__createVkInstance(*instance, args) != VK_SUCCESS) {
+        if(args->eBackend == CE_BACKEND_AUTO && args->uDeviceCount <= 1)
+            return __openCpuDevice(*instance, args);
         return ceResult(CE_ERROR_INTERNAL, "failed to create a Vk instance");
-    if(__createVkDeviceSingle(*instance) != VK_SUCCESS)
-        return ceResult(CE_ERROR_INTERNAL, "failed to create a Vk logical device");
-
-    struct CeInstanceQueueList* current = (*instance)->queueListHead = malloc(sizeof(struct CeInstanceQueueList));
-    for(uint32_t i = 0; i < (*instance)->vulkanQueueCount; ++i) {
-        current->next = i < (*instance)->vulkanQueueCount - 1 ? malloc(sizeof(struct CeInstanceQueueList)) : NULL;
-        current->is_free = 1;
-        current = current->next;
     }
-
-
-    if(__createVkCommandPool(*instance) != VK_SUCCESS)
-        return ceResult(CE_ERROR_INTERNAL, "failed to create a Vk command pool");
+    ceTraceEnd("vkCreateInstance", traceBegin);
+
+    const uint32_t deviceCount = args->uDeviceCount ? args->uDeviceCount : 1;
+    VkPhysicalDevice* physicalDevices = malloc(deviceCount * sizeof(VkPhysicalDevice));
+    const CeBool32 devicesFound = __chooseVkDevices((*instance)->vulkanInstance, args, deviceCount, physicalDevices) == VK_SUCCESS;
+    //devices picked explicitly are used even if they are software ones
+    if(args->eBackend == CE_BACKEND_AUTO && deviceCount == 1 && !args->pPhysicalDeviceIndices &&
+        (!devicesFound || __areSoftwareDevices(physicalDevices, deviceCount))) {
+        free(physicalDevices);
+        vkDestroyInstance((*instance)->vulkanInstance, NULL);
+        (*instance)->vulkanInstance = VK_NULL_HANDLE;
+        return __openCpuDevice(*instance, args);
+    }
+    if(!devicesFound) {
+        free(physicalDevices);
+        return ceResult(CE_ERROR_INVALID_ARG, "cannot create instance: not enough physical devices, or a physical device index out of range");
+    }
+    (*instance)->devices = calloc(deviceCount, sizeof(CeInstance));
+    (*instance)->devices[0] = *instance;
+    for(uint32_t i = 0; i < deviceCount; ++i) {
+        //the other devices are instances of their own which share the VkInstance
+        if(i) {
+            (*instance)->devices[i] = calloc(1, sizeof(struct CeInstance_t));
+            (*instance)->devices[i]->parent = *instance;
+            (*instance)->devices[i]->vulkanInstance = (*instance)->vulkanInstance;
+            (*instance)->devices[i]->vulkanApiVersion = (*instance)->vulkanApiVersion;
+        }
+        (*instance)->devices[i]->vulkanPhysicalDevice = physicalDevices[i];
+        //counted as it goes so that destroying the instance after a failure only closes the devices which were opened
+        (*instance)->deviceCount = i + 1;
+        CeResult result = __openDevice((*instance)->devices[i], args);
+        if(result != CE_SUCCESS) {
+            free(physicalDevices);
+            return result;
+        }
+    }
+    free(physicalDevices);
     return CE_SUCCESS;
 }
 
+static void __closeDevice(CeInstance instance) {
+    uint64_t traceBegin = ceTraceBegin();
+    if(instance->pipelineCacheFilename &&
+        ceSavePipelineCache(instance, instance->pipelineCacheFilename, instance->vulkanPipelineCache) != VK_SUCCESS)
+        ceResult(CE_ERROR_INTERNAL, "failed to save the pipeline cache");
+    ceTraceEnd("pipeline cache save", traceBegin);
+    vkDestroyPipelineCache(instance->vulkanDevice, instance->vulkanPipelineCache, NULL);
+    free(instance->pipelineCacheFilename);
+    ceDestroyCompletionQueue(instance, instance->completionQueue);
+    ceDestroyShaderCache(instance, instance->shaderCache);
+    ceDestroyStagingRing(instance, instance->stagingRing);
+    ceDestroyMemoryArena(instance, instance->memoryArena);
+    ceDestroyCommandPoolSet(instance, instance->transferCommandPoolSet);
+    ceDestroyQueueScheduler(instance, instance->transferQueueScheduler);
+    ceDestroyCommandPoolSet(instance, instance->commandPoolSet);
+    ceDestroyQueueScheduler(instance, instance->queueScheduler);
+    vkDestroyDevice(instance->vulkanDevice, NULL);
+}
+
 void ceDestroyInstance(CeInstance instance) {
-    
-    struct CeInstanceQueueList* current, *next;
-    current = instance->queueListHead;
-    next = current->next;
-    for(; current != NULL;) {
-        next = current->next;
-        free(current);
-        current = next;
+    if(instance->parent) {
+        ceResult(CE_ERROR_INVALID_ARG, "cannot destroy instance: devices are destroyed along with the instance which opened them");
+        return;
     }
-
-
-    vkDestroyCommandPool(instance->vulkanDevice, instance->vulkanCommandPool, NULL);
-    vkDestroyDevice(instance->vulkanDevice, NULL);
+    if(instance->cpuBackend) {
+        ceDestroyCpuBackend(instance->cpuBackend);
+        ceDestroyAutotuneDatabase(instance->autotuneDatabase);
+        free(instance->devices);
+        free(instance);
+        return;
+    }
+    for(uint32_t i = instance->deviceCount; i > 1; --i) {
+        __closeDevice(instance->devices[i - 1]);
+        free(instance->devices[i - 1]);
+    }
+    __closeDevice(instance);
+    ceDestroyAutotuneDatabase(instance->autotuneDatabase);
+    free(instance->devices);
     vkDestroyInstance(instance->vulkanInstance, NULL);
     free(instance);
 } 
 
+const uint8_t*
+ceGetInstanceDeviceUUID(CeInstance instance) {
+    return instance->deviceUUID;
+}
+
+CeBool32
+ceGetInstanceSubgroupArithmeticSupported(CeInstance instance) {
+    return instance->subgroupArithmeticSupported;
+}
+
+PFN_vkGetMemoryHostPointerPropertiesEXT
+ceGetInstanceHostPointerImport(CeInstance instance, VkDeviceSize* pAlignment) {
+    *pAlignment = instance->minImportedHostPointerAlignment;
+    return instance->getMemoryHostPointerProperties;
+}
+
+CeBackend
+ceGetInstanceBackend(CeInstance instance) {
+    return instance->backend;
+}
+
+CeCpuBackend
+ceGetInstanceCpuBackend(CeInstance instance) {
+    return instance->cpuBackend;
+}
+
+CeAutotuneDatabase
+ceGetInstanceAutotuneDatabase(CeInstance instance) {
+    return instance->parent ? instance->parent->autotuneDatabase : instance->autotuneDatabase;
+}
+
+uint32_t
+ceGetInstanceDeviceCount(CeInstance instance) {
+    return instance->parent ? 1 : instance->deviceCount;
+}
+
+CeResult
+ceGetInstanceDevice(CeInstance instance, uint32_t uIndex, CeInstance* device) {
+    if(!instance || !device)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot get device: some parameters were NULL");
+    if(uIndex >= ceGetInstanceDeviceCount(instance))
+        return ceResult(CE_ERROR_INVALID_ARG, "cannot get device: index out of range");
+    *device = instance->parent ? instance : instance->devices[uIndex];
+    return CE_SUCCESS;
+}
+
 VkInstance
 ceGetInstanceVulkanInstance(CeInstance instance) {
     return instance->vulkanInstance;
@@ -210,9 +539,9 @@ ceGetInstanceVulkanQueueFamilyIndex(CeInstance instance) {
     return instance->vulkanQueueFamily;
 }
 
-VkCommandPool
-ceGetInstanceVulkanCommandPool(CeInstance instance) {
-    return instance->vulkanCommandPool;
+CeCommandPoolSet
+ceGetInstanceCommandPoolSet(CeInstance instance) {
+    return instance->commandPoolSet;
 }
 
 VkPhysicalDevice
@@ -220,6 +549,113 @@ ceGetInstanceVulkanPhysicalDevice(CeInstance instance) {
     return instance->vulkanPhysicalDevice;
 }
 
+uint32_t
+ceGetInstanceMemoryTypeIndex(CeInstance instance, uint32_t memoryTypeBits, VkMemoryPropertyFlags requiredFlags) {
+    for(uint32_t i = 0; i < instance->vulkanMemoryProperties.memoryTypeCount; ++i) {
+        if(!(memoryTypeBits & (1u << i)))
+            continue;
+        if((instance->vulkanMemoryProperties.memoryTypes[i].propertyFlags & requiredFlags) == requiredFlags)
+            return i;
+    }
+    return CE_INVALID_MEMORY_TYPE;
+}
+
+VkMemoryPropertyFlags
+ceGetInstanceMemoryTypeFlags(CeInstance instance, uint32_t memoryTypeIndex) {
+    return instance->vulkanMemoryProperties.memoryTypes[memoryTypeIndex].propertyFlags;
+}
+
+CeStagingRing
+ceGetInstanceStagingRing(CeInstance instance) {
+    return instance->stagingRing;
+}
+
+CeResult
+ceFlushInstancePipelineCache(CeInstance instance) {
+    if(!instance)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot flush pipeline cache: no instance passed");
+    if(!instance->pipelineCacheFilename)
+        return ceResult(CE_ERROR_INVALID_ARG, "cannot flush pipeline cache: the instance was created without a cache file");
+    uint64_t traceBegin = ceTraceBegin();
+    if(ceSavePipelineCache(instance, instance->pipelineCacheFilename, instance->vulkanPipelineCache) != VK_SUCCESS)
+        return ceResult(CE_ERROR_INTERNAL, "failed to save the pipeline cache");
+    ceTraceEnd("pipeline cache save", traceBegin);
+    return CE_SUCCESS;
+}
+
+VkPipelineCache
+ceGetInstanceVulkanPipelineCache(CeInstance instance) {
+    return instance->vulkanPipelineCache;
+}
+
+const VkPhysicalDeviceProperties*
+ceGetInstanceVulkanDeviceProperties(CeInstance instance) {
+    return &instance->vulkanDeviceProperties;
+}
+
+const VkPhysicalDeviceFeatures*
+ceGetInstanceVulkanEnabledFeatures(CeInstance instance) {
+    return &instance->vulkanEnabledFeatures;
+}
+
+uint32_t
+ceGetInstanceTimestampValidBits(CeInstance instance) {
+    return instance->vulkanQueueTimestampValidBits;
+}
+
+CeMemoryArena
+ceGetInstanceMemoryArena(CeInstance instance) {
+    return instance->memoryArena;
+}
+
+CeShaderCache
+ceGetInstanceShaderCache(CeInstance instance) {
+    return instance->shaderCache;
+}
+
+CeCompletionQueue
+ceGetInstanceCompletionQueue(CeInstance instance) {
+    return instance->completionQueue;
+}
+
+CeQueueScheduler
+ceGetInstanceQueueScheduler(CeInstance instance) {
+    return instance->queueScheduler;
+}
+
+uint32_t
+ceGetInstanceTransferQueueFamilyIndex(CeInstance instance) {
+    return instance->transferQueueFamily;
+}
+
+CeQueueScheduler
+ceGetInstanceTransferQueueScheduler(CeInstance instance) {
+    return instance->transferQueueCount ? instance->transferQueueScheduler : instance->queueScheduler;
+}
+
+CeCommandPoolSet
+ceGetInstanceTransferCommandPoolSet(CeInstance instance) {
+    return instance->transferQueueCount ? instance->transferCommandPoolSet : instance->commandPoolSet;
+}
+
+CeBool32
+ceGetInstanceTimelineSemaphoresEnabled(CeInstance instance) {
+    return instance->timelineSemaphoresEnabled;
+}
+
+CeResult
+ceGetInstanceMemoryStats(CeInstance instance, CeMemoryStats* stats) {
+    if(!instance || !stats)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot get memory stats: some parameters were NULL");
+    //CPU buffers are plain host allocations, there is no arena to report on
+    if(instance->cpuBackend) {
+        memset(stats, 0, sizeof(CeMemoryStats));
+        return CE_SUCCESS;
+    }
+    ceGetMemoryArenaStats(instance->memoryArena, stats);
+    return CE_SUCCESS;
+}
+
 CeVulkanVersion
 ceGetVulkanVersion() {
     uint32_t version;
@@ -234,33 +670,3 @@ ceGetVulkanVersion() {
     }
     return CE_VULKAN_VERSION_1_0;
 }
-
-uint32_t ceGetInstanceNextFreeQueue(CeInstance instance) {
-    uint32_t index = 0;
-    for(struct CeInstanceQueueList* head = instance->queueListHead; head != NULL; head = head->next) {
-        if(head->is_free)
-            return index;
-        ++index;
-    }
-    return 0;
-}
-
-CeResult ceSetInstanceQueueToBusy(CeInstance instance, uint32_t queueIndex) {
-    struct CeInstanceQueueList* head = instance->queueListHead;
-    for(uint32_t i = 0; i < queueIndex; ++i) {
-        head = head->next;
-    }
-    head->is_free = 0;
-    return CE_SUCCESS;
-}
-
-CeResult ceSetInstanceQueueToFree(CeInstance instance, uint32_t queueIndex) {
-    if(!instance)
-        return CE_ERROR_NULL_PASSED;
-    struct CeInstanceQueueList* head = instance->queueListHead;
-    for(uint32_t i = 0; i < queueIndex; ++i) {
-        head = head->next;
-    }
-    head->is_free = 1;
-    return CE_SUCCESS;
-}
\ No newline at end of file
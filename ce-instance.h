@@ -4,11 +4,53 @@ extern "C" {
 #endif
 #include "ce-def.h"
 
+//what an instance runs pipelines on
+typedef enum {
+    CE_BACKEND_VULKAN = 0,
+    //native kernels registered with ceRegisterCpuKernel, run on a pool of worker threads
+    CE_BACKEND_CPU,
+    //Vulkan, unless no Vulkan driver or device can be used or only software devices were found, then the CPU
+    CE_BACKEND_AUTO,
+} CeBackend;
+
 typedef struct {
     const char* pApplicationName;
     uint32_t uApplicationVersion;
+    //size in bytes of the staging buffer used to fill and read back device-local bindings, 0 means 8MiB
+    uint64_t uStagingBufferSize;
+    //size in bytes of the device memory blocks bindings are sub-allocated from, 0 means 64MiB
+    uint64_t uMemoryBlockSize;
+    //if not NULL, compiled pipelines are loaded from this file at creation and saved to it at destruction
+    const char* pPipelineCacheFilename;
+    //number of logical devices the instance opens, 0 means 1. see ceGetInstanceDevice
+    uint32_t uDeviceCount;
+    //if not NULL, the index in Vulkan's enumeration order of the physical device each of the uDeviceCount devices is opened on.
+    //an index can be repeated to open several logical devices on the same physical device.
+    //if NULL, discrete GPUs are used first and every physical device is used at most once
+    const uint32_t* pPhysicalDeviceIndices;
+    //if not NULL, the results of ceAutotunePipeline are loaded from this file at creation and saved to it as they are found
+    const char* pAutotuneDatabaseFilename;
+    //CE_BACKEND_VULKAN by default. a CPU instance opens a single device, uDeviceCount and pPhysicalDeviceIndices must be left unset
+    CeBackend eBackend;
+    //worker threads of the CPU backend, 0 means one per CPU the process can run on
+    uint32_t uCpuThreadCount;
 } CeInstanceCreationArgs;  
 
+typedef struct {
+    //number of VkDeviceMemory blocks currently held by the instance
+    uint32_t uBlockCount;
+    //number of live sub-allocations handed out to buffers
+    uint32_t uAllocationCount;
+    uint64_t uBytesReserved;
+    uint64_t uBytesUsed;
+    uint32_t uFreeRangeCount;
+    uint64_t uLargestFreeRange;
+    //0 when all the free memory is contiguous, close to 1 when it is scattered in small ranges
+    float fFragmentation;
+    //total number of vkAllocateMemory calls made by the instance since its creation
+    uint64_t uDeviceAllocationCount;
+} CeMemoryStats;
+
 /**
 * Create a CE instance and write its address into the supplied handle.
 * \param args pointer to a CeInstanceCreationArgs structure containing parameters for instance creation
@@ -17,6 +59,31 @@ typedef struct {
 CeResult 
 ceCreateInstance(const CeInstanceCreationArgs* args, CeInstance* instance);
 
+/**
+* Get the backend an instance ended up on, never CE_BACKEND_AUTO.
+*/
+CeBackend
+ceGetInstanceBackend(CeInstance instance);
+
+/**
+* Get the number of devices an instance opened, 1 unless it was created with a uDeviceCount above 1.
+*/
+uint32_t
+ceGetInstanceDeviceCount(CeInstance instance);
+
+/**
+* Get one of the devices an instance opened, as an instance of its own.
+* Pipelines, commands and buffers created from the returned handle live on that device, and every call taking them
+* **must** be given that handle. Index 0 is the instance itself.
+* The devices are destroyed along with the instance and **must not** be passed to ceDestroyInstance.
+* Only the instance itself loads and saves the pipeline cache file.
+* \param instance the instance the devices were opened by
+* \param uIndex index of the device, below ceGetInstanceDeviceCount
+* \param device the handle the function writes to
+*/
+CeResult
+ceGetInstanceDevice(CeInstance instance, uint32_t uIndex, CeInstance* device);
+
 /**
 * Reset every command created from an instance.
 * \param instance the instance whose commands are going to be reset
@@ -24,6 +91,22 @@ ceCreateInstance(const CeInstanceCreationArgs* args, CeInstance* instance);
 CeResult
 ceResetInstanceCommands(CeInstance instance);
 
+/**
+* Get usage and fragmentation statistics of the device memory held by an instance.
+* \param instance the instance whose memory is inspected
+* \param stats pointer to the CeMemoryStats structure the function writes to
+*/
+CeResult
+ceGetInstanceMemoryStats(CeInstance instance, CeMemoryStats* stats);
+
+/**
+* Save the compiled pipelines of an instance to the pipeline cache file it was created with.
+* The file is replaced atomically, so other processes never read a partially written cache.
+* \param instance the instance whose pipeline cache is saved
+*/
+CeResult
+ceFlushInstancePipelineCache(CeInstance instance);
+
 /**
 * Destroy a CE instance from a CE instance handle
 * \param instance the instance that is going to be destroyed
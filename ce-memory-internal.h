@@ -0,0 +1,41 @@
+#pragma once
+#include "ce-def.h"
+#include "ce-instance.h"
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan_core.h>
+
+/*
+* The memory arena owns a few large VkDeviceMemory blocks per memory type and hands out
+* aligned sub-ranges of them, so that creating and destroying buffers does not need to
+* go through vkAllocateMemory every time.
+* Host-visible blocks are mapped once for their whole lifetime.
+* Allocating and freeing are thread-safe, each memory type has its own lock.
+*/
+typedef struct CeMemoryArena_t *CeMemoryArena;
+
+#define CE_DEFAULT_MEMORY_BLOCK_SIZE ((VkDeviceSize)64 << 20)
+
+typedef struct {
+    VkDeviceMemory vulkanMemory;
+    VkDeviceSize offset;
+    VkDeviceSize size;
+    //NULL unless the memory is host-visible
+    void* mappedData;
+    uint32_t memoryType;
+    struct CeMemoryBlock* block;
+} CeMemoryAllocation;
+
+VkResult
+ceCreateMemoryArena(CeInstance, VkDeviceSize blockSize, CeMemoryArena*);
+
+VkResult
+ceArenaAllocate(CeInstance, CeMemoryArena, const VkMemoryRequirements*, uint32_t memoryType, CeMemoryAllocation*);
+
+void
+ceArenaFree(CeInstance, CeMemoryArena, CeMemoryAllocation*);
+
+void
+ceGetMemoryArenaStats(CeMemoryArena, CeMemoryStats*);
+
+void
+ceDestroyMemoryArena(CeInstance, CeMemoryArena);
@@ -0,0 +1,282 @@
+#include "ce-memory-internal.h"
+#include "ce-def.h"
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan_core.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "ce-instance-internal.h"
+#include "ce-trace-internal.h"
+
+struct CeMemoryRange {
+    struct CeMemoryRange* next;
+    VkDeviceSize offset;
+    VkDeviceSize size;
+};
+
+struct CeMemoryBlock {
+    struct CeMemoryBlock* next;
+    VkDeviceMemory vulkanMemory;
+    VkDeviceSize size;
+    VkDeviceSize usedSize;
+    void* mappedData;
+    uint32_t allocationCount;
+    //dedicated blocks hold a single allocation too large to share a block and are freed with it
+    CeBool32 isDedicated;
+    //sorted by offset, adjacent ranges are always merged
+    struct CeMemoryRange* freeRanges;
+};
+
+struct CeMemoryArena_t {
+    VkDeviceSize blockSize;
+    struct CeMemoryBlock* blocks[VK_MAX_MEMORY_TYPES];
+    //one lock per memory type guards its block list and the free ranges of its blocks
+    pthread_mutex_t mutexes[VK_MAX_MEMORY_TYPES];
+    atomic_uint_fast64_t deviceAllocationCount;
+};
+
+static VkDeviceSize __alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+    return alignment ? (value + alignment - 1) / alignment * alignment : value;
+}
+
+VkResult
+ceCreateMemoryArena(CeInstance instance, VkDeviceSize blockSize, CeMemoryArena* target) {
+    *target = calloc(1, sizeof(struct CeMemoryArena_t));
+    if(!*target)
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    (*target)->blockSize = blockSize ? blockSize : CE_DEFAULT_MEMORY_BLOCK_SIZE;
+    for(uint32_t i = 0; i < VK_MAX_MEMORY_TYPES; ++i)
+        pthread_mutex_init(&(*target)->mutexes[i], NULL);
+    atomic_init(&(*target)->deviceAllocationCount, 0);
+    return VK_SUCCESS;
+}
+
+static VkResult __createMemoryBlock(CeInstance instance, CeMemoryArena arena, VkDeviceSize size, uint32_t memoryType, struct CeMemoryBlock** target) {
+    struct CeMemoryBlock* block = calloc(1, sizeof(struct CeMemoryBlock));
+    if(!block)
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    VkMemoryAllocateInfo allocInfo = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .allocationSize = size,
+        .memoryTypeIndex = memoryType
+    };
+    uint64_t traceBegin = ceTraceBegin();
+    VkResult result = vkAllocateMemory(ceGetInstanceVulkanDevice(instance), &allocInfo, NULL, &block->vulkanMemory);
+    ceTraceEnd("vkAllocateMemory", traceBegin);
+    if(result != VK_SUCCESS) {
+        free(block);
+        return result;
+    }
+    atomic_fetch_add_explicit(&arena->deviceAllocationCount, 1, memory_order_relaxed);
+    if(ceGetInstanceMemoryTypeFlags(instance, memoryType) & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+        result = vkMapMemory(ceGetInstanceVulkanDevice(instance), block->vulkanMemory, 0, size, 0, &block->mappedData);
+        if(result != VK_SUCCESS) {
+            vkFreeMemory(ceGetInstanceVulkanDevice(instance), block->vulkanMemory, NULL);
+            free(block);
+            return result;
+        }
+    }
+    block->size = size;
+    block->freeRanges = calloc(1, sizeof(struct CeMemoryRange));
+    if(!block->freeRanges) {
+        if(block->mappedData)
+            vkUnmapMemory(ceGetInstanceVulkanDevice(instance), block->vulkanMemory);
+        vkFreeMemory(ceGetInstanceVulkanDevice(instance), block->vulkanMemory, NULL);
+        free(block);
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+    block->freeRanges->size = size;
+    block->next = arena->blocks[memoryType];
+    arena->blocks[memoryType] = block;
+    *target = block;
+    return VK_SUCCESS;
+}
+
+static void __destroyMemoryBlock(CeInstance instance, CeMemoryArena arena, uint32_t memoryType, struct CeMemoryBlock* block) {
+    struct CeMemoryBlock** link = &arena->blocks[memoryType];
+    while(*link != block)
+        link = &(*link)->next;
+    *link = block->next;
+    if(block->mappedData)
+        vkUnmapMemory(ceGetInstanceVulkanDevice(instance), block->vulkanMemory);
+    vkFreeMemory(ceGetInstanceVulkanDevice(instance), block->vulkanMemory, NULL);
+    for(struct CeMemoryRange* range = block->freeRanges, *next; range; range = next) {
+        next = range->next;
+        free(range);
+    }
+    free(block);
+}
+
+//first fit inside a single block, the alignment padding in front of the allocation stays free.
+//VK_ERROR_OUT_OF_DEVICE_MEMORY when no range fits
+static VkResult __allocateFromBlock(struct CeMemoryBlock* block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize* offset) {
+    for(struct CeMemoryRange** link = &block->freeRanges; *link; link = &(*link)->next) {
+        struct CeMemoryRange* range = *link;
+        VkDeviceSize alignedOffset = __alignUp(range->offset, alignment);
+        VkDeviceSize padding = alignedOffset - range->offset;
+        if(range->size < padding + size)
+            continue;
+        VkDeviceSize tailSize = range->size - padding - size;
+        if(padding && tailSize) {
+            struct CeMemoryRange* tail = malloc(sizeof(struct CeMemoryRange));
+            if(!tail)
+                return VK_ERROR_OUT_OF_HOST_MEMORY;
+            tail->offset = alignedOffset + size;
+            tail->size = tailSize;
+            tail->next = range->next;
+            range->next = tail;
+            range->size = padding;
+        } else if(padding) {
+            range->size = padding;
+        } else if(tailSize) {
+            range->offset += size;
+            range->size = tailSize;
+        } else {
+            *link = range->next;
+            free(range);
+        }
+        *offset = alignedOffset;
+        block->usedSize += size;
+        ++block->allocationCount;
+        return VK_SUCCESS;
+    }
+    return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+}
+
+//range is a node allocated beforehand, freed here if the freed range merges with its neighbours
+static void __freeToBlock(struct CeMemoryBlock* block, VkDeviceSize offset, VkDeviceSize size, struct CeMemoryRange* range) {
+    struct CeMemoryRange* previous = NULL;
+    struct CeMemoryRange* next = block->freeRanges;
+    while(next && next->offset < offset) {
+        previous = next;
+        next = next->next;
+    }
+    block->usedSize -= size;
+    --block->allocationCount;
+    if(previous && previous->offset + previous->size == offset) {
+        previous->size += size;
+        if(next && previous->offset + previous->size == next->offset) {
+            previous->size += next->size;
+            previous->next = next->next;
+            free(next);
+        }
+        free(range);
+        return;
+    }
+    if(next && offset + size == next->offset) {
+        next->offset = offset;
+        next->size += size;
+        free(range);
+        return;
+    }
+    //out of host memory, the range stays unusable until the block is destroyed
+    if(!range)
+        return;
+    range->offset = offset;
+    range->size = size;
+    range->next = next;
+    if(previous)
+        previous->next = range;
+    else
+        block->freeRanges = range;
+}
+
+VkResult
+ceArenaAllocate(CeInstance instance, CeMemoryArena arena, const VkMemoryRequirements* requirements, uint32_t memoryType, CeMemoryAllocation* allocation) {
+    struct CeMemoryBlock* block = NULL;
+    VkDeviceSize offset = 0;
+    VkResult result = VK_SUCCESS;
+    pthread_mutex_lock(&arena->mutexes[memoryType]);
+    //requests that would take up most of a block get a block of their own
+    const CeBool32 isDedicated = requirements->size > arena->blockSize / 2;
+    for(block = isDedicated ? NULL : arena->blocks[memoryType]; block; block = block->next) {
+        if(block->isDedicated || block->size - block->usedSize < requirements->size)
+            continue;
+        result = __allocateFromBlock(block, requirements->size, requirements->alignment, &offset);
+        if(result == VK_SUCCESS)
+            break;
+        if(result != VK_ERROR_OUT_OF_DEVICE_MEMORY)
+            goto unlock;
+        result = VK_SUCCESS;
+    }
+    if(!block) {
+        result = __createMemoryBlock(instance, arena, isDedicated ? requirements->size : arena->blockSize, memoryType, &block);
+        if(result != VK_SUCCESS)
+            goto unlock;
+        block->isDedicated = isDedicated;
+        result = __allocateFromBlock(block, requirements->size, requirements->alignment, &offset);
+        if(result != VK_SUCCESS) {
+            __destroyMemoryBlock(instance, arena, memoryType, block);
+            goto unlock;
+        }
+    }
+    allocation->vulkanMemory = block->vulkanMemory;
+    allocation->offset = offset;
+    allocation->size = requirements->size;
+    allocation->mappedData = block->mappedData ? (char*)block->mappedData + offset : NULL;
+    allocation->memoryType = memoryType;
+    allocation->block = block;
+unlock:
+    pthread_mutex_unlock(&arena->mutexes[memoryType]);
+    return result;
+}
+
+void
+ceArenaFree(CeInstance instance, CeMemoryArena arena, CeMemoryAllocation* allocation) {
+    struct CeMemoryBlock* block = allocation->block;
+    if(!block)
+        return;
+    const uint32_t memoryType = allocation->memoryType;
+    //allocated outside of the lock, the free itself cannot fail
+    struct CeMemoryRange* range = malloc(sizeof(struct CeMemoryRange));
+    pthread_mutex_lock(&arena->mutexes[memoryType]);
+    __freeToBlock(block, allocation->offset, allocation->size, range);
+    allocation->block = NULL;
+    if(!block->allocationCount) {
+        CeBool32 destroy = block->isDedicated;
+        //a single empty block per memory type is kept around so that create/destroy churn stays allocation-free
+        for(struct CeMemoryBlock* other = arena->blocks[memoryType]; other && !destroy; other = other->next)
+            destroy = other != block && !other->isDedicated && !other->allocationCount;
+        if(destroy)
+            __destroyMemoryBlock(instance, arena, memoryType, block);
+    }
+    pthread_mutex_unlock(&arena->mutexes[memoryType]);
+}
+
+void
+ceGetMemoryArenaStats(CeMemoryArena arena, CeMemoryStats* stats) {
+    VkDeviceSize freeSize = 0;
+    *stats = (CeMemoryStats){
+        .uDeviceAllocationCount = atomic_load_explicit(&arena->deviceAllocationCount, memory_order_relaxed),
+    };
+    for(uint32_t i = 0; i < VK_MAX_MEMORY_TYPES; ++i) {
+        pthread_mutex_lock(&arena->mutexes[i]);
+        for(struct CeMemoryBlock* block = arena->blocks[i]; block; block = block->next) {
+            ++stats->uBlockCount;
+            stats->uAllocationCount += block->allocationCount;
+            stats->uBytesReserved += block->size;
+            stats->uBytesUsed += block->usedSize;
+            for(struct CeMemoryRange* range = block->freeRanges; range; range = range->next) {
+                ++stats->uFreeRangeCount;
+                freeSize += range->size;
+                if(range->size > stats->uLargestFreeRange)
+                    stats->uLargestFreeRange = range->size;
+            }
+        }
+        pthread_mutex_unlock(&arena->mutexes[i]);
+    }
+    //0 when all the free memory is contiguous, close to 1 when it is scattered in small ranges
+    stats->fFragmentation = freeSize ? 1.f - (float)stats->uLargestFreeRange / (float)freeSize : 0.f;
+}
+
+void
+ceDestroyMemoryArena(CeInstance instance, CeMemoryArena arena) {
+    if(!arena)
+        return;
+    for(uint32_t i = 0; i < VK_MAX_MEMORY_TYPES; ++i) {
+        while(arena->blocks[i])
+            __destroyMemoryBlock(instance, arena, i, arena->blocks[i]);
+        pthread_mutex_destroy(&arena->mutexes[i]);
+    }
+    free(arena);
+}
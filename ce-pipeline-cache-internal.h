@@ -0,0 +1,13 @@
+#pragma once
+#include "ce-def.h"
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan_core.h>
+
+//creates a pipeline cache from a file written by ceSavePipelineCache, or an empty one if the file is missing,
+//unreadable or was written by a different device or driver
+VkResult
+ceLoadPipelineCache(CeInstance, const char* filename, VkPipelineCache*);
+
+//atomically replaces the file with the current contents of the cache
+VkResult
+ceSavePipelineCache(CeInstance, const char* filename, VkPipelineCache);
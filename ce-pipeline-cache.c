@@ -0,0 +1,107 @@
+#include "ce-pipeline-cache-internal.h"
+#include "ce-def.h"
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan_core.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "ce-instance-internal.h"
+#include "ce-file-internal.h"
+
+#define CE_PIPELINE_CACHE_MAGIC 0x43504543u
+#define CE_PIPELINE_CACHE_VERSION 1u
+
+//the driver validates its own blob too, this header lets us skip handing it data from another device altogether
+struct CePipelineCacheFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vendorID;
+    uint32_t deviceID;
+    uint32_t driverVersion;
+    uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+    uint64_t dataSize;
+};
+
+static void __fillPipelineCacheHeader(CeInstance instance, struct CePipelineCacheFileHeader* header) {
+    const VkPhysicalDeviceProperties* properties = ceGetInstanceVulkanDeviceProperties(instance);
+    memset(header, 0, sizeof(*header));
+    header->magic = CE_PIPELINE_CACHE_MAGIC;
+    header->version = CE_PIPELINE_CACHE_VERSION;
+    header->vendorID = properties->vendorID;
+    header->deviceID = properties->deviceID;
+    header->driverVersion = properties->driverVersion;
+    memcpy(header->pipelineCacheUUID, properties->pipelineCacheUUID, VK_UUID_SIZE);
+}
+
+//returns the cache data stored in the file if it was written for this device and driver, NULL otherwise
+static void* __readPipelineCacheFile(CeInstance instance, const char* filename, size_t* dataSize) {
+    FILE* file = fopen(filename, "rb");
+    if(!file)
+        return NULL;
+    struct CePipelineCacheFileHeader expected, header;
+    __fillPipelineCacheHeader(instance, &expected);
+    void* data = NULL;
+    if(fread(&header, sizeof(header), 1, file) == 1 &&
+        header.magic == expected.magic && header.version == expected.version &&
+        header.vendorID == expected.vendorID && header.deviceID == expected.deviceID &&
+        header.driverVersion == expected.driverVersion &&
+        !memcmp(header.pipelineCacheUUID, expected.pipelineCacheUUID, VK_UUID_SIZE)) {
+        data = malloc(header.dataSize);
+        if(data && fread(data, header.dataSize, 1, file) == 1) {
+            *dataSize = header.dataSize;
+        } else {
+            free(data);
+            data = NULL;
+        }
+    }
+    fclose(file);
+    return data;
+}
+
+VkResult
+ceLoadPipelineCache(CeInstance instance, const char* filename, VkPipelineCache* cache) {
+    size_t dataSize = 0;
+    void* data = filename ? __readPipelineCacheFile(instance, filename, &dataSize) : NULL;
+    VkPipelineCacheCreateInfo cacheInfo = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+        .initialDataSize = dataSize,
+        .pInitialData = data,
+    };
+    VkResult result = vkCreatePipelineCache(ceGetInstanceVulkanDevice(instance), &cacheInfo, NULL, cache);
+    //a blob the driver refuses is not worth failing for, start over with an empty cache
+    if(result != VK_SUCCESS && data) {
+        cacheInfo.initialDataSize = 0;
+        cacheInfo.pInitialData = NULL;
+        result = vkCreatePipelineCache(ceGetInstanceVulkanDevice(instance), &cacheInfo, NULL, cache);
+    }
+    free(data);
+    return result;
+}
+
+VkResult
+ceSavePipelineCache(CeInstance instance, const char* filename, VkPipelineCache cache) {
+    VkDevice device = ceGetInstanceVulkanDevice(instance);
+    size_t dataSize = 0;
+    VkResult result = vkGetPipelineCacheData(device, cache, &dataSize, NULL);
+    if(result != VK_SUCCESS)
+        return result;
+    void* data = malloc(dataSize);
+    if(!data)
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    result = vkGetPipelineCacheData(device, cache, &dataSize, data);
+    if(result != VK_SUCCESS) {
+        free(data);
+        return result;
+    }
+
+    struct CePipelineCacheFileHeader header;
+    __fillPipelineCacheHeader(instance, &header);
+    header.dataSize = dataSize;
+
+    //readers never see a half written cache
+    const void* chunks[] = { &header, data };
+    const size_t chunkSizes[] = { sizeof(header), dataSize };
+    result = ceWriteFileAtomically(filename, chunks, chunkSizes, 2);
+    free(data);
+    return result;
+}
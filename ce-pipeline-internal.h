@@ -3,6 +3,13 @@
 #include "ce-pipeline.h"
 #include <vulkan/vulkan.h>
 #include <vulkan/vulkan_core.h>
+#include "ce-cpu-internal.h"
+
+//ceCreatePipeline without the autotuned values stored for the shader
+CeResult ceCreatePipelineUntuned(CeInstance, const CePipelineCreationArgs*, CePipeline*);
+
+//acquires the module of the pipeline's shader from the instance's shader cache, from its code or its file
+VkResult ceAcquirePipelineShaderModule(CeInstance, const CePipelineCreationArgs*, VkShaderModule*);
 
 VkPipeline ceGetPipelineVulkanPipeline(CePipeline);
 
@@ -12,13 +19,30 @@ VkDescriptorSet ceGetPipelineVulkanDescriptorSet(CePipeline);
 
 VkPipelineLayout ceGetPipelineVulkanPipelineLayout(CePipeline);
 
-uint32_t ceGetPipelineDispatchWorkgroupCount(CePipeline);
+//runs the pipeline's kernel on a CPU instance, reading its live constants now
+void ceRunCpuPipeline(CeCpuBackend, CePipeline);
+
+//records the pipeline's dispatch, split in tiles when it is larger than what the device can dispatch at once
+void ceRecordPipelineDispatch(VkCommandBuffer, CePipeline);
+
+CeBuffer ceGetPipelineBindingBuffer(CePipeline, uint32_t bindingIndex);
+
+uint32_t ceGetPipelineBindingCount(CePipeline);
+
+CeBindingAccess ceGetPipelineBindingAccess(CePipeline, uint32_t bindingIndex);
 
-CeResult
-ceSetInstanceQueueToBusy(CeInstance, uint32_t queueIndex);
+//the buffer the group counts are read from, NULL unless the pipeline was created with pIndirectBuffer
+CeBuffer ceGetPipelineIndirectBuffer(CePipeline);
 
-CeResult
-ceSetInstanceQueueToFree(CeInstance, uint32_t queueIndex);
+//the size of the live constants in bytes, a multiple of 4, 0 when the pipeline has none
+uint32_t ceGetPipelineLiveConstantSize(CePipeline);
+
+//a set like the pipeline's own, but reading the live constants from liveBuffer, allocated from a pool of its own which
+//destroying frees it, so that each command recording the pipeline keeps its own copy of the values
+VkResult ceCreatePipelineLiveDescriptorSet(CeInstance, CePipeline, CeBuffer liveBuffer, VkDescriptorPool*, VkDescriptorSet*);
+
+//writes the current values of the live constants to target, laid out as the shader reads them
+void ceWritePipelineLiveConstants(CePipeline, void* target);
 
 VkSemaphore 
 ceGetPipelineBindingSemaphore(CePipeline);
@@ -26,9 +50,9 @@ ceGetPipelineBindingSemaphore(CePipeline);
 uint32_t 
 ceGetPipelineConstantCount(CePipeline);
 
+CeBool32
+ceGetPipelineConstantIsLive(CePipeline, uint32_t constant_index);
+
+//the offset of a live constant is in the live constant buffer, the others are in the push constants
 void
 ceGetPipelineConstantData(CePipeline, uint32_t constant_index, void** pData, uint32_t *uDataSize, uint32_t *uOffset);
-
-
-uint32_t 
-ceGetInstanceNextFreeQueue(CeInstance);
\ No newline at end of file
@@ -7,28 +7,50 @@
 #include "ce-instance-internal.h"
 #include "ce-pipeline-internal.h"
 #include "ce-error-internal.h"
+#include "ce-staging-internal.h"
+#include "ce-buffer-internal.h"
+#include "ce-trace-internal.h"
+#include "ce-command-pool-internal.h"
+#include "ce-autotune-internal.h"
 #include <string.h>
 
 struct CePipeline_t { 
     VkPipeline vulkanFinishedPipeline;
     VkPipelineLayout vulkanPipelineLayout;
-    VkPipelineCache vulkanPipelineCache;
     VkDescriptorSetLayout vulkanDescriptorSetLayout;
     VkShaderModule vulkanShader;
     VkDescriptorPool vulkanDescriptorPool;
     VkDescriptorSet vulkanDescriptorSet;
-    VkBuffer *vulkanBuffers;
-    VkDeviceMemory *vulkanBufferMemory;
-    VkDeviceSize *vulkanBufferMemorySize;
-    void** buffersMappedData;
+    CeBuffer *bindingBuffers;
+    //bindings which reference a supplied buffer do not destroy it with the pipeline
+    CeBool32 *ownsBindingBuffers;
+    CeBindingAccess *bindingAccesses;
     uint32_t bufferCount;
     //uint32_t longestBufferSize;
-    uint32_t dispatchGroupCount;
+    uint32_t dispatchGroupCount[3];
+    //the device's maxComputeWorkGroupCount, larger dispatches are split in tiles of at most this size
+    uint32_t maxDispatchGroupCount[3];
+    //where the first work group of the current tile is pushed, right after the user constants
+    uint32_t dispatchBaseOffset;
+    //set when the group counts are read from a buffer when the pipeline runs, dispatchGroupCount is unused then
+    CeBuffer indirectBuffer;
+    uint64_t indirectOffset;
     CePipelineConstantInfo* constantsData;
+    //offsets in the push constants, or in the live constant buffer for live constants
     uint32_t* constantOffsets;
     uint32_t constantCount;
+    //live constants are read by the shader from this buffer, bound after the bindings, NULL when there are none.
+    //only CPU runs write it, commands bind a descriptor set of their own pointing at their own copy of the values,
+    //see ceCreatePipelineLiveDescriptorSet
+    CeBuffer liveConstantBuffer;
+    uint32_t liveConstantSize;
     //all pipelines create a secondary command buffer and that is what is recorded
     VkCommandBuffer pipelineCommandBuffer;
+    CeCommandPool pipelineCommandPool;
+    //only set on CPU instances, the kernel runs in place of the shader with the bindings' memory
+    CeCpuKernelFunction cpuKernel;
+    void** cpuBindings;
+    uint32_t* cpuBindingElementCounts;
 };
 
 VkPipeline ceGetPipelineVulkanPipeline(CePipeline pipeline) {
@@ -43,21 +65,38 @@ VkPipelineLayout ceGetPipelineVulkanPipelineLayout(CePipeline pipeline) {
     return pipeline->vulkanPipelineLayout;
 }
 
-uint32_t ceGetPipelineDispatchWorkgroupCount(CePipeline pipeline) {
-    return pipeline->dispatchGroupCount;
+void ceRecordPipelineDispatch(VkCommandBuffer commandBuffer, CePipeline pipeline) {
+    uint32_t base[3] = {0, 0, 0};
+    //the counts are not known when recording, so the dispatch cannot be split in tiles and has to fit the device's limits
+    if(pipeline->indirectBuffer) {
+        vkCmdPushConstants(commandBuffer, pipeline->vulkanPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT,
+            pipeline->dispatchBaseOffset, sizeof(base), base);
+        vkCmdDispatchIndirect(commandBuffer, ceGetBufferVulkanBuffer(pipeline->indirectBuffer), pipeline->indirectOffset);
+        return;
+    }
+    //counted in 64 bits, a tile past the last one could wrap around a uint32_t and restart the loop
+    for(uint64_t z = 0; z < pipeline->dispatchGroupCount[2]; z += pipeline->maxDispatchGroupCount[2]) {
+        for(uint64_t y = 0; y < pipeline->dispatchGroupCount[1]; y += pipeline->maxDispatchGroupCount[1]) {
+            for(uint64_t x = 0; x < pipeline->dispatchGroupCount[0]; x += pipeline->maxDispatchGroupCount[0]) {
+                base[0] = (uint32_t)x;
+                base[1] = (uint32_t)y;
+                base[2] = (uint32_t)z;
+                uint32_t count[3];
+                for(uint32_t i = 0; i < 3; ++i) {
+                    const uint32_t remaining = pipeline->dispatchGroupCount[i] - base[i];
+                    count[i] = remaining < pipeline->maxDispatchGroupCount[i] ? remaining : pipeline->maxDispatchGroupCount[i];
+                }
+                vkCmdPushConstants(commandBuffer, pipeline->vulkanPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT,
+                    pipeline->dispatchBaseOffset, sizeof(base), base);
+                vkCmdDispatch(commandBuffer, count[0], count[1], count[2]);
+            }
+        }
+    }
 }
 
-#include <stdio.h>
-
 static VkResult __createCommandBuffer(CeInstance instance, const CePipelineCreationArgs* args, CePipeline pipeline) {
-    VkResult result;
-    VkCommandBufferAllocateInfo commandInfo = {
-        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
-        .commandPool = ceGetInstanceVulkanCommandPool(instance),
-        .level = VK_COMMAND_BUFFER_LEVEL_SECONDARY,
-        .commandBufferCount = 1,
-    };
-    result = vkAllocateCommandBuffers(ceGetInstanceVulkanDevice(instance), &commandInfo, &pipeline->pipelineCommandBuffer);
+    VkResult result = ceAllocateCommandBuffer(instance, ceGetInstanceCommandPoolSet(instance), VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+        &pipeline->pipelineCommandPool, &pipeline->pipelineCommandBuffer);
     if(result != VK_SUCCESS)
         return result;
     VkCommandBufferInheritanceInfo inhInfo = {
@@ -69,20 +108,25 @@ static VkResult __createCommandBuffer(CeInstance instance, const CePipelineCreat
         .flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT,
         .pInheritanceInfo = &inhInfo
     };
+    ceLockCommandPool(pipeline->pipelineCommandPool);
     result = vkBeginCommandBuffer(pipeline->pipelineCommandBuffer, &beginInfo);
-    if(result != VK_SUCCESS)
+    if(result != VK_SUCCESS) {
+        ceUnlockCommandPool(pipeline->pipelineCommandPool);
         return result;
+    }
     vkCmdBindPipeline(pipeline->pipelineCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->vulkanFinishedPipeline);
     vkCmdBindDescriptorSets(pipeline->pipelineCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->vulkanPipelineLayout,
      0, 1, &pipeline->vulkanDescriptorSet, 0, NULL);
     
-    uint32_t dataOffset = 0;
     for(uint32_t i = 0; i < pipeline->constantCount; ++i) {
-        vkCmdPushConstants(pipeline->pipelineCommandBuffer, pipeline->vulkanPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, dataOffset, pipeline->constantsData[i].uDataSize, pipeline->constantsData[i].pData);
-        dataOffset += pipeline->constantsData[i].uDataSize;
+        if(pipeline->constantsData[i].bIsLiveConstant)
+            continue;
+        vkCmdPushConstants(pipeline->pipelineCommandBuffer, pipeline->vulkanPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT,
+            pipeline->constantOffsets[i], pipeline->constantsData[i].uDataSize, pipeline->constantsData[i].pData);
     }
-    vkCmdDispatch(pipeline->pipelineCommandBuffer, args->uDispatchGroupCount, 1, 1);
+    ceRecordPipelineDispatch(pipeline->pipelineCommandBuffer, pipeline);
     result = vkEndCommandBuffer(pipeline->pipelineCommandBuffer);
+    ceUnlockCommandPool(pipeline->pipelineCommandPool);
     return result;
 }
 
@@ -90,100 +134,132 @@ VkCommandBuffer ceGetPipelineVulkanCommand(CePipeline pipe) {
     return pipe->pipelineCommandBuffer;
 }
 
-static VkResult __createVkBuffersFromBindings(CeInstance instance, const CePipelineCreationArgs* args, CePipeline pipeline) {
+static VkResult __createBuffersFromBindings(CeInstance instance, const CePipelineCreationArgs* args, CePipeline pipeline) {
     pipeline->bufferCount = args->uBindingCount;
-    pipeline->buffersMappedData = calloc(pipeline->bufferCount, sizeof(void*));
-    //VkBufferCreateInfo *bufferInfos = calloc(pipeline->bufferCount, sizeof(VkBufferCreateInfo));
-    uint32_t familyIndex = ceGetInstanceVulkanQueueFamilyIndex(instance);
-    pipeline->vulkanBuffers = calloc(pipeline->bufferCount, sizeof(VkBuffer));
-    pipeline->vulkanBufferMemory = calloc(pipeline->bufferCount, sizeof(VkDeviceMemory));
-    pipeline->vulkanBufferMemorySize = calloc(pipeline->bufferCount, sizeof(VkDeviceSize));
-
-    VkPhysicalDeviceMemoryProperties memoryProperties;
-    vkGetPhysicalDeviceMemoryProperties(ceGetInstanceVulkanPhysicalDevice(instance), &memoryProperties);
-    uint32_t MemoryTypeIndex = ~((uint32_t)0);
-    VkDeviceSize MemoryHeapSize = ~((uint32_t)0);
-
-    for (uint32_t CurrentMemoryTypeIndex = 0; CurrentMemoryTypeIndex < memoryProperties.memoryTypeCount; ++CurrentMemoryTypeIndex)
-    {
-        VkMemoryType MemoryType = memoryProperties.memoryTypes[CurrentMemoryTypeIndex];
-        if ((VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT & MemoryType.propertyFlags) &&
-            (VK_MEMORY_PROPERTY_HOST_COHERENT_BIT & MemoryType.propertyFlags))
-        {
-            MemoryHeapSize = memoryProperties.memoryHeaps[MemoryType.heapIndex].size;
-            MemoryTypeIndex = CurrentMemoryTypeIndex;
-            break;
-        }
-    }
+    pipeline->bindingBuffers = calloc(pipeline->bufferCount, sizeof(CeBuffer));
+    pipeline->ownsBindingBuffers = calloc(pipeline->bufferCount, sizeof(CeBool32));
+    pipeline->bindingAccesses = calloc(pipeline->bufferCount, sizeof(CeBindingAccess));
+    if(pipeline->bufferCount && (!pipeline->bindingBuffers || !pipeline->ownsBindingBuffers || !pipeline->bindingAccesses))
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
 
     uint32_t longestBufferSize = 0;
     for(uint32_t i = 0; i < pipeline->bufferCount; ++i) {
-        pipeline->vulkanBufferMemorySize[i] = args->pBindings[i].uElementCount * args->pBindings[i].uElementSize;
-        VkBufferCreateInfo bufferInfo = {
-            .size = pipeline->vulkanBufferMemorySize[i],
-            .pQueueFamilyIndices = &familyIndex,
-            .queueFamilyIndexCount = 1,
-            .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
-            .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-            .usage = args->pBindings[i].bIsUniform ? VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT : VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, 
-        };
-        
+        //uniform buffers are never written by shaders
+        pipeline->bindingAccesses[i] = args->pBindings[i].bIsUniform ? CE_BINDING_ACCESS_READ_ONLY : args->pBindings[i].eAccess;
+        //bindings can reference a buffer created beforehand instead of getting one of their own
+        if(args->pBindings[i].pSuppliedBuffer) {
+            pipeline->bindingBuffers[i] = args->pBindings[i].pSuppliedBuffer;
+        } else {
+            CeBufferCreationArgs bufferArgs = {
+                .uElementSize = args->pBindings[i].uElementSize,
+                .uElementCount = args->pBindings[i].uElementCount,
+                .pInitialData = args->pBindings[i].pInitialData,
+                .bKeepMapped = args->pBindings[i].bKeepMapped,
+                .ePlacement = args->pBindings[i].ePlacement,
+                .pHostMemory = args->pBindings[i].pHostMemory,
+            };
+            if(ceCreateBufferUnflushed(instance, &bufferArgs, &pipeline->bindingBuffers[i]) != CE_SUCCESS)
+                return VK_ERROR_INITIALIZATION_FAILED;
+            pipeline->ownsBindingBuffers[i] = CE_TRUE;
+        }
+        uint32_t elementCount = ceGetBufferElementCount(pipeline->bindingBuffers[i]);
         longestBufferSize = 
-            longestBufferSize < args->pBindings[i].uElementCount ? 
-            args->pBindings[i].uElementCount :
+            longestBufferSize < elementCount ? 
+            elementCount :
             longestBufferSize;
-        /*bufferInfos[i].pNext = NULL;
-        bufferInfos[i].size = args->pPipelineBindings[i].uBindingElementCount * args->pPipelineBindings[i].uBindingElementSize;
-        bufferInfos[i].usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
-        bufferInfos[i].sharingMode = VK_SHARING_MODE_CONCURRENT;
-        bufferInfos[i].queueFamilyIndexCount = 1;
-        bufferInfos[i].pQueueFamilyIndices = &familyIndex;
-        bufferInfos[i].sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;*/
-        vkCreateBuffer(ceGetInstanceVulkanDevice(instance), &bufferInfo, NULL, &pipeline->vulkanBuffers[i]);
-        VkMemoryRequirements memoryRequirements;
-        vkGetBufferMemoryRequirements(ceGetInstanceVulkanDevice(instance), pipeline->vulkanBuffers[i], &memoryRequirements);
-        VkMemoryAllocateInfo allocInfo = {
-            .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-            .allocationSize = memoryRequirements.size,
-            .memoryTypeIndex = MemoryTypeIndex
+    }
+    if(!pipeline->dispatchGroupCount[0])
+        pipeline->dispatchGroupCount[0] = longestBufferSize;
+    if(pipeline->liveConstantSize) {
+        CeBufferCreationArgs liveArgs = {
+            .uElementSize = sizeof(uint32_t),
+            .uElementCount = pipeline->liveConstantSize / sizeof(uint32_t),
+            .ePlacement = CE_BINDING_PLACEMENT_DEVICE_LOCAL,
         };
-        vkAllocateMemory(ceGetInstanceVulkanDevice(instance), &allocInfo, NULL, &pipeline->vulkanBufferMemory[i]);
-        if(args->pBindings[i].bKeepMapped || args->pBindings[i].pInitialData) {
-            vkMapMemory(ceGetInstanceVulkanDevice(instance), pipeline->vulkanBufferMemory[i], 0, memoryRequirements.size, 0, &pipeline->buffersMappedData[i]);
-            if(args->pBindings[i].pInitialData)
-                memcpy(pipeline->buffersMappedData[i], args->pBindings[i].pInitialData, memoryRequirements.size);
-            if(!args->pBindings[i].bKeepMapped) {
-                vkUnmapMemory(ceGetInstanceVulkanDevice(instance), pipeline->vulkanBufferMemory[i]);
-                pipeline->buffersMappedData[i] = NULL;
-            }
-        }
-        
-        vkBindBufferMemory(ceGetInstanceVulkanDevice(instance), pipeline->vulkanBuffers[i], pipeline->vulkanBufferMemory[i], 0);
+        if(ceCreateBufferUnflushed(instance, &liveArgs, &pipeline->liveConstantBuffer) != CE_SUCCESS)
+            return VK_ERROR_INITIALIZATION_FAILED;
     }
-    if(!pipeline->dispatchGroupCount)
-        pipeline->dispatchGroupCount = longestBufferSize;
-    //free(bufferInfos);
-    return VK_SUCCESS;  
+    //every staged initial upload goes out in as few submissions as the staging buffer allows
+    if(ceGetInstanceCpuBackend(instance))
+        return VK_SUCCESS;
+    return ceFlushStagingRing(instance, ceGetInstanceStagingRing(instance));
 }
 
 CeResult
 ceMapPipelineBindingMemory(CeInstance instance, CePipeline pipeline, uint32_t bindingIndex, void** target) {
-    if(vkMapMemory(ceGetInstanceVulkanDevice(instance),
-    pipeline->vulkanBufferMemory[bindingIndex], 0, pipeline->vulkanBufferMemorySize[bindingIndex], 
-    0, target) != CE_SUCCESS)
-        return CE_ERROR_INTERNAL;
-    return CE_SUCCESS;
+    if(!instance || !pipeline || !target)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot map binding memory: some parameters were NULL");
+    if(bindingIndex >= pipeline->bufferCount)
+        return ceResult(CE_ERROR_INVALID_ARG, "cannot map binding memory: binding index out of range");
+    return ceMapBufferMemory(instance, pipeline->bindingBuffers[bindingIndex], target);
 }
 
 void
 ceUnmapPipelineBindingMemory(CeInstance instance, CePipeline pipeline, uint32_t bindingIndex) {
-    vkUnmapMemory(ceGetInstanceVulkanDevice(instance), pipeline->vulkanBufferMemory[bindingIndex]);
+    ceUnmapBufferMemory(instance, pipeline->bindingBuffers[bindingIndex]);
+}
+
+CeResult
+ceSyncPipelineBindingHostMemory(CeInstance instance, CePipeline pipeline, uint32_t bindingIndex, CeBool32 toDevice) {
+    if(!instance || !pipeline)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot sync binding host memory: some parameters were NULL");
+    if(bindingIndex >= pipeline->bufferCount)
+        return ceResult(CE_ERROR_INVALID_ARG, "cannot sync binding host memory: binding index out of range");
+    return ceSyncBufferHostMemory(instance, pipeline->bindingBuffers[bindingIndex], toDevice);
 }
 
-static VkResult __createVkDescriptorPool(CeInstance instance, CePipeline pipeline) {
+CeResult
+ceGetPipelineBindingBufferHandle(CePipeline pipeline, uint32_t bindingIndex, CeBuffer* target) {
+    if(!pipeline || !target)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot get binding buffer: some parameters were NULL");
+    if(bindingIndex >= pipeline->bufferCount)
+        return ceResult(CE_ERROR_INVALID_ARG, "cannot get binding buffer: binding index out of range");
+    *target = pipeline->bindingBuffers[bindingIndex];
+    return CE_SUCCESS;
+}
+
+CeBuffer
+ceGetPipelineBindingBuffer(CePipeline pipeline, uint32_t bindingIndex) {
+    return pipeline->bindingBuffers[bindingIndex];
+}
+
+uint32_t
+ceGetPipelineBindingCount(CePipeline pipeline) {
+    return pipeline->bufferCount;
+}
+
+CeBindingAccess
+ceGetPipelineBindingAccess(CePipeline pipeline, uint32_t bindingIndex) {
+    return pipeline->bindingAccesses[bindingIndex];
+}
+
+CeBuffer
+ceGetPipelineIndirectBuffer(CePipeline pipeline) {
+    return pipeline->indirectBuffer;
+}
+
+uint32_t
+ceGetPipelineLiveConstantSize(CePipeline pipeline) {
+    return pipeline->liveConstantSize;
+}
+
+void
+ceWritePipelineLiveConstants(CePipeline pipeline, void* target) {
+    for(uint32_t i = 0; i < pipeline->constantCount; ++i) {
+        if(pipeline->constantsData[i].bIsLiveConstant)
+            memcpy((char*)target + pipeline->constantOffsets[i], pipeline->constantsData[i].pData, pipeline->constantsData[i].uDataSize);
+    }
+}
+
+//the live constant buffer is one more storage buffer, bound right after the bindings
+static uint32_t __getDescriptorCount(CePipeline pipeline) {
+    return pipeline->bufferCount + (pipeline->liveConstantBuffer ? 1 : 0);
+}
+
+static VkResult __createVkDescriptorPool(CeInstance instance, CePipeline pipeline, VkDescriptorPool* pool) {
     VkDescriptorPoolSize poolSizes[] = {
         {
-            .descriptorCount = pipeline->bufferCount,
+            .descriptorCount = __getDescriptorCount(pipeline),
             .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER
         }, {
             .descriptorCount = pipeline->bufferCount,
@@ -198,67 +274,22 @@ static VkResult __createVkDescriptorPool(CeInstance instance, CePipeline pipelin
         .pPoolSizes = poolSizes,
         .maxSets = 1
     };
-    return vkCreateDescriptorPool(ceGetInstanceVulkanDevice(instance), &poolInfo, NULL, &pipeline->vulkanDescriptorPool);
-}
-
-static VkResult __createVkShaderModule(CeInstance instance, CePipeline pipeline, const CePipelineCreationArgs* args) {
-    FILE *file;
-	char *buffer;
-	unsigned long fileLen;
-
-	//Open file
-	file = fopen(args->pShaderFilename, "rb");
-	if (!file)
-	{
-		//fprintf(stderr, "Unable to open file %s", name);
-		return (VkResult)ceResult(CE_ERROR_INTERNAL, "stdlib failed to open a file");
-	}
-	
-	//Get file length
-	fseek(file, 0, SEEK_END);
-	fileLen=ftell(file);
-	fseek(file, 0, SEEK_SET);
-
-	//Allocate memory
-	buffer=(char *)malloc(fileLen+1);
-	if (!buffer)
-	{
-		//fprintf(stderr, "Memory error!");
-        //                        fclose(file);
-		return (VkResult)ceResult(CE_ERROR_INTERNAL, "stdlib failed to allocate a file buffer");
-	}
-
-	//Read file contents into buffer
-	fread(buffer, fileLen, 1, file);
-	fclose(file);
-
-	//Do what ever with buffer
-
-	
-    
-    VkShaderModuleCreateInfo shaderInfo = {
-        .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
-        .codeSize = fileLen,
-        .pCode = (uint32_t*)buffer,
-    };
-
-    VkResult result = vkCreateShaderModule(ceGetInstanceVulkanDevice(instance), &shaderInfo, NULL, &pipeline->vulkanShader);
-    
-    free(buffer);
-    return result;
+    return vkCreateDescriptorPool(ceGetInstanceVulkanDevice(instance), &poolInfo, NULL, pool);
 }
 
 static VkResult __createVkDescriptorSetLayout(CeInstance instance, CePipeline pipeline, const CePipelineCreationArgs* args) {
-    VkDescriptorSetLayoutBinding *bindings = calloc(pipeline->bufferCount, sizeof(VkDescriptorSetLayoutBinding));
-    for(uint32_t i = 0; i < args->uBindingCount; ++i) {
+    const uint32_t descriptorCount = __getDescriptorCount(pipeline);
+    VkDescriptorSetLayoutBinding *bindings = calloc(descriptorCount ? descriptorCount : 1, sizeof(VkDescriptorSetLayoutBinding));
+    for(uint32_t i = 0; i < descriptorCount; ++i) {
         bindings[i].binding = i;
-        bindings[i].descriptorType = args->pBindings[i].bIsUniform ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorType = i < args->uBindingCount && args->pBindings[i].bIsUniform ?
+            VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
         bindings[i].descriptorCount = 1;
         bindings[i].stageFlags = VK_SHADER_STAGE_ALL;
     }
     VkDescriptorSetLayoutCreateInfo layoutInfo = {
         .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
-        .bindingCount = pipeline->bufferCount,
+        .bindingCount = descriptorCount,
         .pBindings = bindings,
     };
     VkResult result = vkCreateDescriptorSetLayout(ceGetInstanceVulkanDevice(instance), &layoutInfo, NULL, &pipeline->vulkanDescriptorSetLayout);
@@ -276,13 +307,15 @@ static VkResult __createVkDescriptorSet(CeInstance instance, const CePipelineCre
 
     VkResult result = vkAllocateDescriptorSets(ceGetInstanceVulkanDevice(instance), &setInfo, &pipeline->vulkanDescriptorSet);
     
-    VkDescriptorBufferInfo *buffers = calloc(pipeline->bufferCount, sizeof(VkDescriptorBufferInfo));
-    VkWriteDescriptorSet *descriptorSetWrites = calloc(pipeline->bufferCount, sizeof(VkWriteDescriptorSet));
+    const uint32_t descriptorCount = __getDescriptorCount(pipeline);
+    VkDescriptorBufferInfo *buffers = calloc(descriptorCount ? descriptorCount : 1, sizeof(VkDescriptorBufferInfo));
+    VkWriteDescriptorSet *descriptorSetWrites = calloc(descriptorCount ? descriptorCount : 1, sizeof(VkWriteDescriptorSet));
     
-    for(uint32_t i = 0; i < pipeline->bufferCount; ++i) {
-        buffers[i].buffer = pipeline->vulkanBuffers[i];
+    for(uint32_t i = 0; i < descriptorCount; ++i) {
+        CeBuffer buffer = i < pipeline->bufferCount ? pipeline->bindingBuffers[i] : pipeline->liveConstantBuffer;
+        buffers[i].buffer = ceGetBufferVulkanBuffer(buffer);
         buffers[i].offset = 0;
-        buffers[i].range = args->pBindings[i].uElementCount * args->pBindings[i].uElementSize;
+        buffers[i].range = ceGetBufferSize(buffer);
         //VkWriteDescriptorSet descriptorSetWrites = {};
         descriptorSetWrites[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
         descriptorSetWrites[i].pNext = NULL;
@@ -290,29 +323,75 @@ static VkResult __createVkDescriptorSet(CeInstance instance, const CePipelineCre
         descriptorSetWrites[i].dstBinding = i;
         descriptorSetWrites[i].dstArrayElement = 0;
         descriptorSetWrites[i].descriptorCount = 1;
-        descriptorSetWrites[i].descriptorType = args->pBindings[i].bIsUniform ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        descriptorSetWrites[i].descriptorType = i < args->uBindingCount && args->pBindings[i].bIsUniform ?
+            VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
         descriptorSetWrites[i].pBufferInfo = &buffers[i];
         //vkUpdateDescriptorSets(ceGetInstanceVulkanDevice(instance), 1,
         // &descriptorSetWrites, 0, NULL);  
     }
 
-    vkUpdateDescriptorSets(ceGetInstanceVulkanDevice(instance), pipeline->bufferCount,
+    vkUpdateDescriptorSets(ceGetInstanceVulkanDevice(instance), descriptorCount,
      descriptorSetWrites, 0, NULL);
     free(buffers);
     free(descriptorSetWrites);
     return result;
 }
 
-static VkResult __createVkPipelineLayoutAndCache(CeInstance instance, const CePipelineCreationArgs* args, CePipeline pipeline) {
-    VkPushConstantRange *constants = calloc(args->uConstantCount, sizeof(VkPushConstantRange));
-    pipeline->constantsData = calloc(args->uConstantCount, sizeof(void*));
+VkResult
+ceCreatePipelineLiveDescriptorSet(CeInstance instance, CePipeline pipeline, CeBuffer liveBuffer, VkDescriptorPool* pool,
+    VkDescriptorSet* set) {
+    VkDevice device = ceGetInstanceVulkanDevice(instance);
+    VkResult result = __createVkDescriptorPool(instance, pipeline, pool);
+    if(result != VK_SUCCESS)
+        return result;
+    VkDescriptorSetAllocateInfo setInfo = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorPool = *pool,
+        .descriptorSetCount = 1,
+        .pSetLayouts = &pipeline->vulkanDescriptorSetLayout,
+    };
+    //the bindings are copied from the pipeline's own set, they never change once the pipeline is created
+    VkCopyDescriptorSet* copies = calloc(pipeline->bufferCount ? pipeline->bufferCount : 1, sizeof(VkCopyDescriptorSet));
+    result = copies ? vkAllocateDescriptorSets(device, &setInfo, set) : VK_ERROR_OUT_OF_HOST_MEMORY;
+    if(result != VK_SUCCESS) {
+        free(copies);
+        vkDestroyDescriptorPool(device, *pool, NULL);
+        *pool = VK_NULL_HANDLE;
+        return result;
+    }
+    for(uint32_t i = 0; i < pipeline->bufferCount; ++i) {
+        copies[i].sType = VK_STRUCTURE_TYPE_COPY_DESCRIPTOR_SET;
+        copies[i].srcSet = pipeline->vulkanDescriptorSet;
+        copies[i].srcBinding = i;
+        copies[i].dstSet = *set;
+        copies[i].dstBinding = i;
+        copies[i].descriptorCount = 1;
+    }
+    VkDescriptorBufferInfo liveInfo = {
+        .buffer = ceGetBufferVulkanBuffer(liveBuffer),
+        .offset = 0,
+        .range = ceGetBufferSize(liveBuffer),
+    };
+    VkWriteDescriptorSet liveWrite = {
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .dstSet = *set,
+        .dstBinding = pipeline->bufferCount,
+        .descriptorCount = 1,
+        .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        .pBufferInfo = &liveInfo,
+    };
+    vkUpdateDescriptorSets(device, 1, &liveWrite, pipeline->bufferCount, copies);
+    free(copies);
+    return VK_SUCCESS;
+}
+
+static void __storeConstants(const CePipelineCreationArgs* args, CePipeline pipeline) {
+    pipeline->constantsData = calloc(args->uConstantCount, sizeof(CePipelineConstantInfo));
     pipeline->constantCount = args->uConstantCount;
     pipeline->constantOffsets = calloc(args->uConstantCount, sizeof(uint32_t));
-    uint32_t accumulatedOffset = 0;
+    uint32_t accumulatedOffset = 0, liveOffset = 0;
     for(uint32_t i = 0; i < pipeline->constantCount; ++i) {
-        constants[i].offset = accumulatedOffset;
-        constants[i].size = args->pConstants[i].uDataSize;
-        constants[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipeline->constantsData[i].bIsLiveConstant = args->pConstants[i].bIsLiveConstant;
         if(!pipeline->constantsData[i].bIsLiveConstant) {
             pipeline->constantsData[i].pData = calloc(args->pConstants[i].uDataSize, 1);
             memcpy(pipeline->constantsData[i].pData, args->pConstants[i].pData, args->pConstants[i].uDataSize);
@@ -320,24 +399,34 @@ static VkResult __createVkPipelineLayoutAndCache(CeInstance instance, const CePi
             pipeline->constantsData[i].pData = args->pConstants[i].pData;
         }
         pipeline->constantsData[i].uDataSize = args->pConstants[i].uDataSize;
-        pipeline->constantOffsets[i] = accumulatedOffset;
-        accumulatedOffset += constants[i].size;
+        //live constants are laid out one after the other in their own buffer, the others in the push constants
+        uint32_t* offset = pipeline->constantsData[i].bIsLiveConstant ? &liveOffset : &accumulatedOffset;
+        pipeline->constantOffsets[i] = *offset;
+        *offset += args->pConstants[i].uDataSize;
     }
+    //a uvec3 declared after the user constants lands on the next 16 byte boundary in GLSL
+    pipeline->dispatchBaseOffset = (accumulatedOffset + 15) & ~15u;
+    //copies to the buffer are made in whole 4 byte words
+    pipeline->liveConstantSize = (liveOffset + 3) & ~3u;
+}
+
+static VkResult __createVkPipelineLayout(CeInstance instance, CePipeline pipeline) {
+    //a single range, ranges sharing a shader stage are not allowed
+    VkPushConstantRange constants = {
+        .offset = 0,
+        .size = pipeline->dispatchBaseOffset + 3 * sizeof(uint32_t),
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+    };
+    if(constants.size > ceGetInstanceVulkanDeviceProperties(instance)->limits.maxPushConstantsSize)
+        return VK_ERROR_INITIALIZATION_FAILED;
     VkPipelineLayoutCreateInfo layoutInfo = {
         .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
         .pSetLayouts = &pipeline->vulkanDescriptorSetLayout,
-        .pushConstantRangeCount = pipeline->constantCount,
-        .pPushConstantRanges = constants,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &constants,
         .setLayoutCount = 1,
     };
-    VkPipelineCacheCreateInfo cacheInfo = {
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
-        
-    };
-    VkResult result = vkCreatePipelineLayout(ceGetInstanceVulkanDevice(instance), &layoutInfo, NULL, &pipeline->vulkanPipelineLayout);
-    vkCreatePipelineCache(ceGetInstanceVulkanDevice(instance), &cacheInfo, NULL, &pipeline->vulkanPipelineCache);
-    free(constants);
-    return result;
+    return vkCreatePipelineLayout(ceGetInstanceVulkanDevice(instance), &layoutInfo, NULL, &pipeline->vulkanPipelineLayout);
 }
 
 
@@ -346,6 +435,11 @@ ceGetPipelineConstantCount(CePipeline pipeline) {
     return pipeline->constantCount;
 }
 
+CeBool32
+ceGetPipelineConstantIsLive(CePipeline pipeline, uint32_t constant_index) {
+    return pipeline->constantsData[constant_index].bIsLiveConstant;
+}
+
 void
 ceGetPipelineConstantData(CePipeline pipeline, uint32_t constant_index, void** pData, uint32_t *uDataSize, uint32_t *uOffset) {
     (*pData) = pipeline->constantsData[constant_index].pData;
@@ -355,85 +449,235 @@ ceGetPipelineConstantData(CePipeline pipeline, uint32_t constant_index, void** p
 
 CeResult 
 ceGetPipelineBindingMemory(CePipeline pipeline, uint32_t bindingIndex, void** pData) {
-    if(!pipeline->buffersMappedData[bindingIndex])
+    void* mappedData = ceGetBufferMappedData(pipeline->bindingBuffers[bindingIndex]);
+    if(!mappedData)
         return ceResult(CE_ERROR_BINDING_NOT_MAPPED, "requested access to binding memory but it was not mapped");
-    *pData = pipeline->buffersMappedData[bindingIndex];
+    *pData = mappedData;
     return CE_SUCCESS;
 }
 
-static VkResult __createVkPipeline(CeInstance instance, CePipeline pipeline) {
+static VkResult __createVkPipeline(CeInstance instance, const CePipelineCreationArgs* args, CePipeline pipeline) {
+    //the specialization values are packed one after the other
+    const uint32_t entryCount = args->uSpecializationConstantCount;
+    VkSpecializationMapEntry* entries = calloc(entryCount, sizeof(VkSpecializationMapEntry));
+    size_t dataSize = 0;
+    for(uint32_t i = 0; i < entryCount; ++i) {
+        entries[i].constantID = args->pSpecializationConstants[i].uConstantId;
+        entries[i].offset = dataSize;
+        entries[i].size = args->pSpecializationConstants[i].uDataSize;
+        dataSize += args->pSpecializationConstants[i].uDataSize;
+    }
+    char* data = malloc(dataSize ? dataSize : 1);
+    for(uint32_t i = 0; i < entryCount; ++i)
+        memcpy(data + entries[i].offset, args->pSpecializationConstants[i].pData, entries[i].size);
+    VkSpecializationInfo specializationInfo = {
+        .mapEntryCount = entryCount,
+        .pMapEntries = entries,
+        .dataSize = dataSize,
+        .pData = data,
+    };
     VkPipelineShaderStageCreateInfo shaderInfo = {
         .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
         .stage = VK_SHADER_STAGE_COMPUTE_BIT,
         .module = pipeline->vulkanShader,
         .pName = "main",
+        .pSpecializationInfo = entryCount ? &specializationInfo : NULL,
     };
     VkComputePipelineCreateInfo pipeInfo = {
         .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
         .layout = pipeline->vulkanPipelineLayout,
         .stage = shaderInfo,
     };
-    return vkCreateComputePipelines(ceGetInstanceVulkanDevice(instance),
-    pipeline->vulkanPipelineCache, 1, &pipeInfo, 
+    VkResult result = vkCreateComputePipelines(ceGetInstanceVulkanDevice(instance),
+    ceGetInstanceVulkanPipelineCache(instance), 1, &pipeInfo, 
     NULL, &pipeline->vulkanFinishedPipeline);
+    free(entries);
+    free(data);
+    return result;
 }
 
-CeResult ceCreatePipeline(CeInstance instance, const CePipelineCreationArgs * args, CePipeline * pipeline) {
+VkResult ceAcquirePipelineShaderModule(CeInstance instance, const CePipelineCreationArgs* args, VkShaderModule* shader) {
+    CeShaderCache shaderCache = ceGetInstanceShaderCache(instance);
+    if(args->pShaderCode)
+        return ceAcquireShaderModuleFromCode(instance, shaderCache, args->pShaderCode, args->uShaderCodeSize, shader);
+    if(!args->pShaderFilename)
+        return VK_ERROR_INITIALIZATION_FAILED;
+    return ceAcquireShaderModule(instance, shaderCache, args->pShaderFilename, shader);
+}
+
+static VkResult __createCpuPipeline(CeInstance instance, const CePipelineCreationArgs* args, CePipeline pipeline) {
+    //there is no SPIR-V to run, kernels are found by the name of the shader they stand for
+    if(!args->pShaderFilename)
+        return VK_ERROR_INITIALIZATION_FAILED;
+    pipeline->cpuKernel = ceFindCpuBackendKernel(ceGetInstanceCpuBackend(instance), args->pShaderFilename);
+    if(!pipeline->cpuKernel)
+        return VK_ERROR_INITIALIZATION_FAILED;
+    //the live constants come after the bindings, as they do for shaders
+    const uint32_t descriptorCount = __getDescriptorCount(pipeline);
+    pipeline->cpuBindings = calloc(descriptorCount ? descriptorCount : 1, sizeof(void*));
+    pipeline->cpuBindingElementCounts = calloc(descriptorCount ? descriptorCount : 1, sizeof(uint32_t));
+    for(uint32_t i = 0; i < descriptorCount; ++i) {
+        CeBuffer buffer = i < pipeline->bufferCount ? pipeline->bindingBuffers[i] : pipeline->liveConstantBuffer;
+        pipeline->cpuBindings[i] = ceGetBufferCpuMemory(buffer);
+        pipeline->cpuBindingElementCounts[i] = ceGetBufferElementCount(buffer);
+    }
+    return VK_SUCCESS;
+}
+
+void ceRunCpuPipeline(CeCpuBackend cpuBackend, CePipeline pipeline) {
+    //laid out as ceRecordPipelineDispatch pushes them, the whole dispatch is a single tile so its base is 0
+    const uint32_t constantsSize = pipeline->dispatchBaseOffset + 3 * sizeof(uint32_t);
+    char* constants = calloc(constantsSize, 1);
+    for(uint32_t i = 0; i < pipeline->constantCount; ++i) {
+        if(!pipeline->constantsData[i].bIsLiveConstant)
+            memcpy(constants + pipeline->constantOffsets[i], pipeline->constantsData[i].pData, pipeline->constantsData[i].uDataSize);
+    }
+    if(pipeline->liveConstantBuffer)
+        ceWritePipelineLiveConstants(pipeline, ceGetBufferCpuMemory(pipeline->liveConstantBuffer));
+    CeCpuDispatch dispatch = {
+        .ppBindings = pipeline->cpuBindings,
+        .pBindingElementCounts = pipeline->cpuBindingElementCounts,
+        .pConstants = constants,
+    };
+    if(pipeline->indirectBuffer)
+        memcpy(dispatch.uGroupCount, (const char*)ceGetBufferCpuMemory(pipeline->indirectBuffer) + pipeline->indirectOffset,
+            sizeof(dispatch.uGroupCount));
+    else
+        memcpy(dispatch.uGroupCount, pipeline->dispatchGroupCount, sizeof(dispatch.uGroupCount));
+    ceRunCpuDispatch(cpuBackend, pipeline->cpuKernel, &dispatch);
+    free(constants);
+}
+
+//destroys what was created of the pipeline so far, every step leaves it in a state ceDestroyPipeline handles
+static CeResult __failPipelineCreation(CeInstance instance, CePipeline* pipeline, CeResult result, const char* message) {
+    ceDestroyPipeline(instance, *pipeline);
+    *pipeline = NULL;
+    return ceResult(result, message);
+}
+
+CeResult ceCreatePipelineUntuned(CeInstance instance, const CePipelineCreationArgs * args, CePipeline * pipeline) {
 #define ALIAS (*pipeline)
     if(!instance || !args || !pipeline)
         return ceResult(CE_ERROR_NULL_PASSED, "cannot create pipeline: some parameters were NULL");
+    for(uint32_t i = 0; i < args->uBindingCount; ++i) {
+        if(!args->pBindings[i].pSuppliedBuffer && args->pBindings[i].bKeepMapped && args->pBindings[i].ePlacement == CE_BINDING_PLACEMENT_DEVICE_LOCAL)
+            return ceResult(CE_ERROR_INVALID_ARG, "cannot create pipeline: device-local bindings cannot be kept mapped");
+    }
+    for(uint32_t i = 0; i < args->uSpecializationConstantCount; ++i) {
+        if(!args->pSpecializationConstants[i].pData || !args->pSpecializationConstants[i].uDataSize)
+            return ceResult(CE_ERROR_INVALID_ARG, "cannot create pipeline: specialization constants need data");
+    }
+    if(args->pIndirectBuffer && (args->uIndirectOffset % sizeof(uint32_t) ||
+        args->uIndirectOffset + 3 * sizeof(uint32_t) > ceGetBufferSize(args->pIndirectBuffer)))
+        return ceResult(CE_ERROR_INVALID_ARG, "cannot create pipeline: the indirect offset is not 4 byte aligned or its counts go past the buffer's end");
         
     ALIAS = calloc(1, sizeof(struct CePipeline_t));
+    if(!ALIAS)
+        return ceResult(CE_ERROR_INTERNAL, "stdlib failed to allocate a pipeline");
     ALIAS->bufferCount = args->uBindingCount;
-    ALIAS->dispatchGroupCount = args->uDispatchGroupCount;
-
-    VkSemaphoreCreateInfo semInfo = {
-        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO
-    };
-    if(__createVkBuffersFromBindings(instance, args, ALIAS))
-        return ceResult(CE_ERROR_INTERNAL, "failed to create Vk buffers");
-    if(__createVkShaderModule(instance, ALIAS, args))
-        return ceResult(CE_ERROR_INTERNAL, "failed to create Vk shader module");
-    if(__createVkDescriptorPool(instance, ALIAS))
-        return ceResult(CE_ERROR_INTERNAL, "failed to create Vk descriptor pool");
+    ALIAS->dispatchGroupCount[0] = args->uDispatchGroupCount;
+    ALIAS->dispatchGroupCount[1] = args->uDispatchGroupCountY ? args->uDispatchGroupCountY : 1;
+    ALIAS->dispatchGroupCount[2] = args->uDispatchGroupCountZ ? args->uDispatchGroupCountZ : 1;
+    ALIAS->indirectBuffer = args->pIndirectBuffer;
+    ALIAS->indirectOffset = args->uIndirectOffset;
+    for(uint32_t i = 0; i < 3; ++i)
+        ALIAS->maxDispatchGroupCount[i] = ceGetInstanceVulkanDeviceProperties(instance)->limits.maxComputeWorkGroupCount[i];
+
+    const uint64_t createBegin = ceTraceBegin();
+    //the live constant buffer is created along with the bindings' buffers
+    __storeConstants(args, ALIAS);
+    uint64_t traceBegin = ceTraceBegin();
+    if(__createBuffersFromBindings(instance, args, ALIAS))
+        return __failPipelineCreation(instance, pipeline, CE_ERROR_INTERNAL, "failed to create Vk buffers");
+    ceTraceEnd("binding allocation", traceBegin);
+    if(ceGetInstanceCpuBackend(instance)) {
+        if(__createCpuPipeline(instance, args, ALIAS))
+            return __failPipelineCreation(instance, pipeline, CE_ERROR_INVALID_ARG, "cannot create pipeline: no CPU kernel was registered for its shader");
+        ceTraceEnd("ceCreatePipeline", createBegin);
+        return CE_SUCCESS;
+    }
+    traceBegin = ceTraceBegin();
+    if(ceAcquirePipelineShaderModule(instance, args, &ALIAS->vulkanShader))
+        return __failPipelineCreation(instance, pipeline, CE_ERROR_INTERNAL, "failed to create Vk shader module");
+    ceTraceEnd("shader load", traceBegin);
+    if(__createVkDescriptorPool(instance, ALIAS, &ALIAS->vulkanDescriptorPool))
+        return __failPipelineCreation(instance, pipeline, CE_ERROR_INTERNAL, "failed to create Vk descriptor pool");
     if(__createVkDescriptorSetLayout(instance, ALIAS, args))
-        return ceResult(CE_ERROR_INTERNAL, "failed to create Vk descriptor set layout");
+        return __failPipelineCreation(instance, pipeline, CE_ERROR_INTERNAL, "failed to create Vk descriptor set layout");
     if(__createVkDescriptorSet(instance, args, ALIAS))
-        return ceResult(CE_ERROR_INTERNAL, "failed to create Vk descriptor set");
-    if(__createVkPipelineLayoutAndCache(instance, args, ALIAS))
-        return ceResult(CE_ERROR_INTERNAL, "failed to create Vk pipeline layout and cache");
-    if(__createVkPipeline(instance, ALIAS))
-        return ceResult(CE_ERROR_INTERNAL, "failed to create Vk pipeline");
+        return __failPipelineCreation(instance, pipeline, CE_ERROR_INTERNAL, "failed to create Vk descriptor set");
+    if(__createVkPipelineLayout(instance, ALIAS))
+        return __failPipelineCreation(instance, pipeline, CE_ERROR_INTERNAL, "failed to create Vk pipeline layout, the push constants may exceed the device's limit");
+    traceBegin = ceTraceBegin();
+    if(__createVkPipeline(instance, args, ALIAS))
+        return __failPipelineCreation(instance, pipeline, CE_ERROR_INTERNAL, "failed to create Vk pipeline");
+    ceTraceEnd("vkCreateComputePipelines", traceBegin);
     if(!args->bIsPriorityPipeline)
         if(__createCommandBuffer(instance, args, ALIAS))
-            return ceResult(CE_ERROR_INTERNAL, "failed to create Vk command buffer for a Ce Pipeline");
+            return __failPipelineCreation(instance, pipeline, CE_ERROR_INTERNAL, "failed to create Vk command buffer for a Ce Pipeline");
+    ceTraceEnd("ceCreatePipeline", createBegin);
     return CE_SUCCESS;
 #undef ALIAS
 }
 
+CeResult ceCreatePipeline(CeInstance instance, const CePipelineCreationArgs * args, CePipeline * pipeline) {
+    if(!instance || !args || !pipeline)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot create pipeline: some parameters were NULL");
+    //autotuned values are found by the hash of the SPIR-V, which CPU instances never load
+    if(ceGetInstanceCpuBackend(instance))
+        return ceCreatePipelineUntuned(instance, args, pipeline);
+    //the shader has to be loaded to be recognized, the reference taken here keeps it loaded for the creation
+    CeShaderCache shaderCache = ceGetInstanceShaderCache(instance);
+    VkShaderModule shader;
+    if(ceAcquirePipelineShaderModule(instance, args, &shader) != VK_SUCCESS)
+        return ceCreatePipelineUntuned(instance, args, pipeline);
+    struct CeAutotuneEntry entry;
+    CeResult result;
+    if(ceFindAutotuneEntry(ceGetInstanceAutotuneDatabase(instance), ceGetInstanceDeviceUUID(instance),
+        ceGetInstanceVulkanDeviceProperties(instance)->driverVersion, ceGetShaderModuleHash(shaderCache, shader), &entry)) {
+        struct CeTunedPipelineArgs tuned;
+        ceApplyAutotuneParameters(args, entry.parameters, entry.parameterCount, &tuned);
+        result = ceCreatePipelineUntuned(instance, &tuned.args, pipeline);
+        ceFreeTunedPipelineArgs(&tuned);
+    } else {
+        result = ceCreatePipelineUntuned(instance, args, pipeline);
+    }
+    ceReleaseShaderModule(instance, shaderCache, shader);
+    return result;
+}
+
 void ceDestroyPipeline(CeInstance instance, CePipeline pipeline) {
-    for(uint32_t i = 0; i < pipeline->bufferCount; ++i) {
-        if(pipeline->buffersMappedData[i])
-            vkUnmapMemory(ceGetInstanceVulkanDevice(instance), pipeline->vulkanBufferMemory[i]);
-        vkFreeMemory(ceGetInstanceVulkanDevice(instance), pipeline->vulkanBufferMemory[i], NULL);
-        vkDestroyBuffer(ceGetInstanceVulkanDevice(instance), pipeline->vulkanBuffers[i], NULL);
+    if(!pipeline)
+        return;
+    for(uint32_t i = 0; pipeline->ownsBindingBuffers && i < pipeline->bufferCount; ++i) {
+        if(pipeline->ownsBindingBuffers[i])
+            ceDestroyBuffer(instance, pipeline->bindingBuffers[i]);
     }
-    for(uint32_t i = 0; i < pipeline->constantCount; ++i) {
+    for(uint32_t i = 0; pipeline->constantsData && i < pipeline->constantCount; ++i) {
         if(!pipeline->constantsData[i].bIsLiveConstant)
             free(pipeline->constantsData[i].pData);
     }
-    free(pipeline->buffersMappedData);
     free(pipeline->constantsData);
     free(pipeline->constantOffsets);
-    free(pipeline->vulkanBuffers);
-    free(pipeline->vulkanBufferMemory);
-    free(pipeline->vulkanBufferMemorySize);
-    vkFreeDescriptorSets(ceGetInstanceVulkanDevice(instance), pipeline->vulkanDescriptorPool, 1, &pipeline->vulkanDescriptorSet);
+    free(pipeline->bindingBuffers);
+    free(pipeline->ownsBindingBuffers);
+    free(pipeline->bindingAccesses);
+    if(pipeline->liveConstantBuffer)
+        ceDestroyBuffer(instance, pipeline->liveConstantBuffer);
+    if(ceGetInstanceCpuBackend(instance)) {
+        free(pipeline->cpuBindings);
+        free(pipeline->cpuBindingElementCounts);
+        free(pipeline);
+        return;
+    }
+    if(pipeline->vulkanDescriptorSet)
+        vkFreeDescriptorSets(ceGetInstanceVulkanDevice(instance), pipeline->vulkanDescriptorPool, 1, &pipeline->vulkanDescriptorSet);
     vkDestroyDescriptorSetLayout(ceGetInstanceVulkanDevice(instance), pipeline->vulkanDescriptorSetLayout, NULL);
     vkDestroyDescriptorPool(ceGetInstanceVulkanDevice(instance), pipeline->vulkanDescriptorPool, NULL);
     vkDestroyPipelineLayout(ceGetInstanceVulkanDevice(instance), pipeline->vulkanPipelineLayout, NULL);
-    vkDestroyPipelineCache(ceGetInstanceVulkanDevice(instance), pipeline->vulkanPipelineCache, NULL);
-    vkDestroyShaderModule(ceGetInstanceVulkanDevice(instance), pipeline->vulkanShader, NULL);
+    if(pipeline->vulkanShader)
+        ceReleaseShaderModule(instance, ceGetInstanceShaderCache(instance), pipeline->vulkanShader);
     vkDestroyPipeline(ceGetInstanceVulkanDevice(instance), pipeline->vulkanFinishedPipeline, NULL);
+    ceFreeCommandBuffer(instance, pipeline->pipelineCommandPool, pipeline->pipelineCommandBuffer);
     free(pipeline);
 }
\ No newline at end of file
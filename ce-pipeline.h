@@ -10,6 +10,13 @@ typedef struct {
     CeBool32 bIsUniform;
     void* pInitialData;
     CeBool32 bKeepMapped;
+    CeBindingPlacement ePlacement;
+    //if not NULL the binding's buffer is this host memory, as the pHostMemory of CeBufferCreationArgs
+    void* pHostMemory;
+    //if not NULL the binding uses this buffer and ignores the element size, count, initial data, mapping and placement
+    CeBuffer pSuppliedBuffer;
+    //how the shader uses the binding, graphs only place barriers between pipelines whose accesses conflict
+    CeBindingAccess eAccess;
 } CePipelineBindingInfo;
 
 typedef struct {
@@ -18,13 +25,34 @@ typedef struct {
     CeBool32 bIsLiveConstant;
 } CePipelineConstantInfo;
 
+//a value for the shader's layout(constant_id = uConstantId) constant, folded in when the pipeline is compiled
+typedef struct {
+    uint32_t uConstantId;
+    const void* pData;
+    uint32_t uDataSize;
+} CePipelineSpecializationInfo;
+
 typedef struct {
     const char* pShaderFilename;
+    //SPIR-V in memory used instead of pShaderFilename when it is not NULL, uShaderCodeSize is in bytes
+    const uint32_t* pShaderCode;
+    uint64_t uShaderCodeSize;
     CePipelineBindingInfo *pBindings;
     uint32_t uBindingCount;
     CePipelineConstantInfo *pConstants;
     uint32_t uConstantCount;
+    CePipelineSpecializationInfo *pSpecializationConstants;
+    uint32_t uSpecializationConstantCount;
+    //work groups along x, if 0 the pipeline's longest binding's element count is used
     uint32_t uDispatchGroupCount;
+    //work groups along y and z, 0 is the same as 1
+    uint32_t uDispatchGroupCountY;
+    uint32_t uDispatchGroupCountZ;
+    //if not NULL the work group counts are read from this buffer each time the pipeline runs, and the counts above are ignored.
+    //it holds 3 uint32_t for x, y and z at uIndirectOffset, which an earlier pipeline can write, see "Indirect dispatch"
+    CeBuffer pIndirectBuffer;
+    //in bytes, a multiple of 4
+    uint64_t uIndirectOffset;
     CeBool32 bIsPriorityPipeline;
 } CePipelineCreationArgs;
 
@@ -37,6 +65,14 @@ ceMapPipelineBindingMemory(CeInstance, CePipeline, uint32_t bindingIndex, void**
 void
 ceUnmapPipelineBindingMemory(CeInstance, CePipeline, uint32_t bindingIndex);
 
+//the buffer behind a binding, to pass it to functions taking a CeBuffer. it still belongs to the pipeline unless it was supplied
+CeResult
+ceGetPipelineBindingBufferHandle(CePipeline, uint32_t bindingIndex, CeBuffer*);
+
+//ceSyncBufferHostMemory for the buffer of a binding created with pHostMemory
+CeResult
+ceSyncPipelineBindingHostMemory(CeInstance, CePipeline, uint32_t bindingIndex, CeBool32 bToDevice);
+
 CeResult 
 ceGetPipelineBindingMemory(CePipeline, uint32_t bindingIndex, void**);
 
@@ -0,0 +1,58 @@
+#pragma once
+#include "ce-def.h"
+#include "ce-primitives.h"
+
+//CE_TILE_SIZE in shaders/primitives.glsl, the elements a work group of the built-in kernels handles
+#define CE_PRIMITIVE_TILE_SIZE 1024
+//specialization constants 0 and 1 are the type and operation of shaders/primitives.glsl, the others belong to each kernel
+#define CE_PRIMITIVE_SPECIALIZATION_COUNT 6
+
+//a built-in kernel, and its variant using subgroup arithmetic if it has one
+struct CePrimitiveKernel {
+    const uint32_t* code;
+    uint64_t codeSize;
+    const uint32_t* subgroupCode;
+    uint64_t subgroupCodeSize;
+};
+
+/*
+* The pipelines of a chain of built-in kernels and the scratch buffers between them.
+* Created once, they can be recorded to any number of commands, with a barrier before each pass.
+*/
+struct CePrimitivePasses {
+    CeInstance instance;
+    //the values of specialization constants 0 to CE_PRIMITIVE_SPECIALIZATION_COUNT - 1 of the passes added next
+    uint32_t specialization[CE_PRIMITIVE_SPECIALIZATION_COUNT];
+    CePipeline* pipelines;
+    uint32_t pipelineCount;
+    uint32_t pipelineCapacity;
+    CeBuffer* scratchBuffers;
+    uint32_t scratchBufferCount;
+    uint32_t scratchBufferCapacity;
+};
+
+uint32_t
+ceGetPrimitiveTileCount(uint32_t elementCount);
+
+void
+ceInitPrimitivePasses(CeInstance, struct CePrimitivePasses*);
+
+//a device-local buffer which lives as long as the passes
+CeResult
+ceCreatePrimitiveScratchBuffer(struct CePrimitivePasses*, uint32_t elementCount, uint32_t elementSize, CeBuffer*);
+
+//binds buffers in order and pushes 4 byte constants in order, the kernel's dispatch base follows them
+CeResult
+ceAddPrimitivePass(struct CePrimitivePasses*, const struct CePrimitiveKernel*, const CeBuffer* pBuffers, uint32_t bufferCount,
+    uint32_t* pConstants, uint32_t constantCount, uint32_t groupCount);
+
+//the passes of ceScanBuffer with the current type and operation, countNonZero scans 1 for every non-zero element instead
+CeResult
+ceAddPrimitiveScan(struct CePrimitivePasses*, CeBuffer input, CeBuffer output, uint32_t elementCount, CeBool32 countNonZero, CeBool32 inclusive);
+
+//records every pass, with a barrier before each of them and one after the last
+CeResult
+ceRecordPrimitivePasses(struct CePrimitivePasses*, CeCommand);
+
+void
+ceDestroyPrimitivePasses(struct CePrimitivePasses*);
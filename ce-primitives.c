@@ -0,0 +1,458 @@
+#include "ce-primitives.h"
+#include "ce-def.h"
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan_core.h>
+#include <stdlib.h>
+#include "ce-buffer.h"
+#include "ce-command.h"
+#include "ce-pipeline.h"
+#include "ce-transfer.h"
+#include "ce-primitives-internal.h"
+#include "ce-buffer-internal.h"
+#include "ce-command-internal.h"
+#include "ce-instance-internal.h"
+#include "ce-error-internal.h"
+#include "ce-trace-internal.h"
+
+//the kernels in shaders/, compiled to C initializers by glslc -mfmt=c
+static const uint32_t reduceCode[] =
+#include "shaders/reduce.spv.inc"
+;
+static const uint32_t reduceSubgroupCode[] =
+#include "shaders/reduce-subgroup.spv.inc"
+;
+static const uint32_t scanCode[] =
+#include "shaders/scan.spv.inc"
+;
+static const uint32_t scanSubgroupCode[] =
+#include "shaders/scan-subgroup.spv.inc"
+;
+static const uint32_t compactCode[] =
+#include "shaders/compact.spv.inc"
+;
+
+static const struct CePrimitiveKernel reduceKernel = {
+    reduceCode, sizeof(reduceCode), reduceSubgroupCode, sizeof(reduceSubgroupCode),
+};
+static const struct CePrimitiveKernel scanKernel = {
+    scanCode, sizeof(scanCode), scanSubgroupCode, sizeof(scanSubgroupCode),
+};
+static const struct CePrimitiveKernel compactKernel = {
+    compactCode, sizeof(compactCode), NULL, 0,
+};
+
+uint32_t
+ceGetPrimitiveTileCount(uint32_t elementCount) {
+    //an empty input still gets a tile, which writes the identity
+    return elementCount ? (uint32_t)(((uint64_t)elementCount + CE_PRIMITIVE_TILE_SIZE - 1) / CE_PRIMITIVE_TILE_SIZE) : 1;
+}
+
+void
+ceInitPrimitivePasses(CeInstance instance, struct CePrimitivePasses* passes) {
+    *passes = (struct CePrimitivePasses){
+        .instance = instance,
+    };
+}
+
+CeResult
+ceCreatePrimitiveScratchBuffer(struct CePrimitivePasses* passes, uint32_t elementCount, uint32_t elementSize, CeBuffer* buffer) {
+    CeBufferCreationArgs bufferArgs = {
+        .uElementSize = elementSize,
+        .uElementCount = elementCount,
+        .ePlacement = CE_BINDING_PLACEMENT_DEVICE_LOCAL,
+    };
+    CeResult result = ceCreateBuffer(passes->instance, &bufferArgs, buffer);
+    if(result != CE_SUCCESS)
+        return result;
+    if(passes->scratchBufferCount == passes->scratchBufferCapacity) {
+        passes->scratchBufferCapacity = passes->scratchBufferCapacity ? passes->scratchBufferCapacity * 2 : 8;
+        passes->scratchBuffers = realloc(passes->scratchBuffers, passes->scratchBufferCapacity * sizeof(CeBuffer));
+    }
+    passes->scratchBuffers[passes->scratchBufferCount++] = *buffer;
+    return CE_SUCCESS;
+}
+
+CeResult
+ceAddPrimitivePass(struct CePrimitivePasses* passes, const struct CePrimitiveKernel* kernel, const CeBuffer* buffers, uint32_t bufferCount,
+    uint32_t* constants, uint32_t constantCount, uint32_t groupCount) {
+    //the subgroup variants are SPIR-V 1.3, they are only picked on devices which run them
+    const CeBool32 useSubgroups = kernel->subgroupCode && ceGetInstanceSubgroupArithmeticSupported(passes->instance);
+    CePipelineBindingInfo* bindings = calloc(bufferCount, sizeof(CePipelineBindingInfo));
+    for(uint32_t i = 0; i < bufferCount; ++i)
+        bindings[i].pSuppliedBuffer = buffers[i];
+    CePipelineConstantInfo* constantInfos = calloc(constantCount ? constantCount : 1, sizeof(CePipelineConstantInfo));
+    for(uint32_t i = 0; i < constantCount; ++i)
+        constantInfos[i] = (CePipelineConstantInfo){ .pData = &constants[i], .uDataSize = sizeof(uint32_t) };
+    //constants a kernel does not declare are ignored
+    CePipelineSpecializationInfo specializationConstants[CE_PRIMITIVE_SPECIALIZATION_COUNT];
+    for(uint32_t i = 0; i < CE_PRIMITIVE_SPECIALIZATION_COUNT; ++i) {
+        specializationConstants[i] = (CePipelineSpecializationInfo){
+            .uConstantId = i,
+            .pData = &passes->specialization[i],
+            .uDataSize = sizeof(uint32_t),
+        };
+    }
+    CePipelineCreationArgs pipelineArgs = {
+        .pShaderCode = useSubgroups ? kernel->subgroupCode : kernel->code,
+        .uShaderCodeSize = useSubgroups ? kernel->subgroupCodeSize : kernel->codeSize,
+        .pBindings = bindings,
+        .uBindingCount = bufferCount,
+        .pConstants = constantInfos,
+        .uConstantCount = constantCount,
+        .pSpecializationConstants = specializationConstants,
+        .uSpecializationConstantCount = CE_PRIMITIVE_SPECIALIZATION_COUNT,
+        .uDispatchGroupCount = groupCount,
+    };
+    CePipeline pipeline;
+    CeResult result = ceCreatePipeline(passes->instance, &pipelineArgs, &pipeline);
+    free(bindings);
+    free(constantInfos);
+    if(result != CE_SUCCESS)
+        return result;
+    if(passes->pipelineCount == passes->pipelineCapacity) {
+        passes->pipelineCapacity = passes->pipelineCapacity ? passes->pipelineCapacity * 2 : 16;
+        passes->pipelines = realloc(passes->pipelines, passes->pipelineCapacity * sizeof(CePipeline));
+    }
+    passes->pipelines[passes->pipelineCount++] = pipeline;
+    return CE_SUCCESS;
+}
+
+//scans tile by tile, after scanning the reductions of the tiles into the offset each of them starts from
+CeResult
+ceAddPrimitiveScan(struct CePrimitivePasses* passes, CeBuffer input, CeBuffer output, uint32_t elementCount,
+    CeBool32 countNonZero, CeBool32 inclusive) {
+    const uint32_t tileCount = ceGetPrimitiveTileCount(elementCount);
+    CeBuffer tileOffsets = input;
+    CeResult result;
+    if(tileCount > 1) {
+        if((result = ceCreatePrimitiveScratchBuffer(passes, tileCount, sizeof(uint32_t), &tileOffsets)) != CE_SUCCESS)
+            return result;
+        CeBuffer reduceBuffers[2] = {input, tileOffsets};
+        uint32_t reduceConstants[2] = {elementCount, countNonZero ? 1 : 0};
+        if((result = ceAddPrimitivePass(passes, &reduceKernel, reduceBuffers, 2, reduceConstants, 2, tileCount)) != CE_SUCCESS)
+            return result;
+        if((result = ceAddPrimitiveScan(passes, tileOffsets, tileOffsets, tileCount, CE_FALSE, CE_FALSE)) != CE_SUCCESS)
+            return result;
+    }
+    CeBuffer scanBuffers[3] = {input, output, tileOffsets};
+    uint32_t scanConstants[4] = {elementCount, countNonZero ? 1 : 0, inclusive ? 1 : 0, tileCount > 1 ? 1 : 0};
+    return ceAddPrimitivePass(passes, &scanKernel, scanBuffers, 3, scanConstants, 4, tileCount);
+}
+
+CeResult
+ceRecordPrimitivePasses(struct CePrimitivePasses* passes, CeCommand command) {
+    //every pass reads what the one before it wrote, the first one what was recorded before it
+    for(uint32_t i = 0; i < passes->pipelineCount; ++i) {
+        ceRecordCommandBarrier(command, CE_TRUE, NULL, 0);
+        CeCommandRecordingArgs recordingArgs = {
+            .bRecordCommand = CE_FALSE,
+            .pSuppliedPipeline = passes->pipelines[i],
+        };
+        CeResult result = ceRecordToCommand(&recordingArgs, command);
+        if(result != CE_SUCCESS)
+            return result;
+    }
+    ceRecordCommandBarrier(command, CE_TRUE, NULL, 0);
+    return CE_SUCCESS;
+}
+
+void
+ceDestroyPrimitivePasses(struct CePrimitivePasses* passes) {
+    for(uint32_t i = 0; i < passes->pipelineCount; ++i)
+        ceDestroyPipeline(passes->instance, passes->pipelines[i]);
+    for(uint32_t i = 0; i < passes->scratchBufferCount; ++i)
+        ceDestroyBuffer(passes->instance, passes->scratchBuffers[i]);
+    free(passes->pipelines);
+    free(passes->scratchBuffers);
+    *passes = (struct CePrimitivePasses){0};
+}
+
+static CeBool32 __hasWordElements(CeBuffer buffer) {
+    return ceGetBufferSize(buffer) == (VkDeviceSize)ceGetBufferElementCount(buffer) * sizeof(uint32_t);
+}
+
+static CeBool32 __isValidOperation(CePrimitiveType type, CePrimitiveOperation operation) {
+    return type <= CE_PRIMITIVE_TYPE_FLOAT32 && operation <= CE_PRIMITIVE_OPERATION_MAX;
+}
+
+//runs the passes straight away, on a command of their own
+static CeResult __runPasses(struct CePrimitivePasses* passes) {
+    CeCommandCreationArgs commandArgs = {
+        .bIsSecondaryCommand = CE_FALSE,
+    };
+    CeCommand command;
+    CeResult result = ceCreateCommand(passes->instance, &commandArgs, &command);
+    if(result != CE_SUCCESS)
+        return result;
+    result = ceBeginCommand(command);
+    if(result == CE_SUCCESS)
+        result = ceRecordPrimitivePasses(passes, command);
+    if(result == CE_SUCCESS)
+        result = ceEndCommand(command);
+    if(result == CE_SUCCESS)
+        result = ceRunCommand(passes->instance, command);
+    if(result == CE_SUCCESS)
+        result = ceWaitCommand(passes->instance, command);
+    ceDestroyCommand(passes->instance, command);
+    return result;
+}
+
+static CeResult __readElement(CeInstance instance, CeBuffer buffer, uint32_t index, uint32_t* value) {
+    CeTransfer transfer;
+    CeResult result = ceDownloadBufferAsync(instance, buffer, (uint64_t)index * sizeof(uint32_t), value, sizeof(uint32_t), NULL, &transfer);
+    if(result != CE_SUCCESS)
+        return result;
+    result = ceWaitTransfer(instance, transfer);
+    ceDestroyTransfer(instance, transfer);
+    return result;
+}
+
+struct CeReduce_t {
+    struct CePrimitivePasses passes;
+    //pOutput, or the last level of the reduce
+    CeBuffer result;
+};
+
+struct CeScan_t {
+    struct CePrimitivePasses passes;
+};
+
+struct CeCompact_t {
+    struct CePrimitivePasses passes;
+    CeBuffer flags;
+    CeBuffer positions;
+    uint32_t elementCount;
+};
+
+//each level reduces the tiles of the one before it, until a single tile is left
+static CeResult __addReducePasses(CeReduce reduce, const CeReduceCreationArgs* args) {
+    CeBuffer level = args->pInput;
+    uint32_t elementCount = ceGetBufferElementCount(args->pInput);
+    for(;;) {
+        const uint32_t tileCount = ceGetPrimitiveTileCount(elementCount);
+        CeBuffer tileResults = args->pOutput;
+        CeResult result;
+        if((tileCount > 1 || !tileResults) &&
+            (result = ceCreatePrimitiveScratchBuffer(&reduce->passes, tileCount, sizeof(uint32_t), &tileResults)) != CE_SUCCESS)
+            return result;
+        CeBuffer buffers[2] = {level, tileResults};
+        uint32_t constants[2] = {elementCount, 0};
+        if((result = ceAddPrimitivePass(&reduce->passes, &reduceKernel, buffers, 2, constants, 2, tileCount)) != CE_SUCCESS)
+            return result;
+        if(tileCount == 1) {
+            reduce->result = tileResults;
+            return CE_SUCCESS;
+        }
+        level = tileResults;
+        elementCount = tileCount;
+    }
+}
+
+CeResult
+ceCreateReduce(CeInstance instance, const CeReduceCreationArgs* args, CeReduce* reduce) {
+    if(!instance || !args || !args->pInput || !reduce)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot create reduce: some parameters were NULL");
+    if(!__isValidOperation(args->eType, args->eOperation) || !__hasWordElements(args->pInput) ||
+        (args->pOutput && (!__hasWordElements(args->pOutput) || !ceGetBufferElementCount(args->pOutput))))
+        return ceResult(CE_ERROR_INVALID_ARG, "cannot create reduce: it needs a valid type and operation, and 4 byte elements");
+    *reduce = calloc(1, sizeof(struct CeReduce_t));
+    ceInitPrimitivePasses(instance, &(*reduce)->passes);
+    (*reduce)->passes.specialization[0] = args->eType;
+    (*reduce)->passes.specialization[1] = args->eOperation;
+    CeResult result = __addReducePasses(*reduce, args);
+    if(result != CE_SUCCESS) {
+        ceDestroyReduce(instance, *reduce);
+        *reduce = NULL;
+    }
+    return result;
+}
+
+CeResult
+ceRecordReduceToCommand(CeReduce reduce, CeCommand command) {
+    if(!reduce || !command)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot record reduce: some parameters were NULL");
+    return ceRecordPrimitivePasses(&reduce->passes, command);
+}
+
+CeBuffer
+ceGetReduceResultBuffer(CeReduce reduce) {
+    return reduce ? reduce->result : NULL;
+}
+
+void
+ceDestroyReduce(CeInstance instance, CeReduce reduce) {
+    if(!reduce)
+        return;
+    ceDestroyPrimitivePasses(&reduce->passes);
+    free(reduce);
+}
+
+CeResult
+ceCreateScan(CeInstance instance, const CeScanCreationArgs* args, CeScan* scan) {
+    if(!instance || !args || !args->pInput || !args->pOutput || !scan)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot create scan: some parameters were NULL");
+    if(!__isValidOperation(args->eType, args->eOperation) || !__hasWordElements(args->pInput) || !__hasWordElements(args->pOutput))
+        return ceResult(CE_ERROR_INVALID_ARG, "cannot create scan: it needs a valid type and operation, and 4 byte elements");
+    if(ceGetBufferElementCount(args->pOutput) < ceGetBufferElementCount(args->pInput))
+        return ceResult(CE_ERROR_INVALID_ARG, "cannot create scan: the output is smaller than the input");
+    *scan = calloc(1, sizeof(struct CeScan_t));
+    ceInitPrimitivePasses(instance, &(*scan)->passes);
+    (*scan)->passes.specialization[0] = args->eType;
+    (*scan)->passes.specialization[1] = args->eOperation;
+    CeResult result = ceAddPrimitiveScan(&(*scan)->passes, args->pInput, args->pOutput, ceGetBufferElementCount(args->pInput),
+        CE_FALSE, args->bInclusive);
+    if(result != CE_SUCCESS) {
+        ceDestroyScan(instance, *scan);
+        *scan = NULL;
+    }
+    return result;
+}
+
+CeResult
+ceRecordScanToCommand(CeScan scan, CeCommand command) {
+    if(!scan || !command)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot record scan: some parameters were NULL");
+    return ceRecordPrimitivePasses(&scan->passes, command);
+}
+
+void
+ceDestroyScan(CeInstance instance, CeScan scan) {
+    if(!scan)
+        return;
+    ceDestroyPrimitivePasses(&scan->passes);
+    free(scan);
+}
+
+//the position of each kept element is the number of kept elements before it, an unsigned sum
+static CeResult __addCompactPasses(CeCompact compact, const CeCompactCreationArgs* args) {
+    CeResult result = ceCreatePrimitiveScratchBuffer(&compact->passes, compact->elementCount, sizeof(uint32_t), &compact->positions);
+    if(result != CE_SUCCESS)
+        return result;
+    if((result = ceAddPrimitiveScan(&compact->passes, args->pFlags, compact->positions, compact->elementCount, CE_TRUE, CE_FALSE)) != CE_SUCCESS)
+        return result;
+    CeBuffer buffers[4] = {args->pInput, args->pFlags, compact->positions, args->pOutput};
+    uint32_t constants[2] = {compact->elementCount, ceGetBufferElementCount(args->pOutput)};
+    return ceAddPrimitivePass(&compact->passes, &compactKernel, buffers, 4, constants, 2, ceGetPrimitiveTileCount(compact->elementCount));
+}
+
+CeResult
+ceCreateCompact(CeInstance instance, const CeCompactCreationArgs* args, CeCompact* compact) {
+    if(!instance || !args || !args->pInput || !args->pFlags || !args->pOutput || !compact)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot create compaction: some parameters were NULL");
+    const uint32_t elementCount = ceGetBufferElementCount(args->pInput);
+    if(!__hasWordElements(args->pInput) || !__hasWordElements(args->pFlags) || !__hasWordElements(args->pOutput) ||
+        ceGetBufferElementCount(args->pFlags) < elementCount)
+        return ceResult(CE_ERROR_INVALID_ARG, "cannot create compaction: it needs 4 byte elements and a flag for each of them");
+    *compact = calloc(1, sizeof(struct CeCompact_t));
+    ceInitPrimitivePasses(instance, &(*compact)->passes);
+    (*compact)->flags = args->pFlags;
+    (*compact)->elementCount = elementCount;
+    //an empty input has nothing to record
+    CeResult result = elementCount ? __addCompactPasses(*compact, args) : CE_SUCCESS;
+    if(result != CE_SUCCESS) {
+        ceDestroyCompact(instance, *compact);
+        *compact = NULL;
+    }
+    return result;
+}
+
+CeResult
+ceRecordCompactToCommand(CeCompact compact, CeCommand command) {
+    if(!compact || !command)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot record compaction: some parameters were NULL");
+    return ceRecordPrimitivePasses(&compact->passes, command);
+}
+
+CeResult
+ceGetCompactKeptCount(CeInstance instance, CeCompact compact, uint32_t* pKeptCount) {
+    if(!instance || !compact || !pKeptCount)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot get compaction kept count: some parameters were NULL");
+    if(!compact->elementCount) {
+        *pKeptCount = 0;
+        return CE_SUCCESS;
+    }
+    //the last element's position, plus the element itself if it was kept
+    uint32_t lastPosition, lastFlag;
+    CeResult result = __readElement(instance, compact->positions, compact->elementCount - 1, &lastPosition);
+    if(result == CE_SUCCESS)
+        result = __readElement(instance, compact->flags, compact->elementCount - 1, &lastFlag);
+    if(result == CE_SUCCESS)
+        *pKeptCount = lastPosition + (lastFlag ? 1 : 0);
+    return result;
+}
+
+void
+ceDestroyCompact(CeInstance instance, CeCompact compact) {
+    if(!compact)
+        return;
+    ceDestroyPrimitivePasses(&compact->passes);
+    free(compact);
+}
+
+//the functions below create the objects above, run them once on a command of their own and destroy them
+CeResult
+ceReduceBuffer(CeInstance instance, CeBuffer input, CePrimitiveType type, CePrimitiveOperation operation, void* pResult) {
+    if(!instance || !input || !pResult)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot reduce buffer: some parameters were NULL");
+    uint64_t traceBegin = ceTraceBegin();
+    CeReduceCreationArgs reduceArgs = {
+        .pInput = input,
+        .eType = type,
+        .eOperation = operation,
+    };
+    CeReduce reduce;
+    CeResult result = ceCreateReduce(instance, &reduceArgs, &reduce);
+    if(result != CE_SUCCESS)
+        return result;
+    result = __runPasses(&reduce->passes);
+    if(result == CE_SUCCESS)
+        result = __readElement(instance, reduce->result, 0, pResult);
+    ceDestroyReduce(instance, reduce);
+    ceTraceEnd("ceReduceBuffer", traceBegin);
+    return result;
+}
+
+CeResult
+ceScanBuffer(CeInstance instance, CeBuffer input, CeBuffer output, CePrimitiveType type, CePrimitiveOperation operation, CeBool32 bInclusive) {
+    if(!instance || !input || !output)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot scan buffer: some parameters were NULL");
+    uint64_t traceBegin = ceTraceBegin();
+    CeScanCreationArgs scanArgs = {
+        .pInput = input,
+        .pOutput = output,
+        .eType = type,
+        .eOperation = operation,
+        .bInclusive = bInclusive,
+    };
+    CeScan scan;
+    CeResult result = ceCreateScan(instance, &scanArgs, &scan);
+    if(result != CE_SUCCESS)
+        return result;
+    result = __runPasses(&scan->passes);
+    ceDestroyScan(instance, scan);
+    ceTraceEnd("ceScanBuffer", traceBegin);
+    return result;
+}
+
+CeResult
+ceCompactBuffer(CeInstance instance, CeBuffer input, CeBuffer flags, CeBuffer output, uint32_t* pKeptCount) {
+    if(!instance || !input || !flags || !output)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot compact buffer: some parameters were NULL");
+    uint64_t traceBegin = ceTraceBegin();
+    CeCompactCreationArgs compactArgs = {
+        .pInput = input,
+        .pFlags = flags,
+        .pOutput = output,
+    };
+    CeCompact compact;
+    CeResult result = ceCreateCompact(instance, &compactArgs, &compact);
+    if(result != CE_SUCCESS)
+        return result;
+    if(compact->elementCount)
+        result = __runPasses(&compact->passes);
+    if(result == CE_SUCCESS && pKeptCount)
+        result = ceGetCompactKeptCount(instance, compact, pKeptCount);
+    ceDestroyCompact(instance, compact);
+    ceTraceEnd("ceCompactBuffer", traceBegin);
+    return result;
+}
@@ -0,0 +1,132 @@
+#pragma once
+#include "ce-def.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//how the 32 bit elements of a buffer are read
+typedef enum {
+    CE_PRIMITIVE_TYPE_UINT32 = 0,
+    CE_PRIMITIVE_TYPE_INT32,
+    CE_PRIMITIVE_TYPE_FLOAT32,
+} CePrimitiveType;
+
+typedef enum {
+    CE_PRIMITIVE_OPERATION_SUM = 0,
+    CE_PRIMITIVE_OPERATION_MIN,
+    CE_PRIMITIVE_OPERATION_MAX,
+} CePrimitiveOperation;
+
+/**
+* Combine every element of a buffer with an operation, and write the result to pResult.
+* The buffer's elements **must** be 4 bytes. Pipeline bindings are passed with ceGetPipelineBindingBufferHandle.
+* Float sums are computed in a different order than a sequential loop, so their last bits may differ from one.
+* \param pResult 4 bytes the result is written to, as a uint32_t, int32_t or float depending on eType
+*/
+CeResult
+ceReduceBuffer(CeInstance instance, CeBuffer input, CePrimitiveType eType, CePrimitiveOperation eOperation, void* pResult);
+
+/**
+* Write the prefix scan of a buffer to another one, or to itself.
+* Element i of the output is the combination of the input's elements before i, and of element i too if bInclusive is set.
+* Both buffers **must** have 4 byte elements, and the output at least as many as the input.
+*/
+CeResult
+ceScanBuffer(CeInstance instance, CeBuffer input, CeBuffer output, CePrimitiveType eType, CePrimitiveOperation eOperation, CeBool32 bInclusive);
+
+/**
+* Copy the elements of a buffer whose flag is not 0 to the start of another buffer, keeping their order.
+* flags holds one uint32_t per element of input, and output **must** be able to hold every kept element.
+* \param pKeptCount if not NULL, the number of elements written to output is written to it
+*/
+CeResult
+ceCompactBuffer(CeInstance instance, CeBuffer input, CeBuffer flags, CeBuffer output, uint32_t* pKeptCount);
+
+typedef struct {
+    //4 byte elements, pipeline bindings are passed with ceGetPipelineBindingBufferHandle
+    CeBuffer pInput;
+    CePrimitiveType eType;
+    CePrimitiveOperation eOperation;
+    //optional, a buffer with 4 byte elements whose first element receives the result.
+    //without it the result goes to a buffer of the reduce's own, see ceGetReduceResultBuffer
+    CeBuffer pOutput;
+} CeReduceCreationArgs;
+
+/**
+* Create a reduce of a buffer, whose passes and scratch buffers are created once and recorded to commands
+* with ceRecordReduceToCommand. The input is read when the command runs, so the command can be run again once it changed.
+* \param instance the instance the reduce runs on
+* \param args pointer to a CeReduceCreationArgs structure
+* \param reduce the handle the function writes to
+*/
+CeResult
+ceCreateReduce(CeInstance instance, const CeReduceCreationArgs* args, CeReduce* reduce);
+
+/**
+* Record the reduce to a command which was begun, between barriers so that it sees what was recorded before it
+* and what is recorded after it sees the result.
+*/
+CeResult
+ceRecordReduceToCommand(CeReduce reduce, CeCommand command);
+
+//the buffer whose first element holds the result once a command the reduce was recorded to completed
+CeBuffer
+ceGetReduceResultBuffer(CeReduce reduce);
+
+void
+ceDestroyReduce(CeInstance instance, CeReduce reduce);
+
+typedef struct {
+    CeBuffer pInput;
+    //at least as many elements as the input, it may be the input itself
+    CeBuffer pOutput;
+    CePrimitiveType eType;
+    CePrimitiveOperation eOperation;
+    CeBool32 bInclusive;
+} CeScanCreationArgs;
+
+/**
+* Create a scan of a buffer, recorded to commands with ceRecordScanToCommand, see ceScanBuffer for what it computes.
+*/
+CeResult
+ceCreateScan(CeInstance instance, const CeScanCreationArgs* args, CeScan* scan);
+
+//records the scan to a command which was begun, between barriers like ceRecordReduceToCommand
+CeResult
+ceRecordScanToCommand(CeScan scan, CeCommand command);
+
+void
+ceDestroyScan(CeInstance instance, CeScan scan);
+
+typedef struct {
+    CeBuffer pInput;
+    //one uint32_t per element of the input, the elements whose flag is not 0 are kept
+    CeBuffer pFlags;
+    //**must** be able to hold every kept element
+    CeBuffer pOutput;
+} CeCompactCreationArgs;
+
+/**
+* Create a compaction of a buffer, recorded to commands with ceRecordCompactToCommand, see ceCompactBuffer for what it computes.
+* Its scratch memory holds the position of each element.
+*/
+CeResult
+ceCreateCompact(CeInstance instance, const CeCompactCreationArgs* args, CeCompact* compact);
+
+//records the compaction to a command which was begun, between barriers like ceRecordReduceToCommand
+CeResult
+ceRecordCompactToCommand(CeCompact compact, CeCommand command);
+
+/**
+* Read back the number of elements the last completed run of a command the compaction was recorded to kept.
+* It waits for the read, so it is best called once the command was waited on.
+*/
+CeResult
+ceGetCompactKeptCount(CeInstance instance, CeCompact compact, uint32_t* pKeptCount);
+
+void
+ceDestroyCompact(CeInstance instance, CeCompact compact);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,33 @@
+#pragma once
+#include "ce-def.h"
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan_core.h>
+
+/*
+* The queue scheduler spreads submissions over every queue of the instance's compute family.
+* Each submission goes to the queue with the fewest submissions in flight, picked without locks;
+* only the vkQueueSubmit call itself is serialized, per queue.
+*/
+typedef struct CeQueueScheduler_t *CeQueueScheduler;
+
+#define CE_NO_QUEUE (~((uint32_t)0))
+
+VkResult
+ceCreateQueueScheduler(CeInstance, uint32_t queueFamilyIndex, uint32_t queueCount, CeQueueScheduler*);
+
+//submits to the least loaded queue and writes its index, which must be released once the submission completed
+VkResult
+ceSchedulerSubmit(CeQueueScheduler, uint32_t submitCount, const VkSubmitInfo*, VkFence, uint32_t* pQueueIndex);
+
+//adds count to the load of a queue, for submissions which are released in several parts
+void
+ceSchedulerHold(CeQueueScheduler, uint32_t queueIndex, uint32_t count);
+
+void
+ceSchedulerRelease(CeQueueScheduler, uint32_t queueIndex);
+
+uint32_t
+ceGetSchedulerQueueCount(CeQueueScheduler);
+
+void
+ceDestroyQueueScheduler(CeInstance, CeQueueScheduler);
@@ -0,0 +1,102 @@
+#include "ce-queue-internal.h"
+#include "ce-def.h"
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan_core.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "ce-instance-internal.h"
+
+struct CeQueueSlot {
+    VkQueue vulkanQueue;
+    //vkQueueSubmit needs the queue to be externally synchronized
+    pthread_mutex_t submitMutex;
+    //submissions made to the queue which were not released yet
+    atomic_uint load;
+};
+
+struct CeQueueScheduler_t {
+    struct CeQueueSlot* slots;
+    uint32_t slotCount;
+    //where the search for the least loaded queue starts, so that ties are spread over every queue
+    atomic_uint rotor;
+};
+
+VkResult
+ceCreateQueueScheduler(CeInstance instance, uint32_t queueFamilyIndex, uint32_t queueCount, CeQueueScheduler* target) {
+    CeQueueScheduler scheduler = calloc(1, sizeof(struct CeQueueScheduler_t));
+    if(!scheduler)
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    scheduler->slots = calloc(queueCount, sizeof(struct CeQueueSlot));
+    if(!scheduler->slots) {
+        free(scheduler);
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+    scheduler->slotCount = queueCount;
+    for(uint32_t i = 0; i < queueCount; ++i) {
+        vkGetDeviceQueue(ceGetInstanceVulkanDevice(instance), queueFamilyIndex, i, &scheduler->slots[i].vulkanQueue);
+        pthread_mutex_init(&scheduler->slots[i].submitMutex, NULL);
+        atomic_init(&scheduler->slots[i].load, 0);
+    }
+    atomic_init(&scheduler->rotor, 0);
+    *target = scheduler;
+    return VK_SUCCESS;
+}
+
+static uint32_t __pickQueue(CeQueueScheduler scheduler) {
+    const uint32_t start = atomic_fetch_add_explicit(&scheduler->rotor, 1, memory_order_relaxed) % scheduler->slotCount;
+    uint32_t best = start;
+    unsigned bestLoad = atomic_load_explicit(&scheduler->slots[start].load, memory_order_relaxed);
+    for(uint32_t i = 1; i < scheduler->slotCount && bestLoad; ++i) {
+        const uint32_t index = (start + i) % scheduler->slotCount;
+        const unsigned load = atomic_load_explicit(&scheduler->slots[index].load, memory_order_relaxed);
+        if(load < bestLoad) {
+            best = index;
+            bestLoad = load;
+        }
+    }
+    return best;
+}
+
+VkResult
+ceSchedulerSubmit(CeQueueScheduler scheduler, uint32_t submitCount, const VkSubmitInfo* pSubmits, VkFence fence, uint32_t* pQueueIndex) {
+    const uint32_t index = __pickQueue(scheduler);
+    struct CeQueueSlot* slot = &scheduler->slots[index];
+    atomic_fetch_add_explicit(&slot->load, 1, memory_order_relaxed);
+    pthread_mutex_lock(&slot->submitMutex);
+    VkResult result = vkQueueSubmit(slot->vulkanQueue, submitCount, pSubmits, fence);
+    pthread_mutex_unlock(&slot->submitMutex);
+    if(result != VK_SUCCESS) {
+        atomic_fetch_sub_explicit(&slot->load, 1, memory_order_relaxed);
+        return result;
+    }
+    *pQueueIndex = index;
+    return VK_SUCCESS;
+}
+
+void
+ceSchedulerHold(CeQueueScheduler scheduler, uint32_t queueIndex, uint32_t count) {
+    if(queueIndex < scheduler->slotCount && count)
+        atomic_fetch_add_explicit(&scheduler->slots[queueIndex].load, count, memory_order_relaxed);
+}
+
+void
+ceSchedulerRelease(CeQueueScheduler scheduler, uint32_t queueIndex) {
+    if(queueIndex < scheduler->slotCount)
+        atomic_fetch_sub_explicit(&scheduler->slots[queueIndex].load, 1, memory_order_relaxed);
+}
+
+uint32_t
+ceGetSchedulerQueueCount(CeQueueScheduler scheduler) {
+    return scheduler->slotCount;
+}
+
+void
+ceDestroyQueueScheduler(CeInstance instance, CeQueueScheduler scheduler) {
+    if(!scheduler)
+        return;
+    for(uint32_t i = 0; i < scheduler->slotCount; ++i)
+        pthread_mutex_destroy(&scheduler->slots[i].submitMutex);
+    free(scheduler->slots);
+    free(scheduler);
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include "ce-def.h"
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan_core.h>
+
+/*
+* The shader cache keeps one VkShaderModule per shader file or SPIR-V in memory, shared by every pipeline built from it,
+* so specialized variants of a kernel only pay for loading and creating the module once.
+* Modules are reference counted and destroyed when the last pipeline using them is.
+* The cache is thread-safe, pipelines may be created and destroyed from any thread.
+*/
+typedef struct CeShaderCache_t *CeShaderCache;
+
+VkResult
+ceCreateShaderCache(CeInstance, CeShaderCache*);
+
+//returns the module for the shader file, loading it the first time it is asked for
+VkResult
+ceAcquireShaderModule(CeInstance, CeShaderCache, const char* pFilename, VkShaderModule*);
+
+//returns the module for SPIR-V in memory, code with the same hash and size shares a module
+VkResult
+ceAcquireShaderModuleFromCode(CeInstance, CeShaderCache, const uint32_t* pCode, size_t codeSize, VkShaderModule*);
+
+//a hash of the module's SPIR-V, which stays the same across runs and file names
+uint64_t
+ceGetShaderModuleHash(CeShaderCache, VkShaderModule);
+
+void
+ceReleaseShaderModule(CeInstance, CeShaderCache, VkShaderModule);
+
+void
+ceDestroyShaderCache(CeInstance, CeShaderCache);
@@ -0,0 +1,217 @@
+#include "ce-shader-internal.h"
+#include "ce-def.h"
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan_core.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include "ce-instance-internal.h"
+
+struct CeShaderCacheEntry {
+    struct CeShaderCacheEntry* next;
+    //NULL for modules created from code in memory, which are found by their code
+    char* filename;
+    //a copy of the code of modules created from code in memory, compared whole when the hash and size match
+    uint32_t* code;
+    size_t codeSize;
+    VkShaderModule vulkanShader;
+    //identifies the SPIR-V itself rather than the file it came from
+    uint64_t codeHash;
+    uint32_t referenceCount;
+};
+
+struct CeShaderCache_t {
+    struct CeShaderCacheEntry* entries;
+    //pipelines are created and destroyed from any thread, the reference counts and the list share this lock
+    pthread_mutex_t mutex;
+};
+
+VkResult
+ceCreateShaderCache(CeInstance instance, CeShaderCache* target) {
+    *target = calloc(1, sizeof(struct CeShaderCache_t));
+    if(!*target)
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    pthread_mutex_init(&(*target)->mutex, NULL);
+    return VK_SUCCESS;
+}
+
+//64 bit FNV-1a
+static uint64_t __hashCode(const uint32_t* code, size_t size) {
+    const unsigned char* bytes = (const unsigned char*)code;
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for(size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+static VkResult __createVkShaderModule(CeInstance instance, const uint32_t* code, size_t size, VkShaderModule* target) {
+    VkShaderModuleCreateInfo shaderInfo = {
+        .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+        .codeSize = size,
+        .pCode = code,
+    };
+    return vkCreateShaderModule(ceGetInstanceVulkanDevice(instance), &shaderInfo, NULL, target);
+}
+
+static VkResult __loadVkShaderModule(CeInstance instance, const char* filename, struct CeShaderCacheEntry* entry) {
+    FILE* file = fopen(filename, "rb");
+    if(!file)
+        return VK_ERROR_INITIALIZATION_FAILED;
+    fseek(file, 0, SEEK_END);
+    long fileLen = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    //SPIR-V is made of 32 bit words
+    if(fileLen <= 0 || fileLen % sizeof(uint32_t)) {
+        fclose(file);
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+    uint32_t* code = malloc(fileLen);
+    if(!code) {
+        fclose(file);
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+    size_t readCount = fread(code, fileLen, 1, file);
+    fclose(file);
+    if(readCount != 1) {
+        free(code);
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+    VkResult result = __createVkShaderModule(instance, code, fileLen, &entry->vulkanShader);
+    entry->codeHash = __hashCode(code, fileLen);
+    entry->codeSize = fileLen;
+    free(code);
+    return result;
+}
+
+static void __insertEntry(CeShaderCache cache, struct CeShaderCacheEntry* entry, VkShaderModule* target) {
+    entry->referenceCount = 1;
+    entry->next = cache->entries;
+    cache->entries = entry;
+    *target = entry->vulkanShader;
+}
+
+static VkResult __acquireShaderModuleLocked(CeInstance instance, CeShaderCache cache, const char* pFilename, VkShaderModule* target) {
+    for(struct CeShaderCacheEntry* entry = cache->entries; entry; entry = entry->next) {
+        if(entry->filename && !strcmp(entry->filename, pFilename)) {
+            ++entry->referenceCount;
+            *target = entry->vulkanShader;
+            return VK_SUCCESS;
+        }
+    }
+    struct CeShaderCacheEntry* entry = calloc(1, sizeof(struct CeShaderCacheEntry));
+    if(!entry)
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    VkResult result = __loadVkShaderModule(instance, pFilename, entry);
+    if(result != VK_SUCCESS) {
+        free(entry);
+        return result;
+    }
+    entry->filename = strdup(pFilename);
+    if(!entry->filename) {
+        vkDestroyShaderModule(ceGetInstanceVulkanDevice(instance), entry->vulkanShader, NULL);
+        free(entry);
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+    __insertEntry(cache, entry, target);
+    return VK_SUCCESS;
+}
+
+//the file is loaded with the lock held, so that two pipelines asking for a new shader at once share one module
+VkResult
+ceAcquireShaderModule(CeInstance instance, CeShaderCache cache, const char* pFilename, VkShaderModule* target) {
+    pthread_mutex_lock(&cache->mutex);
+    VkResult result = __acquireShaderModuleLocked(instance, cache, pFilename, target);
+    pthread_mutex_unlock(&cache->mutex);
+    return result;
+}
+
+static VkResult __acquireShaderModuleFromCodeLocked(CeInstance instance, CeShaderCache cache, const uint32_t* pCode, size_t codeSize, uint64_t codeHash, VkShaderModule* target) {
+    for(struct CeShaderCacheEntry* entry = cache->entries; entry; entry = entry->next) {
+        if(!entry->filename && entry->codeHash == codeHash && entry->codeSize == codeSize && !memcmp(entry->code, pCode, codeSize)) {
+            ++entry->referenceCount;
+            *target = entry->vulkanShader;
+            return VK_SUCCESS;
+        }
+    }
+    struct CeShaderCacheEntry* entry = calloc(1, sizeof(struct CeShaderCacheEntry));
+    if(!entry)
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    entry->code = malloc(codeSize);
+    if(!entry->code) {
+        free(entry);
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+    memcpy(entry->code, pCode, codeSize);
+    VkResult result = __createVkShaderModule(instance, pCode, codeSize, &entry->vulkanShader);
+    if(result != VK_SUCCESS) {
+        free(entry->code);
+        free(entry);
+        return result;
+    }
+    entry->codeHash = codeHash;
+    entry->codeSize = codeSize;
+    __insertEntry(cache, entry, target);
+    return VK_SUCCESS;
+}
+
+VkResult
+ceAcquireShaderModuleFromCode(CeInstance instance, CeShaderCache cache, const uint32_t* pCode, size_t codeSize, VkShaderModule* target) {
+    if(!codeSize || codeSize % sizeof(uint32_t))
+        return VK_ERROR_INITIALIZATION_FAILED;
+    const uint64_t codeHash = __hashCode(pCode, codeSize);
+    pthread_mutex_lock(&cache->mutex);
+    VkResult result = __acquireShaderModuleFromCodeLocked(instance, cache, pCode, codeSize, codeHash, target);
+    pthread_mutex_unlock(&cache->mutex);
+    return result;
+}
+
+uint64_t
+ceGetShaderModuleHash(CeShaderCache cache, VkShaderModule shader) {
+    uint64_t codeHash = 0;
+    pthread_mutex_lock(&cache->mutex);
+    for(struct CeShaderCacheEntry* entry = cache->entries; entry; entry = entry->next) {
+        if(entry->vulkanShader == shader) {
+            codeHash = entry->codeHash;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&cache->mutex);
+    return codeHash;
+}
+
+void
+ceReleaseShaderModule(CeInstance instance, CeShaderCache cache, VkShaderModule shader) {
+    pthread_mutex_lock(&cache->mutex);
+    for(struct CeShaderCacheEntry** link = &cache->entries; *link; link = &(*link)->next) {
+        struct CeShaderCacheEntry* entry = *link;
+        if(entry->vulkanShader != shader)
+            continue;
+        if(!--entry->referenceCount) {
+            *link = entry->next;
+            vkDestroyShaderModule(ceGetInstanceVulkanDevice(instance), entry->vulkanShader, NULL);
+            free(entry->filename);
+            free(entry->code);
+            free(entry);
+        }
+        break;
+    }
+    pthread_mutex_unlock(&cache->mutex);
+}
+
+void
+ceDestroyShaderCache(CeInstance instance, CeShaderCache cache) {
+    if(!cache)
+        return;
+    for(struct CeShaderCacheEntry* entry = cache->entries, *next; entry; entry = next) {
+        next = entry->next;
+        vkDestroyShaderModule(ceGetInstanceVulkanDevice(instance), entry->vulkanShader, NULL);
+        free(entry->filename);
+        free(entry->code);
+        free(entry);
+    }
+    pthread_mutex_destroy(&cache->mutex);
+    free(cache);
+}
@@ -0,0 +1,269 @@
+#include "ce-shard.h"
+#include "ce-def.h"
+#include <stdlib.h>
+#include <string.h>
+#include "ce-instance.h"
+#include "ce-command.h"
+#include "ce-transfer.h"
+#include "ce-pipeline-internal.h"
+#include "ce-error-internal.h"
+#include "ce-trace-internal.h"
+
+struct CeShard {
+    CeInstance device;
+    CePipeline pipeline;
+    //records the pipeline once, at creation
+    CeCommand command;
+    uint32_t firstElement;
+    uint32_t elementCount;
+};
+
+struct CeShardedPipeline_t {
+    struct CeShard* shards;
+    uint32_t shardCount;
+    uint32_t bindingCount;
+    uint32_t* bindingElementSizes;
+    //element count of the whole binding, split across the shards when it is sharded
+    uint32_t* bindingElementCounts;
+    CeBool32* isBindingSharded;
+};
+
+static CeResult __createShard(const CeShardedPipelineCreationArgs* args, CeShardedPipeline sharded, uint32_t totalElementCount,
+    uint32_t totalGroupCount, struct CeShard* shard) {
+    const CePipelineCreationArgs* pipelineArgs = args->pPipelineArgs;
+    CePipelineBindingInfo* bindings = malloc(pipelineArgs->uBindingCount * sizeof(CePipelineBindingInfo));
+    if(!bindings)
+        return ceResult(CE_ERROR_INTERNAL, "stdlib failed to allocate the bindings of a shard");
+    memcpy(bindings, pipelineArgs->pBindings, pipelineArgs->uBindingCount * sizeof(CePipelineBindingInfo));
+    for(uint32_t i = 0; i < pipelineArgs->uBindingCount; ++i) {
+        if(!sharded->isBindingSharded[i])
+            continue;
+        bindings[i].uElementCount = shard->elementCount;
+        if(bindings[i].pInitialData)
+            bindings[i].pInitialData = (char*)bindings[i].pInitialData + (uint64_t)shard->firstElement * bindings[i].uElementSize;
+        if(bindings[i].pHostMemory)
+            bindings[i].pHostMemory = (char*)bindings[i].pHostMemory + (uint64_t)shard->firstElement * bindings[i].uElementSize;
+    }
+    CePipelineCreationArgs shardArgs = *pipelineArgs;
+    shardArgs.pBindings = bindings;
+    //the shard's own work groups along x, split like its elements, y and z are dispatched whole by every shard
+    const uint64_t groupCount = totalGroupCount;
+    shardArgs.uDispatchGroupCount = (uint32_t)(groupCount * (shard->firstElement + shard->elementCount) / totalElementCount -
+        groupCount * shard->firstElement / totalElementCount);
+    //the handles are only kept once created, a failed creation leaves nothing which can be destroyed
+    CePipeline pipeline;
+    CeResult result = ceCreatePipeline(shard->device, &shardArgs, &pipeline);
+    free(bindings);
+    if(result != CE_SUCCESS)
+        return result;
+    shard->pipeline = pipeline;
+    CeCommandCreationArgs commandArgs = {
+        .bIsSecondaryCommand = CE_FALSE,
+    };
+    CeCommand command;
+    result = ceCreateCommand(shard->device, &commandArgs, &command);
+    if(result != CE_SUCCESS)
+        return result;
+    shard->command = command;
+    CeCommandRecordingArgs recordingArgs = {
+        .bRecordCommand = CE_FALSE,
+        .pSuppliedPipeline = shard->pipeline,
+    };
+    if((result = ceBeginCommand(shard->command)) != CE_SUCCESS)
+        return result;
+    if((result = ceRecordToCommand(&recordingArgs, shard->command)) != CE_SUCCESS)
+        return result;
+    return ceEndCommand(shard->command);
+}
+
+CeResult
+ceCreateShardedPipeline(CeInstance instance, const CeShardedPipelineCreationArgs* args, CeShardedPipeline* target) {
+    if(!instance || !args || !target || !args->pPipelineArgs)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot create sharded pipeline: some parameters were NULL");
+    const CePipelineCreationArgs* pipelineArgs = args->pPipelineArgs;
+    if(pipelineArgs->pIndirectBuffer)
+        return ceResult(CE_ERROR_INVALID_ARG, "cannot create sharded pipeline: the indirect buffer only lives on one device");
+    if(!args->uShardedBindingCount || !args->pShardedBindings)
+        return ceResult(CE_ERROR_INVALID_ARG, "cannot create sharded pipeline: no sharded binding given");
+    for(uint32_t i = 0; i < pipelineArgs->uBindingCount; ++i) {
+        if(pipelineArgs->pBindings[i].pSuppliedBuffer)
+            return ceResult(CE_ERROR_INVALID_ARG, "cannot create sharded pipeline: supplied buffers only live on one device");
+    }
+    uint32_t totalElementCount = 0;
+    for(uint32_t i = 0; i < args->uShardedBindingCount; ++i) {
+        const uint32_t binding = args->pShardedBindings[i];
+        if(binding >= pipelineArgs->uBindingCount)
+            return ceResult(CE_ERROR_INVALID_ARG, "cannot create sharded pipeline: sharded binding index out of range");
+        if(i && pipelineArgs->pBindings[binding].uElementCount != totalElementCount)
+            return ceResult(CE_ERROR_INVALID_ARG, "cannot create sharded pipeline: sharded bindings have different element counts");
+        totalElementCount = pipelineArgs->pBindings[binding].uElementCount;
+    }
+    if(!totalElementCount)
+        return ceResult(CE_ERROR_INVALID_ARG, "cannot create sharded pipeline: sharded bindings have no elements");
+
+    //without a count the whole pipeline would dispatch one work group per element of its longest binding, as ceCreatePipeline does
+    uint32_t totalGroupCount = pipelineArgs->uDispatchGroupCount;
+    for(uint32_t i = 0; i < pipelineArgs->uBindingCount && !pipelineArgs->uDispatchGroupCount; ++i) {
+        if(pipelineArgs->pBindings[i].uElementCount > totalGroupCount)
+            totalGroupCount = pipelineArgs->pBindings[i].uElementCount;
+    }
+
+    uint64_t traceBegin = ceTraceBegin();
+    CeShardedPipeline sharded = calloc(1, sizeof(struct CeShardedPipeline_t));
+    if(!sharded)
+        return ceResult(CE_ERROR_INTERNAL, "stdlib failed to allocate a sharded pipeline");
+    sharded->bindingCount = pipelineArgs->uBindingCount;
+    sharded->bindingElementSizes = calloc(sharded->bindingCount, sizeof(uint32_t));
+    sharded->bindingElementCounts = calloc(sharded->bindingCount, sizeof(uint32_t));
+    sharded->isBindingSharded = calloc(sharded->bindingCount, sizeof(CeBool32));
+    if(!sharded->bindingElementSizes || !sharded->bindingElementCounts || !sharded->isBindingSharded) {
+        ceDestroyShardedPipeline(instance, sharded);
+        return ceResult(CE_ERROR_INTERNAL, "stdlib failed to allocate the bindings of a sharded pipeline");
+    }
+    for(uint32_t i = 0; i < sharded->bindingCount; ++i) {
+        sharded->bindingElementSizes[i] = pipelineArgs->pBindings[i].uElementSize;
+        sharded->bindingElementCounts[i] = pipelineArgs->pBindings[i].uElementCount;
+    }
+    for(uint32_t i = 0; i < args->uShardedBindingCount; ++i)
+        sharded->isBindingSharded[args->pShardedBindings[i]] = CE_TRUE;
+
+    //every shard needs at least one element and one work group
+    uint32_t shardCount = ceGetInstanceDeviceCount(instance);
+    if(shardCount > totalElementCount)
+        shardCount = totalElementCount;
+    if(shardCount > totalGroupCount)
+        shardCount = totalGroupCount;
+    sharded->shards = calloc(shardCount, sizeof(struct CeShard));
+    if(!sharded->shards) {
+        ceDestroyShardedPipeline(instance, sharded);
+        return ceResult(CE_ERROR_INTERNAL, "stdlib failed to allocate the shards of a sharded pipeline");
+    }
+    for(uint32_t i = 0; i < shardCount; ++i) {
+        struct CeShard* shard = &sharded->shards[i];
+        ceGetInstanceDevice(instance, i, &shard->device);
+        shard->firstElement = (uint32_t)((uint64_t)totalElementCount * i / shardCount);
+        shard->elementCount = (uint32_t)((uint64_t)totalElementCount * (i + 1) / shardCount) - shard->firstElement;
+        //counted as it goes so that destroying after a failure only touches the shards which were created
+        sharded->shardCount = i + 1;
+        CeResult result = __createShard(args, sharded, totalElementCount, totalGroupCount, shard);
+        if(result != CE_SUCCESS) {
+            ceDestroyShardedPipeline(instance, sharded);
+            return result;
+        }
+    }
+    ceTraceEnd("ceCreateShardedPipeline", traceBegin);
+    *target = sharded;
+    return CE_SUCCESS;
+}
+
+uint32_t
+ceGetShardedPipelineShardCount(CeShardedPipeline sharded) {
+    return sharded->shardCount;
+}
+
+CeResult
+ceGetShardedPipelineShard(CeShardedPipeline sharded, uint32_t uShard, CeInstance* device, CePipeline* shardPipeline, uint32_t* pFirstElement) {
+    if(!sharded)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot get shard: no sharded pipeline passed");
+    if(uShard >= sharded->shardCount)
+        return ceResult(CE_ERROR_INVALID_ARG, "cannot get shard: index out of range");
+    if(device)
+        *device = sharded->shards[uShard].device;
+    if(shardPipeline)
+        *shardPipeline = sharded->shards[uShard].pipeline;
+    if(pFirstElement)
+        *pFirstElement = sharded->shards[uShard].firstElement;
+    return CE_SUCCESS;
+}
+
+CeResult
+ceRunShardedPipeline(CeInstance instance, CeShardedPipeline sharded) {
+    if(!instance || !sharded)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot run sharded pipeline: some parameters were NULL");
+    for(uint32_t i = 0; i < sharded->shardCount; ++i) {
+        CeResult result = ceRunCommand(sharded->shards[i].device, sharded->shards[i].command);
+        if(result != CE_SUCCESS)
+            return result;
+    }
+    return CE_SUCCESS;
+}
+
+CeResult
+ceWaitShardedPipeline(CeInstance instance, CeShardedPipeline sharded) {
+    if(!instance || !sharded)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot wait for sharded pipeline: some parameters were NULL");
+    CeResult result = CE_SUCCESS;
+    for(uint32_t i = 0; i < sharded->shardCount; ++i) {
+        CeResult shardResult = ceWaitCommand(sharded->shards[i].device, sharded->shards[i].command);
+        if(shardResult != CE_SUCCESS)
+            result = shardResult;
+    }
+    return result;
+}
+
+//starts a copy per shard, each after its shard's last run, and waits for all of them so that the devices copy at the same time
+static CeResult __transferShards(CeShardedPipeline sharded, uint32_t binding, const void* pUploadData, void* pDownloadData) {
+    const uint32_t shardCount = pDownloadData && !sharded->isBindingSharded[binding] ? 1 : sharded->shardCount;
+    CeTransfer* transfers = calloc(shardCount, sizeof(CeTransfer));
+    CeResult result = CE_SUCCESS;
+    for(uint32_t i = 0; i < shardCount && result == CE_SUCCESS; ++i) {
+        struct CeShard* shard = &sharded->shards[i];
+        uint64_t offset = 0;
+        uint64_t size = (uint64_t)sharded->bindingElementSizes[binding] * sharded->bindingElementCounts[binding];
+        if(sharded->isBindingSharded[binding]) {
+            offset = (uint64_t)sharded->bindingElementSizes[binding] * shard->firstElement;
+            size = (uint64_t)sharded->bindingElementSizes[binding] * shard->elementCount;
+        }
+        CeBuffer buffer = ceGetPipelineBindingBuffer(shard->pipeline, binding);
+        if(pUploadData)
+            result = ceUploadBufferAsync(shard->device, buffer, 0, (const char*)pUploadData + offset, size, shard->command, &transfers[i]);
+        else
+            result = ceDownloadBufferAsync(shard->device, buffer, 0, (char*)pDownloadData + offset, size, shard->command, &transfers[i]);
+    }
+    //the transfers which did start are waited for even after a failure, they still use the shards' buffers
+    for(uint32_t i = 0; i < shardCount; ++i) {
+        if(!transfers[i])
+            continue;
+        CeResult waitResult = ceWaitTransfer(sharded->shards[i].device, transfers[i]);
+        if(waitResult != CE_SUCCESS && result == CE_SUCCESS)
+            result = waitResult;
+        ceDestroyTransfer(sharded->shards[i].device, transfers[i]);
+    }
+    free(transfers);
+    return result;
+}
+
+CeResult
+ceScatterShardedBinding(CeInstance instance, CeShardedPipeline sharded, uint32_t uBindingIndex, const void* pData) {
+    if(!instance || !sharded || !pData)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot scatter binding: some parameters were NULL");
+    if(uBindingIndex >= sharded->bindingCount)
+        return ceResult(CE_ERROR_INVALID_ARG, "cannot scatter binding: binding index out of range");
+    return __transferShards(sharded, uBindingIndex, pData, NULL);
+}
+
+CeResult
+ceGatherShardedBinding(CeInstance instance, CeShardedPipeline sharded, uint32_t uBindingIndex, void* pData) {
+    if(!instance || !sharded || !pData)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot gather binding: some parameters were NULL");
+    if(uBindingIndex >= sharded->bindingCount)
+        return ceResult(CE_ERROR_INVALID_ARG, "cannot gather binding: binding index out of range");
+    return __transferShards(sharded, uBindingIndex, NULL, pData);
+}
+
+void
+ceDestroyShardedPipeline(CeInstance instance, CeShardedPipeline sharded) {
+    if(!sharded)
+        return;
+    for(uint32_t i = 0; i < sharded->shardCount; ++i) {
+        if(sharded->shards[i].pipeline)
+            ceDestroyPipeline(sharded->shards[i].device, sharded->shards[i].pipeline);
+        if(sharded->shards[i].command)
+            ceDestroyCommand(sharded->shards[i].device, sharded->shards[i].command);
+    }
+    free(sharded->shards);
+    free(sharded->bindingElementSizes);
+    free(sharded->bindingElementCounts);
+    free(sharded->isBindingSharded);
+    free(sharded);
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include "ce-def.h"
+#include "ce-pipeline.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    //the pipeline created on every device of the instance. pSuppliedBuffer is not allowed in its bindings
+    const CePipelineCreationArgs* pPipelineArgs;
+    //bindings whose elements (and initial data) are split across the devices, they **must** all have the same element count.
+    //the other bindings are copied whole to every device
+    const uint32_t* pShardedBindings;
+    uint32_t uShardedBindingCount;
+} CeShardedPipelineCreationArgs;
+
+/**
+* Create a pipeline split across every device of an instance (see ceGetInstanceDevice).
+* Device i gets the i-th contiguous slice of the sharded bindings' elements, which its shader sees indexed from 0.
+* Only the work groups along x are split, like the elements: uDispatchGroupCount, or when it is 0 the element count of the
+* longest binding as for ceCreatePipeline. uDispatchGroupCountY and uDispatchGroupCountZ are dispatched whole by every device.
+* \param instance the instance whose devices run the shards
+* \param args pointer to a CeShardedPipelineCreationArgs structure
+* \param pipeline the handle the function writes to
+*/
+CeResult
+ceCreateShardedPipeline(CeInstance instance, const CeShardedPipelineCreationArgs* args, CeShardedPipeline* pipeline);
+
+//the number of devices the pipeline was split across, fewer than the instance's devices when there are fewer elements
+uint32_t
+ceGetShardedPipelineShardCount(CeShardedPipeline pipeline);
+
+/**
+* Get what runs one shard, to record it or read its bindings by hand.
+* \param uShard index of the shard, below ceGetShardedPipelineShardCount
+* \param device if not NULL, the device the shard runs on is written to it
+* \param shardPipeline if not NULL, the shard's pipeline is written to it
+* \param pFirstElement if not NULL, the index of the shard's first element in the sharded bindings is written to it
+*/
+CeResult
+ceGetShardedPipelineShard(CeShardedPipeline pipeline, uint32_t uShard, CeInstance* device, CePipeline* shardPipeline, uint32_t* pFirstElement);
+
+//run every shard, each on its own device
+CeResult
+ceRunShardedPipeline(CeInstance instance, CeShardedPipeline pipeline);
+
+CeResult
+ceWaitShardedPipeline(CeInstance instance, CeShardedPipeline pipeline);
+
+/**
+* Write a binding's elements to every shard, after the shards' last runs completed.
+* pData holds the binding's whole element range, each shard receives its slice of a sharded binding
+* and the whole of any other binding. Returns once every device received its data.
+*/
+CeResult
+ceScatterShardedBinding(CeInstance instance, CeShardedPipeline pipeline, uint32_t uBindingIndex, const void* pData);
+
+/**
+* Read a binding's elements back from every shard, after the shards' last runs completed.
+* The slices of a sharded binding are gathered into pData in order, any other binding is read from the first shard.
+* The devices are read from at the same time, the function returns once pData is filled.
+*/
+CeResult
+ceGatherShardedBinding(CeInstance instance, CeShardedPipeline pipeline, uint32_t uBindingIndex, void* pData);
+
+/**
+* Destroy a sharded pipeline along with the pipeline and command of every shard.
+* The shards **must** have been waited upon.
+*/
+void
+ceDestroyShardedPipeline(CeInstance instance, CeShardedPipeline pipeline);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,160 @@
+#include "ce-sort.h"
+#include "ce-def.h"
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan_core.h>
+#include <stdlib.h>
+#include "ce-buffer.h"
+#include "ce-primitives-internal.h"
+#include "ce-buffer-internal.h"
+#include "ce-error-internal.h"
+
+//the kernels in shaders/, compiled to C initializers by glslc -mfmt=c
+static const uint32_t sortHistogramCode[] =
+#include "shaders/sort-histogram.spv.inc"
+;
+static const uint32_t sortScatterCode[] =
+#include "shaders/sort-scatter.spv.inc"
+;
+static const uint32_t sortScatterSubgroupCode[] =
+#include "shaders/sort-scatter-subgroup.spv.inc"
+;
+static const uint32_t sortSegmentsCode[] =
+#include "shaders/sort-segments.spv.inc"
+;
+
+static const struct CePrimitiveKernel sortHistogramKernel = {
+    sortHistogramCode, sizeof(sortHistogramCode), NULL, 0,
+};
+static const struct CePrimitiveKernel sortScatterKernel = {
+    sortScatterCode, sizeof(sortScatterCode), sortScatterSubgroupCode, sizeof(sortScatterSubgroupCode),
+};
+static const struct CePrimitiveKernel sortSegmentsKernel = {
+    sortSegmentsCode, sizeof(sortSegmentsCode), NULL, 0,
+};
+
+#define CE_SORT_DIGIT_BITS 8
+#define CE_SORT_RADIX (1u << CE_SORT_DIGIT_BITS)
+//CE_SORT_SEGMENT_WORD in shaders/sort.glsl
+#define CE_SORT_SEGMENT_WORD 2
+
+//specialization constants 2 to 4 of shaders/sort.glsl
+enum CeSortSpecialization {
+    CE_SORT_SPECIALIZATION_KEY_TYPE = 2,
+    CE_SORT_SPECIALIZATION_HAS_PAYLOAD,
+    CE_SORT_SPECIALIZATION_HAS_SEGMENTS,
+};
+
+struct CeSort_t {
+    struct CePrimitivePasses passes;
+};
+
+//the buffers a pass reads from and the ones it writes to, swapped after each pass
+struct CeSortBuffers {
+    CeBuffer keys;
+    CeBuffer segments;
+    CeBuffer payload;
+};
+
+static CeResult __addDigitPass(struct CePrimitivePasses* passes, const struct CeSortBuffers* input, const struct CeSortBuffers* output,
+    uint32_t elementCount, uint32_t digitWord, uint32_t digitShift) {
+    const uint32_t tileCount = ceGetPrimitiveTileCount(elementCount);
+    CeBuffer histogram;
+    CeResult result = ceCreatePrimitiveScratchBuffer(passes, tileCount * CE_SORT_RADIX, sizeof(uint32_t), &histogram);
+    if(result != CE_SUCCESS)
+        return result;
+    uint32_t constants[4] = {elementCount, tileCount, digitWord, digitShift};
+    CeBuffer histogramBuffers[3] = {input->keys, input->segments, histogram};
+    if((result = ceAddPrimitivePass(passes, &sortHistogramKernel, histogramBuffers, 3, constants, 4, tileCount)) != CE_SUCCESS)
+        return result;
+    //the histogram is digit-major, so its exclusive scan is where each tile's elements of each digit start
+    if((result = ceAddPrimitiveScan(passes, histogram, histogram, tileCount * CE_SORT_RADIX, CE_FALSE, CE_FALSE)) != CE_SUCCESS)
+        return result;
+    CeBuffer scatterBuffers[7] = {input->keys, input->segments, histogram, output->keys, output->segments, input->payload, output->payload};
+    return ceAddPrimitivePass(passes, &sortScatterKernel, scatterBuffers, 7, constants, 4, tileCount);
+}
+
+static CeResult __addPasses(struct CePrimitivePasses* passes, const CeSortCreationArgs* args, uint32_t elementCount) {
+    const uint32_t keyWords = args->eKeyType >= CE_SORT_KEY_TYPE_UINT64 ? 2 : 1;
+    const uint32_t keySize = keyWords * sizeof(uint32_t);
+    //kernels bind every buffer they may use, unused ones are bound to the keys and never read or written
+    struct CeSortBuffers buffers[2] = {
+        { args->pKeys, args->pKeys, args->pPayload ? args->pPayload : args->pKeys },
+        { NULL, NULL, NULL },
+    };
+    CeResult result = ceCreatePrimitiveScratchBuffer(passes, elementCount, keySize, &buffers[1].keys);
+    if(result != CE_SUCCESS)
+        return result;
+    buffers[1].segments = buffers[1].keys;
+    buffers[1].payload = buffers[1].keys;
+    if(args->pPayload && (result = ceCreatePrimitiveScratchBuffer(passes, elementCount, sizeof(uint32_t), &buffers[1].payload)) != CE_SUCCESS)
+        return result;
+    uint32_t segmentPassCount = 0;
+    if(args->pSegmentOffsets) {
+        //segment ids are the most significant digits, an even number of them so that the sorted data lands back in the keys
+        const uint32_t segmentCount = ceGetBufferElementCount(args->pSegmentOffsets);
+        segmentPassCount = segmentCount <= (1u << 16) ? 2 : 4;
+        if((result = ceCreatePrimitiveScratchBuffer(passes, elementCount, sizeof(uint32_t), &buffers[0].segments)) != CE_SUCCESS ||
+            (result = ceCreatePrimitiveScratchBuffer(passes, elementCount, sizeof(uint32_t), &buffers[1].segments)) != CE_SUCCESS)
+            return result;
+        CeBuffer segmentBuffers[2] = {args->pSegmentOffsets, buffers[0].segments};
+        uint32_t constants[2] = {elementCount, segmentCount};
+        if((result = ceAddPrimitivePass(passes, &sortSegmentsKernel, segmentBuffers, 2, constants, 2, ceGetPrimitiveTileCount(elementCount))) != CE_SUCCESS)
+            return result;
+    }
+    const uint32_t keyPassCount = keyWords * 32 / CE_SORT_DIGIT_BITS;
+    for(uint32_t pass = 0; pass < keyPassCount + segmentPassCount; ++pass) {
+        const CeBool32 isSegmentPass = pass >= keyPassCount;
+        const uint32_t digit = isSegmentPass ? pass - keyPassCount : pass;
+        const uint32_t digitWord = isSegmentPass ? CE_SORT_SEGMENT_WORD : digit * CE_SORT_DIGIT_BITS / 32;
+        const uint32_t digitShift = digit * CE_SORT_DIGIT_BITS % 32;
+        if((result = __addDigitPass(passes, &buffers[pass % 2], &buffers[(pass + 1) % 2], elementCount, digitWord, digitShift)) != CE_SUCCESS)
+            return result;
+    }
+    return CE_SUCCESS;
+}
+
+CeResult
+ceCreateSort(CeInstance instance, const CeSortCreationArgs* args, CeSort* sort) {
+    if(!instance || !args || !args->pKeys || !sort)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot create sort: some parameters were NULL");
+    if(args->eKeyType > CE_SORT_KEY_TYPE_FLOAT64)
+        return ceResult(CE_ERROR_INVALID_ARG, "cannot create sort: invalid key type");
+    const uint32_t elementCount = ceGetBufferElementCount(args->pKeys);
+    const uint32_t keySize = args->eKeyType >= CE_SORT_KEY_TYPE_UINT64 ? 8 : 4;
+    if(ceGetBufferSize(args->pKeys) != (VkDeviceSize)elementCount * keySize)
+        return ceResult(CE_ERROR_INVALID_ARG, "cannot create sort: the keys' element size does not match their type");
+    if(args->pPayload && (ceGetBufferSize(args->pPayload) != (VkDeviceSize)ceGetBufferElementCount(args->pPayload) * sizeof(uint32_t) ||
+        ceGetBufferElementCount(args->pPayload) < elementCount))
+        return ceResult(CE_ERROR_INVALID_ARG, "cannot create sort: the payload needs a 4 byte element for each key");
+    if(args->pSegmentOffsets && (ceGetBufferSize(args->pSegmentOffsets) != (VkDeviceSize)ceGetBufferElementCount(args->pSegmentOffsets) * sizeof(uint32_t) ||
+        !ceGetBufferElementCount(args->pSegmentOffsets)))
+        return ceResult(CE_ERROR_INVALID_ARG, "cannot create sort: segment offsets need at least one 4 byte element");
+
+    *sort = calloc(1, sizeof(struct CeSort_t));
+    ceInitPrimitivePasses(instance, &(*sort)->passes);
+    //constants 0 and 1 stay 0, the kernels' own scans are unsigned sums
+    (*sort)->passes.specialization[CE_SORT_SPECIALIZATION_KEY_TYPE] = args->eKeyType;
+    (*sort)->passes.specialization[CE_SORT_SPECIALIZATION_HAS_PAYLOAD] = args->pPayload ? 1 : 0;
+    (*sort)->passes.specialization[CE_SORT_SPECIALIZATION_HAS_SEGMENTS] = args->pSegmentOffsets ? 1 : 0;
+    CeResult result = elementCount ? __addPasses(&(*sort)->passes, args, elementCount) : CE_SUCCESS;
+    if(result != CE_SUCCESS) {
+        ceDestroySort(instance, *sort);
+        *sort = NULL;
+    }
+    return result;
+}
+
+CeResult
+ceRecordSortToCommand(CeSort sort, CeCommand command) {
+    if(!sort || !command)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot record sort: some parameters were NULL");
+    return ceRecordPrimitivePasses(&sort->passes, command);
+}
+
+void
+ceDestroySort(CeInstance instance, CeSort sort) {
+    if(!sort)
+        return;
+    ceDestroyPrimitivePasses(&sort->passes);
+    free(sort);
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include "ce-def.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//how the keys of a sort are read. 64 bit keys are buffers with 8 byte elements
+typedef enum {
+    CE_SORT_KEY_TYPE_UINT32 = 0,
+    CE_SORT_KEY_TYPE_INT32,
+    CE_SORT_KEY_TYPE_FLOAT32,
+    CE_SORT_KEY_TYPE_UINT64,
+    CE_SORT_KEY_TYPE_INT64,
+    CE_SORT_KEY_TYPE_FLOAT64,
+} CeSortKeyType;
+
+typedef struct {
+    //the keys, sorted in place in ascending order. Pipeline bindings are passed with ceGetPipelineBindingBufferHandle
+    CeBuffer pKeys;
+    CeSortKeyType eKeyType;
+    //optional, 4 byte elements moved along with their key, one per key
+    CeBuffer pPayload;
+    //optional, the ascending uint32_t indices at which each segment of the keys starts.
+    //each segment is sorted on its own and elements never leave their segment
+    CeBuffer pSegmentOffsets;
+} CeSortCreationArgs;
+
+/**
+* Create a sort, a stable LSD radix sort of a buffer of keys with 8 bit digits.
+* Its passes and scratch buffers are created once, and recorded to commands with ceRecordSortToCommand.
+* The scratch memory is a copy of the keys, the payload and the segments, plus 1 KiB per 1024 keys.
+* Floats are ordered as their sign and magnitude, -0 before +0 and NaNs at the ends depending on their sign.
+* \param instance the instance the sort runs on
+* \param args pointer to a CeSortCreationArgs structure
+* \param sort the handle the function writes to
+*/
+CeResult
+ceCreateSort(CeInstance instance, const CeSortCreationArgs* args, CeSort* sort);
+
+/**
+* Record the sort to a command which was begun, between barriers so that it sees what was recorded before it
+* and what is recorded after it sees the sorted keys. The keys are read when the command runs, so a command can be
+* run again once the keys changed.
+*/
+CeResult
+ceRecordSortToCommand(CeSort sort, CeCommand command);
+
+void
+ceDestroySort(CeInstance instance, CeSort sort);
+
+#ifdef __cplusplus
+}
+#endif
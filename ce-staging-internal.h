@@ -0,0 +1,33 @@
+#pragma once
+#include "ce-def.h"
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan_core.h>
+
+/*
+* The staging ring is a host-visible buffer owned by the instance which is used to move
+* data in and out of bindings that live in memory the host cannot map.
+* Copies are recorded into a single command buffer and are only submitted when the ring
+* runs out of space or when it is explicitly flushed.
+* The ring can be used from several threads, each call holds the ring's lock.
+*/
+typedef struct CeStagingRing_t *CeStagingRing;
+
+#define CE_DEFAULT_STAGING_BUFFER_SIZE ((VkDeviceSize)8 << 20)
+
+VkResult
+ceCreateStagingRing(CeInstance, VkDeviceSize size, CeStagingRing*);
+
+//queue an upload of size bytes from pData into dstBuffer at dstOffset
+VkResult
+ceStagingUpload(CeInstance, CeStagingRing, VkBuffer dstBuffer, VkDeviceSize dstOffset, const void* pData, VkDeviceSize size);
+
+//queue a readback of size bytes from srcBuffer at srcOffset, pData is only written once the ring is flushed
+VkResult
+ceStagingDownload(CeInstance, CeStagingRing, VkBuffer srcBuffer, VkDeviceSize srcOffset, void* pData, VkDeviceSize size);
+
+//submit every queued copy and wait for it to complete
+VkResult
+ceFlushStagingRing(CeInstance, CeStagingRing);
+
+void
+ceDestroyStagingRing(CeInstance, CeStagingRing);
@@ -0,0 +1,267 @@
+#include "ce-staging-internal.h"
+#include "ce-def.h"
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan_core.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "ce-instance-internal.h"
+#include "ce-trace-internal.h"
+
+struct CeStagingReadback {
+    void* pTarget;
+    VkDeviceSize stagingOffset;
+    VkDeviceSize size;
+};
+
+struct CeStagingRing_t {
+    VkBuffer vulkanBuffer;
+    VkDeviceMemory vulkanMemory;
+    void* mappedData;
+    VkDeviceSize size;
+    VkDeviceSize head;
+    //the ring records to a pool of its own, every access to it is serialized by the ring's lock
+    VkCommandPool vulkanCommandPool;
+    VkCommandBuffer commandBuffer;
+    VkFence commandFence;
+    pthread_mutex_t mutex;
+    CeBool32 isRecording;
+    struct CeStagingReadback* readbacks;
+    uint32_t readbackCount;
+    uint32_t readbackCapacity;
+};
+
+VkResult
+ceCreateStagingRing(CeInstance instance, VkDeviceSize size, CeStagingRing* target) {
+    VkResult result;
+    VkDevice device = ceGetInstanceVulkanDevice(instance);
+    CeStagingRing ring = calloc(1, sizeof(struct CeStagingRing_t));
+    ring->size = size ? size : CE_DEFAULT_STAGING_BUFFER_SIZE;
+    pthread_mutex_init(&ring->mutex, NULL);
+    *target = ring;
+
+    VkBufferCreateInfo bufferInfo = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size = ring->size,
+        .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+    result = vkCreateBuffer(device, &bufferInfo, NULL, &ring->vulkanBuffer);
+    if(result != VK_SUCCESS)
+        return result;
+
+    VkMemoryRequirements memoryRequirements;
+    vkGetBufferMemoryRequirements(device, ring->vulkanBuffer, &memoryRequirements);
+    VkMemoryAllocateInfo allocInfo = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .allocationSize = memoryRequirements.size,
+        .memoryTypeIndex = ceGetInstanceMemoryTypeIndex(instance, memoryRequirements.memoryTypeBits,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT),
+    };
+    if(allocInfo.memoryTypeIndex == CE_INVALID_MEMORY_TYPE)
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    result = vkAllocateMemory(device, &allocInfo, NULL, &ring->vulkanMemory);
+    if(result != VK_SUCCESS)
+        return result;
+    result = vkBindBufferMemory(device, ring->vulkanBuffer, ring->vulkanMemory, 0);
+    if(result != VK_SUCCESS)
+        return result;
+    result = vkMapMemory(device, ring->vulkanMemory, 0, ring->size, 0, &ring->mappedData);
+    if(result != VK_SUCCESS)
+        return result;
+
+    VkCommandPoolCreateInfo poolInfo = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .queueFamilyIndex = ceGetInstanceVulkanQueueFamilyIndex(instance),
+        .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+    };
+    result = vkCreateCommandPool(device, &poolInfo, NULL, &ring->vulkanCommandPool);
+    if(result != VK_SUCCESS)
+        return result;
+    VkCommandBufferAllocateInfo commandInfo = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .commandPool = ring->vulkanCommandPool,
+        .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+        .commandBufferCount = 1,
+    };
+    result = vkAllocateCommandBuffers(device, &commandInfo, &ring->commandBuffer);
+    if(result != VK_SUCCESS)
+        return result;
+
+    VkFenceCreateInfo fenceInfo = {
+        .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO
+    };
+    return vkCreateFence(device, &fenceInfo, NULL, &ring->commandFence);
+}
+
+static VkResult __beginStagingCommand(CeStagingRing ring) {
+    if(ring->isRecording)
+        return VK_SUCCESS;
+    VkCommandBufferBeginInfo beginInfo = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+    };
+    VkResult result = vkBeginCommandBuffer(ring->commandBuffer, &beginInfo);
+    if(result != VK_SUCCESS)
+        return result;
+    //whatever ran before on the device has to be finished writing before we copy from/to it
+    VkMemoryBarrier barrier = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT,
+    };
+    vkCmdPipelineBarrier(ring->commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0, 1, &barrier, 0, NULL, 0, NULL);
+    ring->isRecording = CE_TRUE;
+    return VK_SUCCESS;
+}
+
+static VkResult __flushStagingRing(CeInstance, CeStagingRing);
+
+//returns the offset inside the ring where a copy of at most size bytes can go, flushing if the ring is full
+static VkResult __reserveStagingSpace(CeInstance instance, CeStagingRing ring, VkDeviceSize size, VkDeviceSize* offset, VkDeviceSize* reserved) {
+    VkResult result;
+    if(ring->head >= ring->size) {
+        result = __flushStagingRing(instance, ring);
+        if(result != VK_SUCCESS)
+            return result;
+    }
+    result = __beginStagingCommand(ring);
+    if(result != VK_SUCCESS)
+        return result;
+    *offset = ring->head;
+    *reserved = size < ring->size - ring->head ? size : ring->size - ring->head;
+    //keep every copy 16 byte aligned inside the ring
+    ring->head += (*reserved + 15) & ~((VkDeviceSize)15);
+    return VK_SUCCESS;
+}
+
+static VkResult __stagingUpload(CeInstance instance, CeStagingRing ring, VkBuffer dstBuffer, VkDeviceSize dstOffset, const void* pData, VkDeviceSize size) {
+    VkDeviceSize done = 0;
+    while(done < size) {
+        VkDeviceSize offset, chunk;
+        VkResult result = __reserveStagingSpace(instance, ring, size - done, &offset, &chunk);
+        if(result != VK_SUCCESS)
+            return result;
+        memcpy((char*)ring->mappedData + offset, (const char*)pData + done, chunk);
+        VkBufferCopy region = {
+            .srcOffset = offset,
+            .dstOffset = dstOffset + done,
+            .size = chunk,
+        };
+        vkCmdCopyBuffer(ring->commandBuffer, ring->vulkanBuffer, dstBuffer, 1, &region);
+        done += chunk;
+    }
+    return VK_SUCCESS;
+}
+
+static VkResult __stagingDownload(CeInstance instance, CeStagingRing ring, VkBuffer srcBuffer, VkDeviceSize srcOffset, void* pData, VkDeviceSize size) {
+    VkDeviceSize done = 0;
+    while(done < size) {
+        VkDeviceSize offset, chunk;
+        VkResult result = __reserveStagingSpace(instance, ring, size - done, &offset, &chunk);
+        if(result != VK_SUCCESS)
+            return result;
+        VkBufferCopy region = {
+            .srcOffset = srcOffset + done,
+            .dstOffset = offset,
+            .size = chunk,
+        };
+        vkCmdCopyBuffer(ring->commandBuffer, srcBuffer, ring->vulkanBuffer, 1, &region);
+        if(ring->readbackCount == ring->readbackCapacity) {
+            ring->readbackCapacity = ring->readbackCapacity ? ring->readbackCapacity * 2 : 8;
+            ring->readbacks = realloc(ring->readbacks, ring->readbackCapacity * sizeof(struct CeStagingReadback));
+        }
+        ring->readbacks[ring->readbackCount].pTarget = (char*)pData + done;
+        ring->readbacks[ring->readbackCount].stagingOffset = offset;
+        ring->readbacks[ring->readbackCount].size = chunk;
+        ++ring->readbackCount;
+        done += chunk;
+    }
+    return VK_SUCCESS;
+}
+
+static VkResult __flushStagingRing(CeInstance instance, CeStagingRing ring) {
+    if(!ring->isRecording)
+        return VK_SUCCESS;
+    VkDevice device = ceGetInstanceVulkanDevice(instance);
+    //make the copies visible both to the host (readbacks) and to any later submission (uploads)
+    VkMemoryBarrier barrier = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_HOST_READ_BIT | VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT,
+    };
+    vkCmdPipelineBarrier(ring->commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_HOST_BIT | VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &barrier, 0, NULL, 0, NULL);
+    ring->isRecording = CE_FALSE;
+    VkResult result = vkEndCommandBuffer(ring->commandBuffer);
+    if(result != VK_SUCCESS)
+        return result;
+
+    uint64_t traceBegin = ceTraceBegin();
+    VkSubmitInfo subInfo = {
+        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .commandBufferCount = 1,
+        .pCommandBuffers = &ring->commandBuffer
+    };
+    uint32_t queueIndex;
+    result = ceSchedulerSubmit(ceGetInstanceQueueScheduler(instance), 1, &subInfo, ring->commandFence, &queueIndex);
+    if(result != VK_SUCCESS)
+        return result;
+    result = vkWaitForFences(device, 1, &ring->commandFence, VK_TRUE, ~((uint64_t)0));
+    ceSchedulerRelease(ceGetInstanceQueueScheduler(instance), queueIndex);
+    ceTraceEnd("staging transfer", traceBegin);
+    vkResetFences(device, 1, &ring->commandFence);
+    vkResetCommandBuffer(ring->commandBuffer, 0);
+    if(result != VK_SUCCESS)
+        return result;
+
+    for(uint32_t i = 0; i < ring->readbackCount; ++i) {
+        memcpy(ring->readbacks[i].pTarget, (char*)ring->mappedData + ring->readbacks[i].stagingOffset, ring->readbacks[i].size);
+    }
+    ring->readbackCount = 0;
+    ring->head = 0;
+    return VK_SUCCESS;
+}
+
+VkResult
+ceStagingUpload(CeInstance instance, CeStagingRing ring, VkBuffer dstBuffer, VkDeviceSize dstOffset, const void* pData, VkDeviceSize size) {
+    pthread_mutex_lock(&ring->mutex);
+    VkResult result = __stagingUpload(instance, ring, dstBuffer, dstOffset, pData, size);
+    pthread_mutex_unlock(&ring->mutex);
+    return result;
+}
+
+VkResult
+ceStagingDownload(CeInstance instance, CeStagingRing ring, VkBuffer srcBuffer, VkDeviceSize srcOffset, void* pData, VkDeviceSize size) {
+    pthread_mutex_lock(&ring->mutex);
+    VkResult result = __stagingDownload(instance, ring, srcBuffer, srcOffset, pData, size);
+    pthread_mutex_unlock(&ring->mutex);
+    return result;
+}
+
+VkResult
+ceFlushStagingRing(CeInstance instance, CeStagingRing ring) {
+    pthread_mutex_lock(&ring->mutex);
+    VkResult result = __flushStagingRing(instance, ring);
+    pthread_mutex_unlock(&ring->mutex);
+    return result;
+}
+
+void
+ceDestroyStagingRing(CeInstance instance, CeStagingRing ring) {
+    if(!ring)
+        return;
+    VkDevice device = ceGetInstanceVulkanDevice(instance);
+    if(ring->commandFence)
+        vkDestroyFence(device, ring->commandFence, NULL);
+    if(ring->vulkanCommandPool)
+        vkDestroyCommandPool(device, ring->vulkanCommandPool, NULL);
+    if(ring->mappedData)
+        vkUnmapMemory(device, ring->vulkanMemory);
+    vkDestroyBuffer(device, ring->vulkanBuffer, NULL);
+    vkFreeMemory(device, ring->vulkanMemory, NULL);
+    free(ring->readbacks);
+    pthread_mutex_destroy(&ring->mutex);
+    free(ring);
+}
@@ -0,0 +1,236 @@
+#include "ce-stream.h"
+#include "ce-def.h"
+#include <stdlib.h>
+#include <string.h>
+#include "ce-instance.h"
+#include "ce-command.h"
+#include "ce-transfer.h"
+#include "ce-pipeline-internal.h"
+#include "ce-error-internal.h"
+#include "ce-trace-internal.h"
+
+#define CE_DEFAULT_STREAM_BUFFER_COUNT 3
+
+struct CeStreamSlot {
+    CePipeline pipeline;
+    CeCommand command;
+    //the pipeline's live chunk info constant points here
+    CeStreamChunkInfo chunkInfo;
+    //where read back chunks land before they are handed to a sink function
+    void* sinkChunk;
+    CeTransfer upload;
+    CeTransfer download;
+    uint64_t firstElement;
+    uint32_t elementCount;
+    CeBool32 isBusy;
+};
+
+struct CeStream_t {
+    struct CeStreamSlot* slots;
+    uint32_t slotCount;
+    uint32_t chunkElementCount;
+    uint32_t inputElementSize;
+    uint32_t outputElementSize;
+    uint32_t inputBinding;
+    uint32_t outputBinding;
+    //filled by source functions, a single one is enough as uploads copy it away straight away
+    void* sourceChunk;
+};
+
+static CeResult __createSlot(CeInstance instance, const CeStreamCreationArgs* args, CeStream stream, struct CeStreamSlot* slot) {
+    const CePipelineCreationArgs* pipelineArgs = args->pPipelineArgs;
+    CePipelineBindingInfo* bindings = malloc(pipelineArgs->uBindingCount * sizeof(CePipelineBindingInfo));
+    CePipelineConstantInfo* constants = malloc((pipelineArgs->uConstantCount ? pipelineArgs->uConstantCount : 1) * sizeof(CePipelineConstantInfo));
+    if(!bindings || !constants) {
+        free(bindings);
+        free(constants);
+        return ceResult(CE_ERROR_INTERNAL, "stdlib failed to allocate the pipeline arguments of a stream slot");
+    }
+    memcpy(bindings, pipelineArgs->pBindings, pipelineArgs->uBindingCount * sizeof(CePipelineBindingInfo));
+    //chunks are only ever copied in and out, so the streamed bindings stay in the memory the device reads fastest
+    bindings[stream->inputBinding].pInitialData = NULL;
+    bindings[stream->inputBinding].pHostMemory = NULL;
+    bindings[stream->outputBinding].pHostMemory = NULL;
+    bindings[stream->inputBinding].ePlacement = CE_BINDING_PLACEMENT_DEVICE_LOCAL;
+    bindings[stream->inputBinding].bKeepMapped = CE_FALSE;
+    bindings[stream->outputBinding].ePlacement = CE_BINDING_PLACEMENT_DEVICE_LOCAL;
+    bindings[stream->outputBinding].bKeepMapped = CE_FALSE;
+    memcpy(constants, pipelineArgs->pConstants, pipelineArgs->uConstantCount * sizeof(CePipelineConstantInfo));
+    if(args->bWriteChunkInfo) {
+        constants[args->uChunkInfoConstant].pData = &slot->chunkInfo;
+        constants[args->uChunkInfoConstant].bIsLiveConstant = CE_TRUE;
+    }
+    CePipelineCreationArgs slotArgs = *pipelineArgs;
+    slotArgs.pBindings = bindings;
+    slotArgs.pConstants = constants;
+    CePipeline pipeline;
+    CeResult result = ceCreatePipeline(instance, &slotArgs, &pipeline);
+    free(bindings);
+    free(constants);
+    if(result != CE_SUCCESS)
+        return result;
+    slot->pipeline = pipeline;
+    CeCommandCreationArgs commandArgs = {
+        .bIsSecondaryCommand = CE_FALSE,
+    };
+    CeCommand command;
+    if((result = ceCreateCommand(instance, &commandArgs, &command)) != CE_SUCCESS)
+        return result;
+    slot->command = command;
+    CeCommandRecordingArgs recordingArgs = {
+        .bRecordCommand = CE_FALSE,
+        .pSuppliedPipeline = slot->pipeline,
+    };
+    if((result = ceBeginCommand(slot->command)) != CE_SUCCESS)
+        return result;
+    if((result = ceRecordToCommand(&recordingArgs, slot->command)) != CE_SUCCESS)
+        return result;
+    if((result = ceEndCommand(slot->command)) != CE_SUCCESS)
+        return result;
+    slot->sinkChunk = malloc((size_t)stream->chunkElementCount * stream->outputElementSize);
+    if(!slot->sinkChunk)
+        return ceResult(CE_ERROR_INTERNAL, "stdlib failed to allocate the sink chunk of a stream slot");
+    return CE_SUCCESS;
+}
+
+CeResult
+ceCreateStream(CeInstance instance, const CeStreamCreationArgs* args, CeStream* target) {
+    if(!instance || !args || !target || !args->pPipelineArgs)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot create stream: some parameters were NULL");
+    const CePipelineCreationArgs* pipelineArgs = args->pPipelineArgs;
+    if(args->uInputBinding >= pipelineArgs->uBindingCount || args->uOutputBinding >= pipelineArgs->uBindingCount)
+        return ceResult(CE_ERROR_INVALID_ARG, "cannot create stream: streamed binding index out of range");
+    const CePipelineBindingInfo* input = &pipelineArgs->pBindings[args->uInputBinding];
+    const CePipelineBindingInfo* output = &pipelineArgs->pBindings[args->uOutputBinding];
+    if(input->pSuppliedBuffer || output->pSuppliedBuffer)
+        return ceResult(CE_ERROR_INVALID_ARG, "cannot create stream: streamed bindings cannot use supplied buffers");
+    if(!input->uElementCount || input->uElementCount != output->uElementCount)
+        return ceResult(CE_ERROR_INVALID_ARG, "cannot create stream: the streamed bindings must hold the same, non-zero number of elements");
+    if(args->bWriteChunkInfo && (args->uChunkInfoConstant >= pipelineArgs->uConstantCount ||
+        pipelineArgs->pConstants[args->uChunkInfoConstant].uDataSize != sizeof(CeStreamChunkInfo)))
+        return ceResult(CE_ERROR_INVALID_ARG, "cannot create stream: the chunk info constant must be 16 bytes");
+
+    uint64_t traceBegin = ceTraceBegin();
+    CeStream stream = calloc(1, sizeof(struct CeStream_t));
+    if(!stream)
+        return ceResult(CE_ERROR_INTERNAL, "stdlib failed to allocate a stream");
+    stream->chunkElementCount = input->uElementCount;
+    stream->inputElementSize = input->uElementSize;
+    stream->outputElementSize = output->uElementSize;
+    stream->inputBinding = args->uInputBinding;
+    stream->outputBinding = args->uOutputBinding;
+    stream->sourceChunk = malloc((size_t)stream->chunkElementCount * stream->inputElementSize);
+    const uint32_t slotCount = args->uBufferCount ? args->uBufferCount : CE_DEFAULT_STREAM_BUFFER_COUNT;
+    stream->slots = calloc(slotCount, sizeof(struct CeStreamSlot));
+    if(!stream->sourceChunk || !stream->slots) {
+        ceDestroyStream(instance, stream);
+        return ceResult(CE_ERROR_INTERNAL, "stdlib failed to allocate the chunks of a stream");
+    }
+    for(uint32_t i = 0; i < slotCount; ++i) {
+        //counted as it goes so that destroying after a failure only touches the slots which were created
+        stream->slotCount = i + 1;
+        CeResult result = __createSlot(instance, args, stream, &stream->slots[i]);
+        if(result != CE_SUCCESS) {
+            ceDestroyStream(instance, stream);
+            return result;
+        }
+    }
+    ceTraceEnd("ceCreateStream", traceBegin);
+    *target = stream;
+    return CE_SUCCESS;
+}
+
+//waits for the slot's chunk to be read back and hands it to the sink, the slot can be refilled afterwards
+static CeResult __drainSlot(CeInstance instance, CeStream stream, const CeStreamRunArgs* args, struct CeStreamSlot* slot, CeResult result) {
+    if(!slot->isBusy)
+        return result;
+    slot->isBusy = CE_FALSE;
+    CeResult drainResult = ceWaitCommand(instance, slot->command);
+    if(slot->download) {
+        CeResult downloadResult = ceWaitTransfer(instance, slot->download);
+        if(drainResult == CE_SUCCESS)
+            drainResult = downloadResult;
+        ceDestroyTransfer(instance, slot->download);
+        slot->download = NULL;
+    }
+    //the upload is kept until the run which waited for it completed
+    if(slot->upload) {
+        ceDestroyTransfer(instance, slot->upload);
+        slot->upload = NULL;
+    }
+    if(drainResult == CE_SUCCESS && result == CE_SUCCESS && !args->pSink && args->pfnSink)
+        drainResult = args->pfnSink(args->pUserData, slot->firstElement, slot->elementCount, slot->sinkChunk);
+    return result != CE_SUCCESS ? result : drainResult;
+}
+
+//uploads a chunk, runs the pipeline on it once it arrived and reads it back once the run completed, without waiting on any of it
+static CeResult __startSlot(CeInstance instance, CeStream stream, const CeStreamRunArgs* args, struct CeStreamSlot* slot) {
+    slot->chunkInfo.uFirstElementLow = (uint32_t)slot->firstElement;
+    slot->chunkInfo.uFirstElementHigh = (uint32_t)(slot->firstElement >> 32);
+    slot->chunkInfo.uElementCount = slot->elementCount;
+    CeBuffer input = ceGetPipelineBindingBuffer(slot->pipeline, stream->inputBinding);
+    CeBuffer output = ceGetPipelineBindingBuffer(slot->pipeline, stream->outputBinding);
+    CeResult result = CE_SUCCESS;
+    if(args->pSource || args->pfnSource) {
+        const void* source = args->pSource ?
+            (const char*)args->pSource + slot->firstElement * stream->inputElementSize : stream->sourceChunk;
+        if(!args->pSource)
+            result = args->pfnSource(args->pUserData, slot->firstElement, slot->elementCount, stream->sourceChunk);
+        if(result == CE_SUCCESS)
+            result = ceUploadBufferAsync(instance, input, 0, source, (uint64_t)slot->elementCount * stream->inputElementSize, NULL, &slot->upload);
+        if(result == CE_SUCCESS)
+            result = ceAddCommandTransferWait(slot->command, slot->upload);
+    }
+    if(result != CE_SUCCESS)
+        return result;
+    slot->isBusy = CE_TRUE;
+    if((result = ceRunCommand(instance, slot->command)) != CE_SUCCESS)
+        return result;
+    if(args->pSink || args->pfnSink) {
+        void* sink = args->pSink ? (char*)args->pSink + slot->firstElement * stream->outputElementSize : slot->sinkChunk;
+        result = ceDownloadBufferAsync(instance, output, 0, sink, (uint64_t)slot->elementCount * stream->outputElementSize,
+            slot->command, &slot->download);
+    }
+    return result;
+}
+
+CeResult
+ceRunStream(CeInstance instance, CeStream stream, const CeStreamRunArgs* args) {
+    if(!instance || !stream || !args)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot run stream: some parameters were NULL");
+    uint64_t traceBegin = ceTraceBegin();
+    CeResult result = CE_SUCCESS;
+    uint64_t chunk = 0;
+    for(uint64_t firstElement = 0; firstElement < args->uElementCount && result == CE_SUCCESS; firstElement += stream->chunkElementCount, ++chunk) {
+        //the slot's previous chunk went out slotCount chunks ago, by now it is usually read back already
+        struct CeStreamSlot* slot = &stream->slots[chunk % stream->slotCount];
+        result = __drainSlot(instance, stream, args, slot, result);
+        if(result != CE_SUCCESS)
+            break;
+        const uint64_t remaining = args->uElementCount - firstElement;
+        slot->firstElement = firstElement;
+        slot->elementCount = remaining < stream->chunkElementCount ? (uint32_t)remaining : stream->chunkElementCount;
+        result = __startSlot(instance, stream, args, slot);
+    }
+    //the chunks still in flight are waited for in the order they went out, even after a failure
+    for(uint32_t i = 0; i < stream->slotCount; ++i)
+        result = __drainSlot(instance, stream, args, &stream->slots[(chunk + i) % stream->slotCount], result);
+    ceTraceEnd("ceRunStream", traceBegin);
+    return result;
+}
+
+void
+ceDestroyStream(CeInstance instance, CeStream stream) {
+    if(!stream)
+        return;
+    for(uint32_t i = 0; i < stream->slotCount; ++i) {
+        if(stream->slots[i].pipeline)
+            ceDestroyPipeline(instance, stream->slots[i].pipeline);
+        if(stream->slots[i].command)
+            ceDestroyCommand(instance, stream->slots[i].command);
+        free(stream->slots[i].sinkChunk);
+    }
+    free(stream->slots);
+    free(stream->sourceChunk);
+    free(stream);
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include "ce-def.h"
+#include "ce-pipeline.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//what the chunk info push constant holds, a uvec4 in GLSL
+typedef struct {
+    uint32_t uFirstElementLow;
+    uint32_t uFirstElementHigh;
+    uint32_t uElementCount;
+    uint32_t uPadding;
+} CeStreamChunkInfo;
+
+//fills pChunk with uElementCount elements of the input starting at uFirstElement
+typedef CeResult (*CeStreamSourceFunction)(void* pUserData, uint64_t uFirstElement, uint32_t uElementCount, void* pChunk);
+
+//receives uElementCount elements of the output starting at uFirstElement, pChunk is only valid during the call
+typedef CeResult (*CeStreamSinkFunction)(void* pUserData, uint64_t uFirstElement, uint32_t uElementCount, const void* pChunk);
+
+typedef struct {
+    //the pipeline run on every chunk. the streamed bindings' uElementCount is the number of elements in a chunk,
+    //and they cannot use pSuppliedBuffer
+    const CePipelineCreationArgs* pPipelineArgs;
+    //the binding chunks of the input are uploaded to
+    uint32_t uInputBinding;
+    //the binding chunks of the output are read back from, it can be the input binding
+    uint32_t uOutputBinding;
+    //chunks in flight at once, 2 for double buffering and 3 for triple buffering. 0 means 3
+    uint32_t uBufferCount;
+    //if set, the constant at index uChunkInfoConstant, which **must** be 16 bytes, is made live and holds the CeStreamChunkInfo
+    //of the chunk. the shader reads it from the live constant buffer, at binding uBindingCount, not from the push constants
+    CeBool32 bWriteChunkInfo;
+    uint32_t uChunkInfoConstant;
+} CeStreamCreationArgs;
+
+typedef struct {
+    //elements in the whole input and output, it can be far larger than what the device holds
+    uint64_t uElementCount;
+    //the input is read from pSource if it is not NULL, from pfnSource otherwise. if both are NULL nothing is uploaded
+    const void* pSource;
+    CeStreamSourceFunction pfnSource;
+    //the output is written to pSink if it is not NULL, to pfnSink otherwise. if both are NULL nothing is read back
+    void* pSink;
+    CeStreamSinkFunction pfnSink;
+    void* pUserData;
+} CeStreamRunArgs;
+
+/**
+* Create a stream, which runs a pipeline over data too large for the device by splitting it in chunks.
+* Each of the uBufferCount chunks in flight has its own copy of the pipeline, so that one chunk is uploaded,
+* another one is processed and another one is read back at the same time.
+* \param instance the instance the stream runs on
+* \param args pointer to a CeStreamCreationArgs structure
+* \param stream the handle the function writes to
+*/
+CeResult
+ceCreateStream(CeInstance instance, const CeStreamCreationArgs* args, CeStream* stream);
+
+/**
+* Run the stream's pipeline over every chunk of an input, and return once every chunk of the output was written.
+* The last chunk may be shorter than the others, its whole binding is still dispatched:
+* kernels which do not take the chunk info read stale data past its end, which is never written back.
+* If a source or sink function fails the stream stops, and its result is returned.
+*/
+CeResult
+ceRunStream(CeInstance instance, CeStream stream, const CeStreamRunArgs* args);
+
+void
+ceDestroyStream(CeInstance instance, CeStream stream);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,168 @@
+#include "ce-command.h"
+#include "ce-def.h"
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan_core.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
+#include "ce-command-internal.h"
+#include "ce-error-internal.h"
+
+#define CE_DEFAULT_BATCH_COMMAND_COUNT 64
+
+struct CeSubmitBatch_t {
+    CeInstance instance;
+    pthread_mutex_t mutex;
+    //signalled when the first command is queued and when the batch is destroyed
+    pthread_cond_t condition;
+    CeCommand* commands;
+    uint32_t commandCount;
+    uint32_t maxCommandCount;
+    uint64_t maxDelayNs;
+    //when the first of the queued commands was queued
+    struct timespec firstQueuedTime;
+    //only started when the batch has a delay threshold
+    pthread_t thread;
+    CeBool32 threadStarted;
+    CeBool32 stopping;
+    //the first failure of a flush done by the thread, returned by the next explicit flush
+    CeResult threadFlushResult;
+};
+
+//the batch's lock must be held
+static CeResult __flushLocked(CeSubmitBatch batch) {
+    if(!batch->commandCount)
+        return CE_SUCCESS;
+    CeResult result = ceSubmitCommands(batch->instance, batch->commands, batch->commandCount);
+    //commands are let go even if the submission failed, waiting on or querying them then returns the failure
+    for(uint32_t i = 0; i < batch->commandCount; ++i) {
+        if(result != CE_SUCCESS)
+            ceSetCommandQueuedRunResult(batch->commands[i], result);
+        ceSetCommandQueuedBatch(batch->commands[i], NULL);
+    }
+    batch->commandCount = 0;
+    return result;
+}
+
+static void* __delayThread(void* pBatch) {
+    CeSubmitBatch batch = pBatch;
+    pthread_mutex_lock(&batch->mutex);
+    while(!batch->stopping) {
+        if(!batch->commandCount) {
+            pthread_cond_wait(&batch->condition, &batch->mutex);
+            continue;
+        }
+        struct timespec deadline = batch->firstQueuedTime;
+        deadline.tv_sec += batch->maxDelayNs / 1000000000ull;
+        deadline.tv_nsec += batch->maxDelayNs % 1000000000ull;
+        if(deadline.tv_nsec >= 1000000000l) {
+            ++deadline.tv_sec;
+            deadline.tv_nsec -= 1000000000l;
+        }
+        //the wait also ends early when the batch is flushed and refilled, the deadline is then recomputed
+        if(pthread_cond_timedwait(&batch->condition, &batch->mutex, &deadline) == ETIMEDOUT) {
+            CeResult result = __flushLocked(batch);
+            if(batch->threadFlushResult == CE_SUCCESS)
+                batch->threadFlushResult = result;
+        }
+    }
+    pthread_mutex_unlock(&batch->mutex);
+    return NULL;
+}
+
+CeResult
+ceCreateSubmitBatch(CeInstance instance, const CeSubmitBatchCreationArgs* args, CeSubmitBatch* target) {
+    if(!instance || !args || !target)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot create submit batch: some parameters were NULL");
+    CeSubmitBatch batch = calloc(1, sizeof(struct CeSubmitBatch_t));
+    if(!batch)
+        return ceResult(CE_ERROR_INTERNAL, "stdlib failed to allocate a submit batch");
+    batch->instance = instance;
+    batch->maxCommandCount = args->uMaxCommandCount ? args->uMaxCommandCount : CE_DEFAULT_BATCH_COMMAND_COUNT;
+    batch->maxDelayNs = args->uMaxDelayNs;
+    batch->commands = malloc(batch->maxCommandCount * sizeof(CeCommand));
+    if(!batch->commands) {
+        free(batch);
+        return ceResult(CE_ERROR_INTERNAL, "stdlib failed to allocate a submit batch");
+    }
+    pthread_mutex_init(&batch->mutex, NULL);
+    //deadlines are measured on the monotonic clock so that wall clock changes do not delay flushes
+    pthread_condattr_t conditionAttributes;
+    pthread_condattr_init(&conditionAttributes);
+    pthread_condattr_setclock(&conditionAttributes, CLOCK_MONOTONIC);
+    pthread_cond_init(&batch->condition, &conditionAttributes);
+    pthread_condattr_destroy(&conditionAttributes);
+    if(batch->maxDelayNs) {
+        if(pthread_create(&batch->thread, NULL, __delayThread, batch)) {
+            ceDestroySubmitBatch(instance, batch);
+            return ceResult(CE_ERROR_INTERNAL, "cannot create submit batch: failed to start its flushing thread");
+        }
+        batch->threadStarted = CE_TRUE;
+    }
+    *target = batch;
+    return CE_SUCCESS;
+}
+
+CeResult
+ceQueueCommand(CeInstance instance, CeSubmitBatch batch, CeCommand command) {
+    if(!instance || !batch || !command)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot queue command: some parameters were NULL");
+    //a command can only be part of one pending submission, the previous one goes first
+    CeSubmitBatch previousBatch = ceGetCommandQueuedBatch(command);
+    if(previousBatch) {
+        CeResult result = ceFlushSubmitBatch(instance, previousBatch);
+        if(result != CE_SUCCESS)
+            return result;
+    }
+    CeResult result = CE_SUCCESS;
+    pthread_mutex_lock(&batch->mutex);
+    if(!batch->commandCount) {
+        clock_gettime(CLOCK_MONOTONIC, &batch->firstQueuedTime);
+        pthread_cond_signal(&batch->condition);
+    }
+    batch->commands[batch->commandCount++] = command;
+    ceSetCommandQueuedBatch(command, batch);
+    if(batch->commandCount == batch->maxCommandCount)
+        result = __flushLocked(batch);
+    pthread_mutex_unlock(&batch->mutex);
+    return result;
+}
+
+CeResult
+ceFlushSubmitBatch(CeInstance instance, CeSubmitBatch batch) {
+    if(!instance || !batch)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot flush submit batch: some parameters were NULL");
+    pthread_mutex_lock(&batch->mutex);
+    CeResult result = __flushLocked(batch);
+    if(result == CE_SUCCESS)
+        result = batch->threadFlushResult;
+    batch->threadFlushResult = CE_SUCCESS;
+    pthread_mutex_unlock(&batch->mutex);
+    return result;
+}
+
+CeResult
+ceSubmitQueuedCommands(CeSubmitBatch batch) {
+    pthread_mutex_lock(&batch->mutex);
+    CeResult result = __flushLocked(batch);
+    pthread_mutex_unlock(&batch->mutex);
+    return result;
+}
+
+void
+ceDestroySubmitBatch(CeInstance instance, CeSubmitBatch batch) {
+    if(!batch)
+        return;
+    pthread_mutex_lock(&batch->mutex);
+    batch->stopping = CE_TRUE;
+    pthread_cond_signal(&batch->condition);
+    pthread_mutex_unlock(&batch->mutex);
+    if(batch->threadStarted)
+        pthread_join(batch->thread, NULL);
+    __flushLocked(batch);
+    pthread_mutex_destroy(&batch->mutex);
+    pthread_cond_destroy(&batch->condition);
+    free(batch->commands);
+    free(batch);
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include "ce-def.h"
+#include "ce-trace.h"
+
+//returns the current time if tracing is on and 0 otherwise, to be passed to ceTraceEnd
+uint64_t
+ceTraceBegin(void);
+
+//records a span on the calling thread, pName **must** be a string literal
+void
+ceTraceEnd(const char* pName, uint64_t uBegin);
+
+//records a span that ran on the GPU, with times already converted to the host clock
+void
+ceTraceGpuSpan(const char* pName, uint64_t uBegin, uint64_t uEnd, uint64_t uId);
+
+CeBool32
+ceIsTracingEnabled(void);
+
+//the clock every span is measured with, in nanoseconds
+uint64_t
+ceTraceNow(void);
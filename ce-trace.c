@@ -0,0 +1,190 @@
+#include "ce-trace.h"
+#include "ce-def.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "ce-trace-internal.h"
+#include "ce-error-internal.h"
+
+#define CE_TRACE_BUFFER_CAPACITY 16384
+//thread id of the track GPU spans are shown on
+#define CE_TRACE_GPU_THREAD_ID 0
+
+struct CeTraceEvent {
+    const char* pName;
+    uint64_t begin;
+    uint64_t end;
+    uint64_t id;
+};
+
+//every thread that records a span gets one of these, the oldest events are overwritten once it is full
+struct CeTraceBuffer {
+    struct CeTraceBuffer* next;
+    //set while the thread the buffer belonged to exited and no other thread took it over
+    struct CeTraceBuffer* nextOrphan;
+    pthread_mutex_t mutex;
+    uint32_t threadId;
+    uint32_t head;
+    uint32_t count;
+    struct CeTraceEvent events[CE_TRACE_BUFFER_CAPACITY];
+};
+
+static atomic_int traceEnabled = 0;
+static atomic_uint nextThreadId = CE_TRACE_GPU_THREAD_ID + 1;
+static pthread_mutex_t traceBuffersMutex = PTHREAD_MUTEX_INITIALIZER;
+static struct CeTraceBuffer* traceBuffers = NULL;
+//buffers of exited threads, handed to the next thread recording a span
+static struct CeTraceBuffer* orphanTraceBuffers = NULL;
+static _Thread_local struct CeTraceBuffer* threadTraceBuffer = NULL;
+static struct CeTraceBuffer* gpuTraceBuffer = NULL;
+//its destructor orphans the buffer of a thread which exits
+static pthread_key_t traceBufferKey;
+static pthread_once_t traceBufferKeyOnce = PTHREAD_ONCE_INIT;
+
+uint64_t
+ceTraceNow(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+CeBool32
+ceIsTracingEnabled(void) {
+    return atomic_load_explicit(&traceEnabled, memory_order_relaxed) != 0;
+}
+
+//traceBuffersMutex must be held
+static struct CeTraceBuffer* __createTraceBuffer(uint32_t threadId) {
+    struct CeTraceBuffer* buffer = calloc(1, sizeof(struct CeTraceBuffer));
+    if(!buffer)
+        return NULL;
+    pthread_mutex_init(&buffer->mutex, NULL);
+    buffer->threadId = threadId;
+    buffer->next = traceBuffers;
+    traceBuffers = buffer;
+    return buffer;
+}
+
+static void __orphanTraceBuffer(void* pBuffer) {
+    struct CeTraceBuffer* buffer = pBuffer;
+    pthread_mutex_lock(&traceBuffersMutex);
+    buffer->nextOrphan = orphanTraceBuffers;
+    orphanTraceBuffers = buffer;
+    pthread_mutex_unlock(&traceBuffersMutex);
+}
+
+static void __createTraceBufferKey(void) {
+    pthread_key_create(&traceBufferKey, __orphanTraceBuffer);
+}
+
+//threads coming and going reuse the buffers of exited ones, which keep their events and track
+static struct CeTraceBuffer* __acquireThreadTraceBuffer(void) {
+    pthread_once(&traceBufferKeyOnce, __createTraceBufferKey);
+    pthread_mutex_lock(&traceBuffersMutex);
+    struct CeTraceBuffer* buffer = orphanTraceBuffers;
+    if(buffer)
+        orphanTraceBuffers = buffer->nextOrphan;
+    else
+        buffer = __createTraceBuffer(atomic_fetch_add(&nextThreadId, 1));
+    pthread_mutex_unlock(&traceBuffersMutex);
+    if(buffer)
+        pthread_setspecific(traceBufferKey, buffer);
+    return buffer;
+}
+
+static void __pushTraceEvent(struct CeTraceBuffer* buffer, const char* pName, uint64_t begin, uint64_t end, uint64_t id) {
+    pthread_mutex_lock(&buffer->mutex);
+    buffer->events[buffer->head] = (struct CeTraceEvent){
+        .pName = pName,
+        .begin = begin,
+        .end = end,
+        .id = id,
+    };
+    buffer->head = (buffer->head + 1) % CE_TRACE_BUFFER_CAPACITY;
+    if(buffer->count < CE_TRACE_BUFFER_CAPACITY)
+        ++buffer->count;
+    pthread_mutex_unlock(&buffer->mutex);
+}
+
+uint64_t
+ceTraceBegin(void) {
+    if(!ceIsTracingEnabled())
+        return 0;
+    return ceTraceNow();
+}
+
+void
+ceTraceEnd(const char* pName, uint64_t uBegin) {
+    //spans which began while tracing was off are dropped
+    if(!uBegin || !ceIsTracingEnabled())
+        return;
+    uint64_t end = ceTraceNow();
+    if(!threadTraceBuffer)
+        threadTraceBuffer = __acquireThreadTraceBuffer();
+    if(threadTraceBuffer)
+        __pushTraceEvent(threadTraceBuffer, pName, uBegin, end, 0);
+}
+
+void
+ceTraceGpuSpan(const char* pName, uint64_t uBegin, uint64_t uEnd, uint64_t uId) {
+    if(!ceIsTracingEnabled())
+        return;
+    pthread_mutex_lock(&traceBuffersMutex);
+    if(!gpuTraceBuffer)
+        gpuTraceBuffer = __createTraceBuffer(CE_TRACE_GPU_THREAD_ID);
+    struct CeTraceBuffer* buffer = gpuTraceBuffer;
+    pthread_mutex_unlock(&traceBuffersMutex);
+    if(buffer)
+        __pushTraceEvent(buffer, pName, uBegin, uEnd, uId);
+}
+
+CeResult
+ceEnableTracing(CeBool32 bEnable) {
+    atomic_store(&traceEnabled, bEnable ? 1 : 0);
+    return CE_SUCCESS;
+}
+
+CeResult
+ceExportTrace(const char* pFilename) {
+    if(!pFilename)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot export trace: no filename passed");
+    FILE* file = fopen(pFilename, "w");
+    if(!file)
+        return ceResult(CE_ERROR_INTERNAL, "stdlib failed to open the trace file");
+    fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"GPU\"}}", CE_TRACE_GPU_THREAD_ID);
+    pthread_mutex_lock(&traceBuffersMutex);
+    for(struct CeTraceBuffer* buffer = traceBuffers; buffer; buffer = buffer->next) {
+        pthread_mutex_lock(&buffer->mutex);
+        uint32_t index = (buffer->head + CE_TRACE_BUFFER_CAPACITY - buffer->count) % CE_TRACE_BUFFER_CAPACITY;
+        for(uint32_t i = 0; i < buffer->count; ++i) {
+            const struct CeTraceEvent* event = &buffer->events[(index + i) % CE_TRACE_BUFFER_CAPACITY];
+            //trace event times are in microseconds
+            fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"ce\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f",
+                event->pName, buffer->threadId,
+                event->begin / 1000.0, (event->end - event->begin) / 1000.0);
+            if(event->id)
+                fprintf(file, ",\"args\":{\"id\":\"0x%llx\"}", (unsigned long long)event->id);
+            fprintf(file, "}");
+        }
+        pthread_mutex_unlock(&buffer->mutex);
+    }
+    pthread_mutex_unlock(&traceBuffersMutex);
+    fprintf(file, "\n]}\n");
+    if(fclose(file) != 0)
+        return ceResult(CE_ERROR_INTERNAL, "stdlib failed to write the trace file");
+    return CE_SUCCESS;
+}
+
+void
+ceClearTrace(void) {
+    pthread_mutex_lock(&traceBuffersMutex);
+    for(struct CeTraceBuffer* buffer = traceBuffers; buffer; buffer = buffer->next) {
+        pthread_mutex_lock(&buffer->mutex);
+        buffer->head = buffer->count = 0;
+        pthread_mutex_unlock(&buffer->mutex);
+    }
+    pthread_mutex_unlock(&traceBuffersMutex);
+}
@@ -0,0 +1,33 @@
+#pragma once
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include "ce-def.h"
+
+/**
+* Turn CE's internal tracing on or off. Tracing is off by default.
+* While it is on, CE records how long its internal steps take (shader loading, pipeline compilation,
+* memory allocation, submissions, waits...) into per-thread ring buffers.
+* \param bEnable CE_TRUE to start recording, CE_FALSE to stop
+*/
+CeResult
+ceEnableTracing(CeBool32 bEnable);
+
+/**
+* Write every recorded span to a file in the Chrome trace event format,
+* which can be opened with chrome://tracing or https://ui.perfetto.dev.
+* GPU timings of profiled commands are included on their own track.
+* \param pFilename the file the trace is written to
+*/
+CeResult
+ceExportTrace(const char* pFilename);
+
+/**
+* Discard every recorded span.
+*/
+void
+ceClearTrace(void);
+
+#ifdef __cplusplus
+}
+#endif
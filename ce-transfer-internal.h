@@ -0,0 +1,9 @@
+#pragma once
+#include "ce-def.h"
+#include "ce-transfer.h"
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan_core.h>
+
+//the semaphore signalled to value once the transfer completed, VK_NULL_HANDLE without timeline semaphores
+void
+ceGetTransferSemaphore(CeTransfer, VkSemaphore*, uint64_t* pValue);
@@ -0,0 +1,412 @@
+#include "ce-transfer.h"
+#include "ce-def.h"
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan_core.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "ce-transfer-internal.h"
+#include "ce-instance-internal.h"
+#include "ce-buffer-internal.h"
+#include "ce-command-internal.h"
+#include "ce-command-pool-internal.h"
+#include "ce-memory-internal.h"
+#include "ce-queue-internal.h"
+#include "ce-error-internal.h"
+#include "ce-trace-internal.h"
+
+#define CE_TRANSFER_MAX_STAGES 3
+
+struct CeTransferStage {
+    CeCommandPool commandPool;
+    VkCommandBuffer commandBuffer;
+    CeQueueScheduler scheduler;
+    uint32_t queueIndex;
+};
+
+struct CeTransfer_t {
+    VkBuffer stagingBuffer;
+    CeMemoryAllocation stagingAllocation;
+    //where a download is copied to once it completed, NULL for uploads
+    void* pReadbackTarget;
+    VkDeviceSize size;
+    //when the transfer family is not the compute family the buffer is released by a compute queue,
+    //copied on a transfer queue and acquired back by a compute queue, otherwise there is only the copy
+    struct CeTransferStage stages[CE_TRANSFER_MAX_STAGES];
+    uint32_t stageCount;
+    //signalled to i + 1 by stage i, VK_NULL_HANDLE without timeline semaphores
+    VkSemaphore timelineSemaphore;
+    //without timeline semaphores the stages are chained by binary semaphores and the last one signals the fence
+    VkSemaphore stageSemaphores[CE_TRANSFER_MAX_STAGES - 1];
+    VkFence fence;
+    //set once the queues the stages ran on were given back to their scheduler
+    atomic_bool isFinished;
+};
+
+static VkResult __createStagingBuffer(CeInstance instance, CeTransfer transfer) {
+    VkDevice device = ceGetInstanceVulkanDevice(instance);
+    VkBufferCreateInfo bufferInfo = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size = transfer->size,
+        .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+    VkResult result = vkCreateBuffer(device, &bufferInfo, NULL, &transfer->stagingBuffer);
+    if(result != VK_SUCCESS)
+        return result;
+    VkMemoryRequirements memoryRequirements;
+    vkGetBufferMemoryRequirements(device, transfer->stagingBuffer, &memoryRequirements);
+    const VkMemoryPropertyFlags hostFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    uint32_t memoryType = CE_INVALID_MEMORY_TYPE;
+    //the host reads downloads back, which is much faster from cached memory
+    if(transfer->pReadbackTarget)
+        memoryType = ceGetInstanceMemoryTypeIndex(instance, memoryRequirements.memoryTypeBits, hostFlags | VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
+    if(memoryType == CE_INVALID_MEMORY_TYPE)
+        memoryType = ceGetInstanceMemoryTypeIndex(instance, memoryRequirements.memoryTypeBits, hostFlags);
+    if(memoryType == CE_INVALID_MEMORY_TYPE)
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    result = ceArenaAllocate(instance, ceGetInstanceMemoryArena(instance), &memoryRequirements, memoryType, &transfer->stagingAllocation);
+    if(result != VK_SUCCESS)
+        return result;
+    return vkBindBufferMemory(device, transfer->stagingBuffer, transfer->stagingAllocation.vulkanMemory, transfer->stagingAllocation.offset);
+}
+
+//release barriers ignore the destination stage and access, acquire barriers the source ones
+static void __ownershipBarrier(VkCommandBuffer commandBuffer, VkBuffer buffer, uint32_t srcFamily, uint32_t dstFamily,
+    VkPipelineStageFlags srcStage, VkAccessFlags srcAccess, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess) {
+    VkBufferMemoryBarrier barrier = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+        .srcAccessMask = srcAccess,
+        .dstAccessMask = dstAccess,
+        .srcQueueFamilyIndex = srcFamily,
+        .dstQueueFamilyIndex = dstFamily,
+        .buffer = buffer,
+        .offset = 0,
+        .size = VK_WHOLE_SIZE,
+    };
+    vkCmdPipelineBarrier(commandBuffer, srcStage, dstStage, 0, 0, NULL, 1, &barrier, 0, NULL);
+}
+
+static VkResult __beginStage(CeInstance instance, CeCommandPoolSet poolSet, CeQueueScheduler scheduler, struct CeTransferStage* stage) {
+    stage->scheduler = scheduler;
+    stage->queueIndex = CE_NO_QUEUE;
+    VkResult result = ceAllocateCommandBuffer(instance, poolSet, VK_COMMAND_BUFFER_LEVEL_PRIMARY, &stage->commandPool, &stage->commandBuffer);
+    if(result != VK_SUCCESS)
+        return result;
+    VkCommandBufferBeginInfo beginInfo = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+    };
+    ceLockCommandPool(stage->commandPool);
+    result = vkBeginCommandBuffer(stage->commandBuffer, &beginInfo);
+    if(result != VK_SUCCESS)
+        ceUnlockCommandPool(stage->commandPool);
+    return result;
+}
+
+static VkResult __endStage(struct CeTransferStage* stage) {
+    VkResult result = vkEndCommandBuffer(stage->commandBuffer);
+    ceUnlockCommandPool(stage->commandPool);
+    return result;
+}
+
+static VkResult __recordCopyStage(CeInstance instance, CeTransfer transfer, VkBuffer buffer, VkDeviceSize offset, CeBool32 isCrossFamily,
+    struct CeTransferStage* stage) {
+    const uint32_t computeFamily = ceGetInstanceVulkanQueueFamilyIndex(instance);
+    const uint32_t transferFamily = ceGetInstanceTransferQueueFamilyIndex(instance);
+    VkResult result = __beginStage(instance, ceGetInstanceTransferCommandPoolSet(instance), ceGetInstanceTransferQueueScheduler(instance), stage);
+    if(result != VK_SUCCESS)
+        return result;
+    if(isCrossFamily)
+        __ownershipBarrier(stage->commandBuffer, buffer, computeFamily, transferFamily,
+            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT);
+    const CeBool32 isDownload = transfer->pReadbackTarget != NULL;
+    VkBufferCopy region = {
+        .srcOffset = isDownload ? offset : 0,
+        .dstOffset = isDownload ? 0 : offset,
+        .size = transfer->size,
+    };
+    vkCmdCopyBuffer(stage->commandBuffer, isDownload ? buffer : transfer->stagingBuffer, isDownload ? transfer->stagingBuffer : buffer, 1, &region);
+    if(isCrossFamily)
+        __ownershipBarrier(stage->commandBuffer, buffer, transferFamily, computeFamily,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, isDownload ? 0 : VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0);
+    if(isDownload) {
+        VkMemoryBarrier hostBarrier = {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_HOST_READ_BIT,
+        };
+        vkCmdPipelineBarrier(stage->commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &hostBarrier, 0, NULL, 0, NULL);
+    }
+    return __endStage(stage);
+}
+
+static VkResult __recordStages(CeInstance instance, CeTransfer transfer, VkBuffer buffer, VkDeviceSize offset) {
+    const uint32_t computeFamily = ceGetInstanceVulkanQueueFamilyIndex(instance);
+    const uint32_t transferFamily = ceGetInstanceTransferQueueFamilyIndex(instance);
+    if(computeFamily == transferFamily) {
+        transfer->stageCount = 1;
+        return __recordCopyStage(instance, transfer, buffer, offset, CE_FALSE, &transfer->stages[0]);
+    }
+    transfer->stageCount = 3;
+    CeCommandPoolSet computePools = ceGetInstanceCommandPoolSet(instance);
+    CeQueueScheduler computeScheduler = ceGetInstanceQueueScheduler(instance);
+    VkResult result = __beginStage(instance, computePools, computeScheduler, &transfer->stages[0]);
+    if(result != VK_SUCCESS)
+        return result;
+    __ownershipBarrier(transfer->stages[0].commandBuffer, buffer, computeFamily, transferFamily,
+        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_ACCESS_MEMORY_WRITE_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0);
+    result = __endStage(&transfer->stages[0]);
+    if(result != VK_SUCCESS)
+        return result;
+    result = __recordCopyStage(instance, transfer, buffer, offset, CE_TRUE, &transfer->stages[1]);
+    if(result != VK_SUCCESS)
+        return result;
+    result = __beginStage(instance, computePools, computeScheduler, &transfer->stages[2]);
+    if(result != VK_SUCCESS)
+        return result;
+    __ownershipBarrier(transfer->stages[2].commandBuffer, buffer, transferFamily, computeFamily,
+        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT);
+    return __endStage(&transfer->stages[2]);
+}
+
+static VkResult __createSyncObjects(CeInstance instance, CeTransfer transfer) {
+    VkDevice device = ceGetInstanceVulkanDevice(instance);
+    VkResult result;
+    if(ceGetInstanceTimelineSemaphoresEnabled(instance)) {
+        VkSemaphoreTypeCreateInfo timelineInfo = {
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+            .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+            .initialValue = 0,
+        };
+        VkSemaphoreCreateInfo semaphoreInfo = {
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+            .pNext = &timelineInfo,
+        };
+        return vkCreateSemaphore(device, &semaphoreInfo, NULL, &transfer->timelineSemaphore);
+    }
+    VkSemaphoreCreateInfo semaphoreInfo = {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+    };
+    for(uint32_t i = 0; i + 1 < transfer->stageCount; ++i) {
+        result = vkCreateSemaphore(device, &semaphoreInfo, NULL, &transfer->stageSemaphores[i]);
+        if(result != VK_SUCCESS)
+            return result;
+    }
+    VkFenceCreateInfo fenceInfo = {
+        .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO
+    };
+    return vkCreateFence(device, &fenceInfo, NULL, &transfer->fence);
+}
+
+static VkResult __submitStages(CeInstance instance, CeTransfer transfer, CeCommand afterCommand) {
+    VkSemaphore afterSemaphore = VK_NULL_HANDLE;
+    uint64_t afterValue = 0;
+    if(afterCommand) {
+        if(!ceGetCommandLastRunSemaphore(instance, afterCommand, &afterSemaphore, &afterValue))
+            return VK_ERROR_UNKNOWN;
+        //without timeline semaphores the command is waited on by the host instead
+        if(!afterSemaphore && ceWaitCommand(instance, afterCommand) != CE_SUCCESS)
+            return VK_ERROR_UNKNOWN;
+        if(!afterValue)
+            afterSemaphore = VK_NULL_HANDLE;
+    }
+    const CeBool32 useTimeline = transfer->timelineSemaphore != VK_NULL_HANDLE;
+    const VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+    for(uint32_t i = 0; i < transfer->stageCount; ++i) {
+        const CeBool32 isLast = i + 1 == transfer->stageCount;
+        VkSemaphore waitSemaphore = VK_NULL_HANDLE, signalSemaphore = VK_NULL_HANDLE;
+        uint64_t waitValue = i, signalValue = i + 1;
+        if(i == 0) {
+            waitSemaphore = afterSemaphore;
+            waitValue = afterValue;
+        } else {
+            waitSemaphore = useTimeline ? transfer->timelineSemaphore : transfer->stageSemaphores[i - 1];
+        }
+        if(useTimeline)
+            signalSemaphore = transfer->timelineSemaphore;
+        else if(!isLast)
+            signalSemaphore = transfer->stageSemaphores[i];
+        VkTimelineSemaphoreSubmitInfo timelineInfo = {
+            .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+            .waitSemaphoreValueCount = waitSemaphore ? 1 : 0,
+            .pWaitSemaphoreValues = &waitValue,
+            .signalSemaphoreValueCount = signalSemaphore ? 1 : 0,
+            .pSignalSemaphoreValues = &signalValue,
+        };
+        VkSubmitInfo subInfo = {
+            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            .pNext = useTimeline ? &timelineInfo : NULL,
+            .waitSemaphoreCount = waitSemaphore ? 1 : 0,
+            .pWaitSemaphores = &waitSemaphore,
+            .pWaitDstStageMask = &waitStage,
+            .commandBufferCount = 1,
+            .pCommandBuffers = &transfer->stages[i].commandBuffer,
+            .signalSemaphoreCount = signalSemaphore ? 1 : 0,
+            .pSignalSemaphores = &signalSemaphore,
+        };
+        VkResult result = ceSchedulerSubmit(transfer->stages[i].scheduler, 1, &subInfo, isLast ? transfer->fence : VK_NULL_HANDLE,
+            &transfer->stages[i].queueIndex);
+        if(result != VK_SUCCESS) {
+            //the stages already submitted would never be waited on otherwise
+            if(i)
+                vkDeviceWaitIdle(ceGetInstanceVulkanDevice(instance));
+            return result;
+        }
+    }
+    return VK_SUCCESS;
+}
+
+static void __releaseStageQueues(CeTransfer transfer) {
+    if(atomic_exchange(&transfer->isFinished, CE_TRUE))
+        return;
+    for(uint32_t i = 0; i < transfer->stageCount; ++i) {
+        if(transfer->stages[i].queueIndex != CE_NO_QUEUE)
+            ceSchedulerRelease(transfer->stages[i].scheduler, transfer->stages[i].queueIndex);
+    }
+}
+
+static CeResult __startTransfer(CeInstance instance, CeBuffer buffer, uint64_t offset, const void* pUploadData, void* pReadbackTarget,
+    uint64_t size, CeCommand afterCommand, CeTransfer* target) {
+    if(!size || offset + size > ceGetBufferSize(buffer))
+        return ceResult(CE_ERROR_INVALID_ARG, "cannot start transfer: the range is empty or goes past the end of the buffer");
+    uint64_t traceBegin = ceTraceBegin();
+    CeTransfer transfer = calloc(1, sizeof(struct CeTransfer_t));
+    if(!transfer)
+        return ceResult(CE_ERROR_INTERNAL, "stdlib failed to allocate a transfer");
+    transfer->size = size;
+    transfer->pReadbackTarget = pReadbackTarget;
+    atomic_init(&transfer->isFinished, CE_FALSE);
+    //CPU commands are done when their run returns, so the copy can be made right away
+    char* cpuMemory = ceGetBufferCpuMemory(buffer);
+    if(cpuMemory) {
+        if(pUploadData)
+            memcpy(cpuMemory + offset, pUploadData, size);
+        else
+            memcpy(pReadbackTarget, cpuMemory + offset, size);
+        atomic_store(&transfer->isFinished, CE_TRUE);
+        *target = transfer;
+        return CE_SUCCESS;
+    }
+    if(__createStagingBuffer(instance, transfer) != VK_SUCCESS) {
+        ceDestroyTransfer(instance, transfer);
+        return ceResult(CE_ERROR_INTERNAL, "Vk failed to create the staging buffer of a transfer");
+    }
+    if(pUploadData)
+        memcpy(transfer->stagingAllocation.mappedData, pUploadData, size);
+    if(__recordStages(instance, transfer, ceGetBufferVulkanBuffer(buffer), offset) != VK_SUCCESS ||
+        __createSyncObjects(instance, transfer) != VK_SUCCESS) {
+        ceDestroyTransfer(instance, transfer);
+        return ceResult(CE_ERROR_INTERNAL, "Vk failed to record a transfer");
+    }
+    if(__submitStages(instance, transfer, afterCommand) != VK_SUCCESS) {
+        ceDestroyTransfer(instance, transfer);
+        return ceResult(CE_ERROR_INTERNAL, "Vk failed to submit a transfer");
+    }
+    ceTraceEnd(pReadbackTarget ? "async download" : "async upload", traceBegin);
+    *target = transfer;
+    return CE_SUCCESS;
+}
+
+CeResult
+ceUploadBufferAsync(CeInstance instance, CeBuffer buffer, uint64_t uOffset, const void* pData, uint64_t uSize,
+    CeCommand afterCommand, CeTransfer* transfer) {
+    if(!instance || !buffer || !pData || !transfer)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot upload to buffer: some parameters were NULL");
+    return __startTransfer(instance, buffer, uOffset, pData, NULL, uSize, afterCommand, transfer);
+}
+
+CeResult
+ceDownloadBufferAsync(CeInstance instance, CeBuffer buffer, uint64_t uOffset, void* pData, uint64_t uSize,
+    CeCommand afterCommand, CeTransfer* transfer) {
+    if(!instance || !buffer || !pData || !transfer)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot download from buffer: some parameters were NULL");
+    return __startTransfer(instance, buffer, uOffset, NULL, pData, uSize, afterCommand, transfer);
+}
+
+//copies a completed download to its target, which is harmless to do more than once
+static void __finishTransfer(CeTransfer transfer) {
+    if(atomic_load(&transfer->isFinished))
+        return;
+    if(transfer->pReadbackTarget)
+        memcpy(transfer->pReadbackTarget, transfer->stagingAllocation.mappedData, transfer->size);
+    __releaseStageQueues(transfer);
+}
+
+CeResult
+ceQueryTransfer(CeInstance instance, CeTransfer transfer) {
+    if(!instance || !transfer)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot query transfer: some parameters were NULL");
+    if(atomic_load(&transfer->isFinished))
+        return CE_SUCCESS;
+    VkDevice device = ceGetInstanceVulkanDevice(instance);
+    CeBool32 isDone;
+    if(transfer->timelineSemaphore) {
+        uint64_t value = 0;
+        vkGetSemaphoreCounterValue(device, transfer->timelineSemaphore, &value);
+        isDone = value >= transfer->stageCount;
+    } else {
+        isDone = vkGetFenceStatus(device, transfer->fence) == VK_SUCCESS;
+    }
+    if(!isDone)
+        return CE_NOT_READY;
+    __finishTransfer(transfer);
+    return CE_SUCCESS;
+}
+
+CeResult
+ceWaitTransfer(CeInstance instance, CeTransfer transfer) {
+    if(!instance || !transfer)
+        return ceResult(CE_ERROR_NULL_PASSED, "cannot wait for transfer: some parameters were NULL");
+    if(atomic_load(&transfer->isFinished))
+        return CE_SUCCESS;
+    VkDevice device = ceGetInstanceVulkanDevice(instance);
+    uint64_t traceBegin = ceTraceBegin();
+    VkResult result;
+    if(transfer->timelineSemaphore) {
+        const uint64_t value = transfer->stageCount;
+        VkSemaphoreWaitInfo waitInfo = {
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+            .semaphoreCount = 1,
+            .pSemaphores = &transfer->timelineSemaphore,
+            .pValues = &value,
+        };
+        result = vkWaitSemaphores(device, &waitInfo, ~((uint64_t)0));
+    } else {
+        result = vkWaitForFences(device, 1, &transfer->fence, VK_TRUE, ~((uint64_t)0));
+    }
+    if(result != VK_SUCCESS)
+        return ceResult(CE_ERROR_INTERNAL, "Vk failed to wait for a transfer");
+    ceTraceEnd("ceWaitTransfer", traceBegin);
+    __finishTransfer(transfer);
+    return CE_SUCCESS;
+}
+
+void
+ceGetTransferSemaphore(CeTransfer transfer, VkSemaphore* pSemaphore, uint64_t* pValue) {
+    *pSemaphore = transfer->timelineSemaphore;
+    *pValue = transfer->stageCount;
+}
+
+void
+ceDestroyTransfer(CeInstance instance, CeTransfer transfer) {
+    if(!transfer)
+        return;
+    VkDevice device = ceGetInstanceVulkanDevice(instance);
+    __releaseStageQueues(transfer);
+    for(uint32_t i = 0; i < CE_TRANSFER_MAX_STAGES; ++i)
+        ceFreeCommandBuffer(instance, transfer->stages[i].commandPool, transfer->stages[i].commandBuffer);
+    if(transfer->timelineSemaphore)
+        vkDestroySemaphore(device, transfer->timelineSemaphore, NULL);
+    for(uint32_t i = 0; i < CE_TRANSFER_MAX_STAGES - 1; ++i) {
+        if(transfer->stageSemaphores[i])
+            vkDestroySemaphore(device, transfer->stageSemaphores[i], NULL);
+    }
+    if(transfer->fence)
+        vkDestroyFence(device, transfer->fence, NULL);
+    if(transfer->stagingBuffer)
+        vkDestroyBuffer(device, transfer->stagingBuffer, NULL);
+    if(transfer->stagingAllocation.vulkanMemory)
+        ceArenaFree(instance, ceGetInstanceMemoryArena(instance), &transfer->stagingAllocation);
+    free(transfer);
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "ce-def.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+* Start copying uSize bytes from pData into a buffer at uOffset, on the device's transfer queues.
+* pData is copied before the function returns and can be reused straight away.
+* \param afterCommand if not NULL, the copy starts once the last run of this command completed
+* \param transfer the handle the function writes the started transfer to
+*/
+CeResult
+ceUploadBufferAsync(CeInstance instance, CeBuffer buffer, uint64_t uOffset, const void* pData, uint64_t uSize,
+    CeCommand afterCommand, CeTransfer* transfer);
+
+/**
+* Start copying uSize bytes from a buffer at uOffset into pData, on the device's transfer queues.
+* pData is only written once the transfer is seen completed by ceWaitTransfer or ceQueryTransfer.
+* \param afterCommand if not NULL, the copy starts once the last run of this command completed
+* \param transfer the handle the function writes the started transfer to
+*/
+CeResult
+ceDownloadBufferAsync(CeInstance instance, CeBuffer buffer, uint64_t uOffset, void* pData, uint64_t uSize,
+    CeCommand afterCommand, CeTransfer* transfer);
+
+/**
+* Check whether a transfer completed, without blocking.
+* Returns CE_SUCCESS if it did and CE_NOT_READY if it is still running.
+*/
+CeResult
+ceQueryTransfer(CeInstance instance, CeTransfer transfer);
+
+CeResult
+ceWaitTransfer(CeInstance instance, CeTransfer transfer);
+
+/**
+* Destroy a transfer.
+* The transfer **must** have completed, and so must every command run which waited for it.
+*/
+void
+ceDestroyTransfer(CeInstance instance, CeTransfer transfer);
+
+#ifdef __cplusplus
+}
+#endif
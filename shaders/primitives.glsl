@@ -0,0 +1,127 @@
+/*
+* Shared by the built-in primitive kernels. Elements are 32 bit words whose meaning is picked with specialization
+* constants, so one module serves every type and operation. Built twice: as is, and with CE_SUBGROUPS defined
+* for devices with subgroup arithmetic.
+*/
+#ifdef CE_SUBGROUPS
+#extension GL_KHR_shader_subgroup_basic : require
+#extension GL_KHR_shader_subgroup_arithmetic : require
+#endif
+
+//0 uint, 1 int, 2 float, as CePrimitiveType
+layout(constant_id = 0) const uint CE_TYPE = 0;
+//0 sum, 1 min, 2 max, as CePrimitiveOperation
+layout(constant_id = 1) const uint CE_OPERATION = 0;
+
+#define CE_TILE_THREADS 256
+#define CE_THREAD_ELEMENTS 4
+#define CE_TILE_SIZE (CE_TILE_THREADS * CE_THREAD_ELEMENTS)
+
+layout(local_size_x = CE_TILE_THREADS) in;
+
+shared uint ceShared[CE_TILE_THREADS];
+
+uint ceIdentity() {
+    if(CE_OPERATION == 0)
+        return 0u;
+    //the extremes of the type, infinities for floats
+    if(CE_OPERATION == 1)
+        return CE_TYPE == 0 ? 0xffffffffu : CE_TYPE == 1 ? 0x7fffffffu : 0x7f800000u;
+    return CE_TYPE == 0 ? 0u : CE_TYPE == 1 ? 0x80000000u : 0xff800000u;
+}
+
+uint ceCombine(uint a, uint b) {
+    if(CE_TYPE == 1) {
+        const int x = int(a), y = int(b);
+        return uint(CE_OPERATION == 0 ? x + y : CE_OPERATION == 1 ? min(x, y) : max(x, y));
+    }
+    if(CE_TYPE == 2) {
+        const float x = uintBitsToFloat(a), y = uintBitsToFloat(b);
+        return floatBitsToUint(CE_OPERATION == 0 ? x + y : CE_OPERATION == 1 ? min(x, y) : max(x, y));
+    }
+    return CE_OPERATION == 0 ? a + b : CE_OPERATION == 1 ? min(a, b) : max(a, b);
+}
+
+//whether element first + offset exists, without overflowing past 2^32 elements
+bool ceInRange(uint first, uint offset, uint count) {
+    return first < count && count - first > offset;
+}
+
+#ifdef CE_SUBGROUPS
+uint ceSubgroupReduce(uint v) {
+    if(CE_TYPE == 1) {
+        const int x = int(v);
+        return uint(CE_OPERATION == 0 ? subgroupAdd(x) : CE_OPERATION == 1 ? subgroupMin(x) : subgroupMax(x));
+    }
+    if(CE_TYPE == 2) {
+        const float x = uintBitsToFloat(v);
+        return floatBitsToUint(CE_OPERATION == 0 ? subgroupAdd(x) : CE_OPERATION == 1 ? subgroupMin(x) : subgroupMax(x));
+    }
+    return CE_OPERATION == 0 ? subgroupAdd(v) : CE_OPERATION == 1 ? subgroupMin(v) : subgroupMax(v);
+}
+
+uint ceSubgroupExclusiveScan(uint v) {
+    if(CE_TYPE == 1) {
+        const int x = int(v);
+        return uint(CE_OPERATION == 0 ? subgroupExclusiveAdd(x) : CE_OPERATION == 1 ? subgroupExclusiveMin(x) : subgroupExclusiveMax(x));
+    }
+    if(CE_TYPE == 2) {
+        const float x = uintBitsToFloat(v);
+        return floatBitsToUint(CE_OPERATION == 0 ? subgroupExclusiveAdd(x) : CE_OPERATION == 1 ? subgroupExclusiveMin(x) : subgroupExclusiveMax(x));
+    }
+    return CE_OPERATION == 0 ? subgroupExclusiveAdd(v) : CE_OPERATION == 1 ? subgroupExclusiveMin(v) : subgroupExclusiveMax(v);
+}
+#endif
+
+//the combination of every invocation's value, valid in invocation 0
+uint ceWorkgroupReduce(uint v) {
+#ifdef CE_SUBGROUPS
+    v = ceSubgroupReduce(v);
+    if(subgroupElect())
+        ceShared[gl_SubgroupID] = v;
+    barrier();
+    if(gl_SubgroupID == 0) {
+        //small subgroups leave more partial results than the first subgroup has invocations
+        v = ceIdentity();
+        for(uint i = gl_SubgroupInvocationID; i < gl_NumSubgroups; i += gl_SubgroupSize)
+            v = ceCombine(v, ceShared[i]);
+        v = ceSubgroupReduce(v);
+    }
+    return v;
+#else
+    const uint id = gl_LocalInvocationID.x;
+    ceShared[id] = v;
+    barrier();
+    for(uint stride = CE_TILE_THREADS / 2; stride > 0; stride >>= 1) {
+        if(id < stride)
+            ceShared[id] = ceCombine(ceShared[id], ceShared[id + stride]);
+        barrier();
+    }
+    return ceShared[0];
+#endif
+}
+
+//the combination of the values of every invocation before this one, the identity for invocation 0
+uint ceWorkgroupExclusiveScan(uint v) {
+#ifdef CE_SUBGROUPS
+    const uint exclusive = ceSubgroupExclusiveScan(v);
+    if(gl_SubgroupInvocationID == gl_SubgroupSize - 1)
+        ceShared[gl_SubgroupID] = ceCombine(exclusive, v);
+    barrier();
+    uint prefix = ceIdentity();
+    for(uint i = 0; i < gl_SubgroupID; ++i)
+        prefix = ceCombine(prefix, ceShared[i]);
+    return ceCombine(prefix, exclusive);
+#else
+    const uint id = gl_LocalInvocationID.x;
+    ceShared[id] = v;
+    barrier();
+    for(uint offset = 1; offset < CE_TILE_THREADS; offset <<= 1) {
+        const uint previous = id >= offset ? ceShared[id - offset] : ceIdentity();
+        barrier();
+        ceShared[id] = ceCombine(previous, ceShared[id]);
+        barrier();
+    }
+    return id ? ceShared[id - 1] : ceIdentity();
+#endif
+}
@@ -0,0 +1,62 @@
+/*
+* Shared by the radix sort kernels, included after primitives.glsl. Keys are sorted 8 bits at a time from the least
+* significant digit, each digit taken from a word of the key or from the element's segment id, most significant last.
+*/
+
+//0 uint32, 1 int32, 2 float32, 3 uint64, 4 int64, 5 float64, as CeSortKeyType
+layout(constant_id = 2) const uint CE_SORT_KEY_TYPE = 0;
+layout(constant_id = 3) const uint CE_SORT_HAS_PAYLOAD = 0;
+layout(constant_id = 4) const uint CE_SORT_HAS_SEGMENTS = 0;
+
+const uint CE_SORT_KEY_WORDS = CE_SORT_KEY_TYPE >= 3 ? 2 : 1;
+//the digit word taking the segment id instead of a word of the key
+#define CE_SORT_SEGMENT_WORD 2
+#define CE_SORT_RADIX 256
+
+//64 bit keys are two words, the low one first
+layout(std430, binding = 0) readonly buffer Keys {
+    uint keys[];
+};
+
+//the segment of each element, when sorting segments
+layout(std430, binding = 1) readonly buffer Segments {
+    uint segments[];
+};
+
+layout(push_constant) uniform Constants {
+    uint count;
+    uint tileCount;
+    //the word of the key the digit is taken from, or CE_SORT_SEGMENT_WORD
+    uint digitWord;
+    uint digitShift;
+    uvec3 dispatchBase;
+};
+
+//word of a key, flipped so that the order of the words as unsigned integers is the order of the keys
+uint ceSortKeyWord(uint index, uint word) {
+    if(CE_SORT_KEY_WORDS == 1) {
+        const uint value = keys[index];
+        if(CE_SORT_KEY_TYPE == 1)
+            return value ^ 0x80000000u;
+        if(CE_SORT_KEY_TYPE == 2)
+            return (value & 0x80000000u) != 0 ? ~value : value | 0x80000000u;
+        return value;
+    }
+    uint low = keys[index * 2], high = keys[index * 2 + 1];
+    if(CE_SORT_KEY_TYPE == 4) {
+        high ^= 0x80000000u;
+    } else if(CE_SORT_KEY_TYPE == 5) {
+        if((high & 0x80000000u) != 0) {
+            low = ~low;
+            high = ~high;
+        } else {
+            high |= 0x80000000u;
+        }
+    }
+    return word == 0 ? low : high;
+}
+
+uint ceSortDigit(uint index) {
+    const uint word = digitWord == CE_SORT_SEGMENT_WORD ? segments[index] : ceSortKeyWord(index, digitWord);
+    return (word >> digitShift) & (CE_SORT_RADIX - 1);
+}